@@ -101,13 +101,13 @@ allocator_boundary_tags::allocator_boundary_tags(size_t space_size, allocator *p
 
 [[nodiscard]] void *allocator_boundary_tags::allocate(size_t value_size, size_t values_count) {
     std::lock_guard<std::mutex> mutex_guard(get_mutex());
-    debug_with_guard(get_typename() + " [START] " + "allocation");
+    log_with_guard(logger::severity::debug, "[allocator_boundary_tags] [START] allocation");
 
     auto need_size = value_size * values_count;
 
     if (need_size < sizeof(void*)) {
         need_size = sizeof(void*);
-        warning_with_guard(get_typename() + " size of needed block has changed\n");
+        log_with_guard(logger::severity::warning, "[allocator_boundary_tags] size of needed block has changed\n");
     }
 
     allocator_with_fit_mode::fit_mode fit_mode = get_fit_mode();
@@ -196,7 +196,7 @@ allocator_boundary_tags::allocator_boundary_tags(size_t space_size, allocator *p
     }
 
     if (need_block == nullptr)  {   
-        error_with_guard(get_typename() + " no space to allocate\n");
+        log_with_guard(logger::severity::error, "[allocator_boundary_tags] no space to allocate\n");
         throw std::bad_alloc();
 
     }
@@ -209,7 +209,7 @@ allocator_boundary_tags::allocator_boundary_tags(size_t space_size, allocator *p
     size_t blocks_sizes_difference = prev_size - (need_size + block_meta_size);
     if (blocks_sizes_difference > 0 && blocks_sizes_difference < block_meta_size) {
         need_size += blocks_sizes_difference;
-        warning_with_guard(get_typename() + " size of needed block has changed\n");
+        log_with_guard(logger::severity::warning, "[allocator_boundary_tags] size of needed block has changed\n");
     }
     
     concat_block(need_prev_ptr, need_block);
@@ -220,11 +220,15 @@ allocator_boundary_tags::allocator_boundary_tags(size_t space_size, allocator *p
 
     void * res = reinterpret_cast<unsigned char *>(need_block) + block_meta_size;
 
-    information_with_guard(get_typename() + "   -> Available memory: " + std::to_string(get_available_memory()));
-
-    debug_with_guard(get_blocks_info(get_blocks_info()));
+    // walking the blocks is only worth it when somebody reads the result
+    if (is_enabled_with_guard(logger::severity::information)) {
+        log_with_guard(logger::severity::information, "[allocator_boundary_tags]   -> Available memory: {}", get_available_memory());
+    }
+    if (is_enabled_with_guard(logger::severity::debug)) {
+        debug_with_guard(get_blocks_info(get_blocks_info()));
+    }
 
-    debug_with_guard(get_typename() + " [END] " + "allocation");
+    log_with_guard(logger::severity::debug, "[allocator_boundary_tags] [END] allocation");
     return res;
 }
 
@@ -244,10 +248,11 @@ std::string allocator_boundary_tags::get_block_info(void * block) const noexcept
 }
 
 void allocator_boundary_tags::deallocate(void *at) {
-    debug_with_guard(get_typename() + " [START] " + " deallocation\n");
+    log_with_guard(logger::severity::debug, "[allocator_boundary_tags] [START]  deallocation\n");
 
-    std::string block_info_array = get_block_info(at);
-    debug_with_guard(get_typename() + " " + block_info_array);
+    if (is_enabled_with_guard(logger::severity::debug)) {
+        log_with_guard(logger::severity::debug, "[allocator_boundary_tags] {}", get_block_info(at));
+    }
 
     auto meta = 2 * sizeof(void*) + sizeof(size_t) + sizeof(allocator*);
 
@@ -266,11 +271,14 @@ void allocator_boundary_tags::deallocate(void *at) {
 
     clear_block(block);
 
-    information_with_guard(get_typename() + " Available memory: " + std::to_string(get_available_memory()));
-
-    debug_with_guard(get_blocks_info(get_blocks_info()));
+    if (is_enabled_with_guard(logger::severity::information)) {
+        log_with_guard(logger::severity::information, "[allocator_boundary_tags] Available memory: {}", get_available_memory());
+    }
+    if (is_enabled_with_guard(logger::severity::debug)) {
+        debug_with_guard(get_blocks_info(get_blocks_info()));
+    }
 
-    debug_with_guard(get_typename() + " [END] " + " deallocation\n");
+    log_with_guard(logger::severity::debug, "[allocator_boundary_tags] [END]  deallocation\n");
 }
 
 size_t allocator_boundary_tags::get_available_memory() const noexcept {
@@ -1,6 +1,8 @@
 #ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_BUDDIES_SYSTEM_H
 #define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_BUDDIES_SYSTEM_H
 
+#include <mutex>
+
 #include <allocator_guardant.h>
 #include <allocator_test_utils.h>
 #include <allocator_with_fit_mode.h>
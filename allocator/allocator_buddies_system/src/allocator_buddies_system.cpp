@@ -80,7 +80,7 @@ allocator_buddies_system::allocator_buddies_system(
 
 [[nodiscard]] void *allocator_buddies_system::allocate(size_t value_size, size_t values_count)
 {
-	debug_with_guard(get_typename() + " [Allocation] [Start]");
+	log_with_guard(logger::severity::debug, "allocator_buddies_system [Allocation] [Start]");
 
 	std::lock_guard<std::mutex> lock(get_mutex());
 
@@ -102,7 +102,7 @@ allocator_buddies_system::allocator_buddies_system(
 	}
 
 	if (cur_loaded_block == nullptr) {
-		error_with_guard(get_typename() + "didnt find needed block for  " + std::to_string(block_size) + " bytes");
+		log_with_guard(logger::severity::error, "allocator_buddies_systemdidnt find needed block for  {} bytes", block_size);
 		throw std::bad_alloc();
 	}
 
@@ -117,8 +117,10 @@ allocator_buddies_system::allocator_buddies_system(
 	get_allocator_occupied_block(cur_loaded_block) = this;
 	get_first_byte_of_block(&cur_loaded_block)->occupied = true;
 	left_bytes -= get_size_block(cur_loaded_block);
-	debug_with_guard(get_typename() + " [Allocation] [Finish]");
-	information_with_guard(get_typename() + "current state of blocks: " + get_blocks_info_to_string(get_blocks_info()));
+	log_with_guard(logger::severity::debug, "allocator_buddies_system [Allocation] [Finish]");
+	if (is_enabled_with_guard(logger::severity::information)) {
+		log_with_guard(logger::severity::information, "allocator_buddies_systemcurrent state of blocks: {}", get_blocks_info_to_string(get_blocks_info()));
+	}
 
 	return reinterpret_cast<unsigned char *>(cur_loaded_block) + get_block_occupied_size_of_meta();
 }
@@ -127,15 +129,17 @@ void allocator_buddies_system::deallocate(void *at)
 {
     // locking by mutex
 	std::lock_guard<std::mutex> lock(get_mutex());
-	debug_with_guard(get_typename() + " [Deallocate] [Start]");
+	log_with_guard(logger::severity::debug, "allocator_buddies_system [Deallocate] [Start]");
 
 	block_pointer_t block_ptr = at != _trusted_memory ? reinterpret_cast<unsigned char *>(at) - get_block_occupied_size_of_meta() : get_first_block_by_alloc(), brother = get_brother(block_ptr);
 	if (get_allocator_occupied_block(block_ptr) != this && at != _trusted_memory) {
-		error_with_guard("this block is not from this allocator");
+		log_with_guard(logger::severity::error, "this block is not from this allocator");
 		throw std::logic_error("This block is not from this allocator");
 	}
 
-	debug_with_guard("Block status before deallocation: " + get_dump(reinterpret_cast<char*>(at), get_size_block(block_ptr)));
+	if (is_enabled_with_guard(logger::severity::debug)) {
+		log_with_guard(logger::severity::debug, "Block status before deallocation: {}", get_dump(reinterpret_cast<char*>(at), get_size_block(block_ptr)));
+	}
 	block_size_t size = get_size_block(block_ptr);
 	get_first_byte_of_block(&block_ptr)->occupied = false;
 	if (at != _trusted_memory) {
@@ -149,8 +153,10 @@ void allocator_buddies_system::deallocate(void *at)
 		brother = get_brother(block_ptr);
 	}
 
-	debug_with_guard(get_typename() + " [Deallocate] [Finish]");
-	information_with_guard(get_typename() + " current state of blocks: " + get_blocks_info_to_string(get_blocks_info()));
+	log_with_guard(logger::severity::debug, "allocator_buddies_system [Deallocate] [Finish]");
+	if (is_enabled_with_guard(logger::severity::information)) {
+		log_with_guard(logger::severity::information, "allocator_buddies_system current state of blocks: {}", get_blocks_info_to_string(get_blocks_info()));
+	}
 }
 
 inline allocator_buddies_system::byte_for_occup_and_power_of_size*& allocator_buddies_system::get_first_byte_of_block (block_pointer_t block) const noexcept
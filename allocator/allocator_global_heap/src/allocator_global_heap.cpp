@@ -1,8 +1,9 @@
+#include <utility>
+
 #include "../include/allocator_global_heap.h"
 
-allocator_global_heap::allocator_global_heap(logger *logger) {
+allocator_global_heap::allocator_global_heap(logger *logger) : _logger(logger) {
     trace_with_guard("allocator_global_heap constructor has started\n");
-    _logger = logger;
     trace_with_guard("allocator_global_heap constructor has ended\n");
 }
 
@@ -11,9 +12,8 @@ allocator_global_heap::~allocator_global_heap() {
     trace_with_guard("allocator_global_heap constructor has ended\n");
 }
 
-allocator_global_heap::allocator_global_heap(allocator_global_heap &&other) noexcept {
+allocator_global_heap::allocator_global_heap(allocator_global_heap &&other) noexcept : _logger(std::exchange(other._logger, nullptr)) {
     trace_with_guard("allocator_global_heap move constructor has started\n");
-    _logger = std::exchange(other._logger, nullptr);
     trace_with_guard("allocator_global_heap move constructor has ended\n");
 }
 
@@ -30,14 +30,14 @@ allocator_global_heap &allocator_global_heap::operator=(allocator_global_heap &&
 }
 
 [[nodiscard]] void *allocator_global_heap::allocate(size_t value_size, size_t values_count) {
-    debug_with_guard(get_typename() + " allocation has started");
+    log_with_guard(logger::severity::debug, "allocator_global_heap allocation has started");
     block_size_t block_size = value_size * values_count;
     block_size_t data_size = sizeof(size_t) + sizeof(allocator*);
     block_pointer_t new_block;
     try {
         new_block = ::operator new(block_size + data_size);
     } catch (std::bad_alloc &exception) {
-        error_with_guard(get_typename() + " can`t allocate");
+        log_with_guard(logger::severity::error, "allocator_global_heap can`t allocate");
         throw exception;
     }
 
@@ -46,15 +46,15 @@ allocator_global_heap &allocator_global_heap::operator=(allocator_global_heap &&
     tmp_ptr += sizeof(allocator*);
     *reinterpret_cast<size_t*>(tmp_ptr) = block_size;
     block_pointer_t final_ptr = reinterpret_cast<uint8_t*>(new_block) + data_size;
-    debug_with_guard(get_typename() + " allocation has ended");
+    log_with_guard(logger::severity::debug, "allocator_global_heap allocation has ended");
     return final_ptr;
 }
 
 void allocator_global_heap::deallocate(void *at) {
-    debug_with_guard(get_typename() + " deallocation has started");
+    log_with_guard(logger::severity::debug, "allocator_global_heap deallocation has started");
     if (at == nullptr) {
         //printf("sukaaa\n");
-        debug_with_guard(get_typename() + " deallocation has ended");
+        log_with_guard(logger::severity::debug, "allocator_global_heap deallocation has ended");
         return;
     }
     block_pointer_t block_start_ptr = reinterpret_cast<uint8_t*>(at) - sizeof(allocator*) - sizeof(size_t);
@@ -69,19 +69,21 @@ void allocator_global_heap::deallocate(void *at) {
     }
     
     //debug_with_guard("2");
-    block_size_t block_size = *(reinterpret_cast<uint8_t *>(at) - sizeof(size_t));
-    std::string bytes;
-    int* byte_ptr = reinterpret_cast<int*>(at);
-    //debug_with_guard("3");
-    for (block_size_t i = 0; i < block_size; i++) {
-        bytes += std::to_string(*byte_ptr++);
-        if (i != block_size - 1) bytes += ' ';
+    if (is_enabled_with_guard(logger::severity::debug)) {
+        block_size_t block_size = *reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(at) - sizeof(size_t));
+        std::string bytes;
+        uint8_t* byte_ptr = reinterpret_cast<uint8_t*>(at);
+        //debug_with_guard("3");
+        for (block_size_t i = 0; i < block_size; i++) {
+            log_format::append(bytes, *byte_ptr++);
+            if (i != block_size - 1) bytes += ' ';
+        }
+        //debug_with_guard("4");
+        log_with_guard(logger::severity::debug, "bytes before free: {}", bytes);
     }
-    //debug_with_guard("4");
-    debug_with_guard("bytes before free: " + bytes);
     ::operator delete(block_start_ptr);
     //debug_with_guard("5");
-    debug_with_guard(get_typename() + " deallocation has ended");
+    log_with_guard(logger::severity::debug, "allocator_global_heap deallocation has ended");
 }
 
 inline logger *allocator_global_heap::get_logger() const {
@@ -90,8 +90,10 @@ allocator_red_black_tree::allocator_red_black_tree(
 {
 	std::lock_guard<std::mutex> lock(get_mutex());
 
-	debug_with_guard(get_typename() + " allocating with pool size = " + std::to_string(value_size) + "; values_count = " +
-					 std::to_string(values_count) + "; Now it is having " + std::to_string(get_free_size()) + " bytes");
+	if (is_enabled_with_guard(logger::severity::debug)) {
+		log_with_guard(logger::severity::debug, "allocator_red_black_tree allocating with pool size = {}; values_count = {}; Now it is having {} bytes",
+					   value_size, values_count, get_free_size());
+	}
 
 	size_t need_mem = value_size * values_count;
 
@@ -112,7 +114,7 @@ allocator_red_black_tree::allocator_red_black_tree(
 
 	// if didnt find exact block
 	if(find_new_free_block == nullptr) {
-		error_with_guard(get_typename() + "didnt find block for " + std::to_string(need_mem) + " bytes");
+		log_with_guard(logger::severity::error, "allocator_red_black_treedidnt find block for {} bytes", need_mem);
 		throw std::bad_alloc();
 	}
 
@@ -127,7 +129,7 @@ allocator_red_black_tree::allocator_red_black_tree(
 
 	if (free_block_size < need_mem + get_free_block_size_of_meta()) {
 		need_mem = free_block_size;
-		warning_with_guard("resizing for allocator " + std::to_string(need_mem));
+		log_with_guard(logger::severity::warning, "resizing for allocator {}", need_mem);
 	} else {
 		void* new_free = reinterpret_cast<unsigned char*>(find_new_free_block) + get_occupied_block_size_of_meta() + need_mem;
 
@@ -144,8 +146,10 @@ allocator_red_black_tree::allocator_red_black_tree(
 	}
 
 
-	debug_with_guard("Allocation completed. Allocated memory size: " + std::to_string(need_mem) + " bytes. ");
-	information_with_guard(get_typename() + "current state of blocks: " + get_blocks_info_to_string(get_blocks_info()));
+	log_with_guard(logger::severity::debug, "Allocation completed. Allocated memory size: {} bytes. ", need_mem);
+	if (is_enabled_with_guard(logger::severity::information)) {
+		log_with_guard(logger::severity::information, "allocator_red_black_treecurrent state of blocks: {}", get_blocks_info_to_string(get_blocks_info()));
+	}
 
 	return reinterpret_cast<unsigned char*>(find_new_free_block) + get_occupied_block_size_of_meta();
 }
@@ -155,16 +159,18 @@ void allocator_red_black_tree::deallocate(void *at)
 {
 	std::lock_guard<std::mutex> lock(get_mutex());
 
-	debug_with_guard("Deallocation started " + get_typename());
+	log_with_guard(logger::severity::debug, "Deallocation started allocator_red_black_tree");
 
 	void* block_ptr = reinterpret_cast<unsigned char*>(at) - get_occupied_block_size_of_meta();
 
 	if(get_parent(block_ptr) != _trusted_memory) {
-		error_with_guard("invalid block caught");
+		log_with_guard(logger::severity::error, "invalid block caught");
 		throw std::logic_error("this memory is not from this allocator");
 	}
 
-	debug_with_guard("block before deallocation " + get_dump(reinterpret_cast<char*>(at), get_size_block(block_ptr, _trusted_memory)));
+	if (is_enabled_with_guard(logger::severity::debug)) {
+		log_with_guard(logger::severity::debug, "block before deallocation {}", get_dump(reinterpret_cast<char*>(at), get_size_block(block_ptr, _trusted_memory)));
+	}
 
 	get_byte_occupied_color(block_ptr).is_occupied = false;
 
@@ -195,9 +201,11 @@ void allocator_red_black_tree::deallocate(void *at)
 	//inserting to tree
 	insert_rb_tree(block_ptr);
 
-	trace_with_guard("Deallocation finished!");
-	information_with_guard("AVAIL MEMORY: " + std::to_string(get_free_size()));
-	information_with_guard(get_typename() + " BLOCK STATUS: " + get_blocks_info_to_string(get_blocks_info()));
+	log_with_guard(logger::severity::trace, "Deallocation finished!");
+	if (is_enabled_with_guard(logger::severity::information)) {
+		log_with_guard(logger::severity::information, "AVAIL MEMORY: {}", get_free_size());
+		log_with_guard(logger::severity::information, "allocator_red_black_tree BLOCK STATUS: {}", get_blocks_info_to_string(get_blocks_info()));
+	}
 }
 
 
@@ -96,13 +96,12 @@ allocator_sorted_list::allocator_sorted_list(size_t space_size, allocator *paren
 
 [[nodiscard]] void *allocator_sorted_list::allocate(size_t value_size, size_t values_count) {
     std::lock_guard<std::mutex> mutex_guard(get_mutex());
-    std::string func = "allocation\n";
-    debug_with_guard(get_typename() + " [START] " + func);
+    log_with_guard(logger::severity::debug, "[allocator_sorted_list] [START] allocation\n");
 
     auto req_size = value_size * values_count; // need size
     if (req_size < sizeof(void*)) { // if need size < -> we have to change requested size to min
         req_size = sizeof(void*);
-        warning_with_guard(get_typename() + " size has been changed to sizeof(void*)\n");
+        log_with_guard(logger::severity::warning, "[allocator_sorted_list] size has been changed to sizeof(void*)\n");
     }
     allocator_with_fit_mode::fit_mode fit_mode = get_fit_mode(); // getting fit mode
 
@@ -152,7 +151,7 @@ allocator_sorted_list::allocator_sorted_list(size_t space_size, allocator *paren
         current = get_available_block_next_block_address(current);
     }
     if (block == nullptr) {
-        error_with_guard(get_typename() + " block is empty due a lack of ability to allocate\n");
+        log_with_guard(logger::severity::error, "[allocator_sorted_list] block is empty due a lack of ability to allocate\n");
         throw std::bad_alloc();
     }
     // get difference between current block and requested size from params
@@ -160,7 +159,7 @@ allocator_sorted_list::allocator_sorted_list(size_t space_size, allocator *paren
 
     // if block_difference less than meta size we have to change requested size
     if (blocks_sizes_difference > 0 && blocks_sizes_difference < _meta_size) { 
-        warning_with_guard(get_typename() + " size has been changed\n");
+        log_with_guard(logger::severity::warning, "[allocator_sorted_list] size has been changed\n");
         req_size += blocks_sizes_difference;
         res_size = req_size + _meta_size;
     } else if (blocks_sizes_difference > 0) { // if usual case 
@@ -199,13 +198,14 @@ allocator_sorted_list::allocator_sorted_list(size_t space_size, allocator *paren
     void* res = reinterpret_cast<unsigned char *>(block) + _meta_size;
 
 
-    // get info of blocks
-    std::vector<allocator_test_utils::block_info> blocks_info = get_blocks_info();
-    print_blocks_info(blocks_info);
+    // get info of blocks, only walked when somebody reads it
+    if (is_enabled_with_guard(logger::severity::debug)) {
+        print_blocks_info(get_blocks_info());
+    }
 
-    information_with_guard(get_typename() + " available memory to use: " + std::to_string(available_memory));
+    log_with_guard(logger::severity::information, "[allocator_sorted_list] available memory to use: {}", available_memory);
 
-    debug_with_guard(get_typename() + " [END] " + func);
+    log_with_guard(logger::severity::debug, "[allocator_sorted_list] [END] allocation\n");
     return res;
 }
 
@@ -225,14 +225,12 @@ std::string allocator_sorted_list::get_block_info(void* block) const noexcept {
 
 void allocator_sorted_list::deallocate(void* at) {
     std::lock_guard<std::mutex> mutex_guard(get_mutex());
-    std::string func = "deallocation\n";
-
-    debug_with_guard(get_typename() + " [START] " + func);
-    // getting blocks status
-    std::string block_info_array = get_block_info(at);
 
+    log_with_guard(logger::severity::debug, "[allocator_sorted_list] [START] deallocation\n");
     // debuging blocks status
-    debug_with_guard(get_typename() + "\n" + block_info_array);
+    if (is_enabled_with_guard(logger::severity::debug)) {
+        log_with_guard(logger::severity::debug, "[allocator_sorted_list]\n{}", get_block_info(at));
+    }
 
     size_t _meta_size = sizeof(allocator*) + sizeof(size_t);
     size_t available_memory = 0;
@@ -287,10 +285,11 @@ void allocator_sorted_list::deallocate(void* at) {
         set_first_available_block(block);
 
         // getting blocks info
-        std::vector<allocator_test_utils::block_info> blocks_info = get_blocks_info();
-        print_blocks_info(blocks_info);
+        if (is_enabled_with_guard(logger::severity::debug)) {
+            print_blocks_info(get_blocks_info());
+        }
 
-        debug_with_guard(get_typename() + " [END] " + func);
+        log_with_guard(logger::severity::debug, "[allocator_sorted_list] [END] deallocation\n");
         return;
     }
     // if right is avail
@@ -346,12 +345,13 @@ void allocator_sorted_list::deallocate(void* at) {
     }
     
     // gettign blocks info
-    std::vector<allocator_test_utils::block_info> blocks_info = get_blocks_info();
-    print_blocks_info(blocks_info);
+    if (is_enabled_with_guard(logger::severity::debug)) {
+        print_blocks_info(get_blocks_info());
+    }
 
-    information_with_guard(get_typename() + " Available memory: " + std::to_string(available_memory));
+    log_with_guard(logger::severity::information, "[allocator_sorted_list] Available memory: {}", available_memory);
 
-    debug_with_guard(get_typename() + " [END] " + func);
+    log_with_guard(logger::severity::debug, "[allocator_sorted_list] [END] deallocation\n");
 }
 
 void allocator_sorted_list::print_blocks_info(std::vector<allocator_test_utils::block_info> blocks_info) const noexcept {
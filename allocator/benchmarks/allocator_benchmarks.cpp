@@ -0,0 +1,122 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+
+#include <allocator_boundary_tags.h>
+#include <allocator_global_heap.h>
+#include <allocator_red_black_tree.h>
+#include <allocator_sorted_list.h>
+#include <client_logger_builder.h>
+
+// every heap allocation of the process goes through here and is counted
+std::atomic<size_t> heap_allocations { 0 };
+
+void *operator new(
+    size_t size)
+{
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(
+    void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(
+    void *memory,
+    size_t) noexcept
+{
+    std::free(memory);
+}
+
+constexpr size_t live_blocks = 16;
+
+constexpr size_t block_size = 32;
+
+constexpr size_t rounds = 1000;
+
+// heap allocations per allocate + deallocate pair with live_blocks blocks of block_size bytes
+// allocated and then freed in every round; the first round warms the logger's buffers up
+double allocations_per_pair(
+    allocator &subject)
+{
+    void *blocks[live_blocks];
+    size_t before = 0;
+    for (size_t round = 0; round <= rounds; ++round) {
+        if (round == 1) {
+            before = heap_allocations.load(std::memory_order_relaxed);
+        }
+        for (auto &block : blocks) {
+            block = subject.allocate(block_size, 1);
+        }
+        for (auto &block : blocks) {
+            subject.deallocate(block);
+        }
+    }
+    return static_cast<double>(heap_allocations.load(std::memory_order_relaxed) - before) / (rounds * live_blocks);
+}
+
+// what a call site paid before the variadic log: the messages allocate logs, built with string
+// concatenation and std::to_string whether or not the severity is enabled
+double string_built_allocations_per_pair(
+    logger *target)
+{
+    std::string const type_name = "allocator_sorted_list";
+    size_t before = heap_allocations.load(std::memory_order_relaxed);
+    for (size_t round = 0; round < rounds; ++round) {
+        std::string start = type_name + " [START] " + "allocate";
+        std::string need = type_name + " need memory: " + std::to_string(block_size);
+        std::string end = type_name + " [END] " + "allocate";
+        if (target) {
+            target->debug(start)->debug(need)->debug(end);
+        }
+    }
+    return static_cast<double>(heap_allocations.load(std::memory_order_relaxed) - before) / rounds;
+}
+
+int main()
+{
+    client_logger_builder builder;
+    builder.add_file_stream("/dev/null", logger::severity::information);
+    logger *information_logger = builder.build();
+
+    struct subject
+    {
+        char const *name;
+        std::function<allocator *(logger *)> make;
+    };
+    subject const subjects[] = {
+        { "allocator_sorted_list", [](logger *target) -> allocator * { return new allocator_sorted_list(1 << 16, nullptr, target); } },
+        { "allocator_boundary_tags", [](logger *target) -> allocator * { return new allocator_boundary_tags(1 << 16, nullptr, target); } },
+        { "allocator_red_black_tree", [](logger *target) -> allocator * { return new allocator_red_black_tree(1 << 16, nullptr, target); } },
+        { "allocator_global_heap", [](logger *target) -> allocator * { return new allocator_global_heap(target); } }
+    };
+
+    std::printf("heap allocations per allocate + deallocate pair (%zu live %zu-byte blocks)\n", live_blocks, block_size);
+    std::printf("%-26s %12s %24s\n", "", "no logger", "information client logger");
+    for (auto const &item : subjects) {
+        allocator *without_logger = item.make(nullptr);
+        double without_logger_count = allocations_per_pair(*without_logger);
+        delete without_logger;
+
+        allocator *with_logger = item.make(information_logger);
+        double with_logger_count = allocations_per_pair(*with_logger);
+        delete with_logger;
+
+        std::printf("%-26s %12.1f %24.1f\n", item.name, without_logger_count, with_logger_count);
+    }
+    std::printf("%-26s %12.1f %24.1f\n", "string-built messages", string_built_allocations_per_pair(nullptr),
+        string_built_allocations_per_pair(information_logger));
+
+    delete information_logger;
+
+    return 0;
+}
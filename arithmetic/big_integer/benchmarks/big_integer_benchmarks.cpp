@@ -0,0 +1,328 @@
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <big_integer.h>
+
+using benchmark_clock = std::chrono::steady_clock;
+
+// a positive number of exactly limbs_count limbs
+big_integer random_number(
+    size_t limbs_count,
+    std::mt19937 &generator)
+{
+    std::vector<int> digits(limbs_count);
+    for (auto &digit : digits) {
+        digit = static_cast<int>(generator());
+    }
+    digits.back() = static_cast<int>((generator() & 0x7FFFFFFFu) | 1u);
+    return big_integer(digits);
+}
+
+// seconds per call, repeating the call for at least min_seconds in total
+double measure(
+    std::function<void()> const &call,
+    double min_seconds = 0.2)
+{
+    size_t calls = 0;
+    auto start = benchmark_clock::now();
+    double elapsed;
+    do {
+        call();
+        ++calls;
+        elapsed = std::chrono::duration<double>(benchmark_clock::now() - start).count();
+    } while (elapsed < min_seconds);
+    return elapsed / calls;
+}
+
+// the multiplication trivial_multiplication did before the limb kernel: every product of
+// half-limbs is parsed from a string, shifted and added; positive operands only
+big_integer legacy_multiply(
+    big_integer const &first_multiplier,
+    big_integer const &second_multiplier)
+{
+    int first_size = first_multiplier.get_size();
+    int second_size = second_multiplier.get_size();
+
+    constexpr int shift = sizeof(uint) << 2;
+    constexpr uint mask = (1 << shift) - 1;
+
+    big_integer result(std::vector<int> {0});
+    big_integer multiplication_result(std::vector<int> {0});
+
+    for (auto i = 0; i < first_size; ++i) {
+        uint first_number_low = first_multiplier.get_digit(i) & mask;
+        uint first_number_high = first_multiplier.get_digit(i) >> shift;
+        for (auto j = 0; j < second_size; ++j) {
+            uint second_number_low = second_multiplier.get_digit(j) & mask;
+            uint second_number_high = second_multiplier.get_digit(j) >> shift;
+
+            multiplication_result = big_integer(std::to_string(first_number_low * second_number_low));
+            multiplication_result <<= (shift * (2 * i + 2 * j));
+            result += multiplication_result;
+
+            multiplication_result = big_integer(std::to_string(first_number_low * second_number_high));
+            multiplication_result <<= (shift * (2 * i + 2 * j + 1));
+            result += multiplication_result;
+
+            multiplication_result = big_integer(std::to_string(first_number_high * second_number_low));
+            multiplication_result <<= (shift * (2 * i + 2 * j + 1));
+            result += multiplication_result;
+
+            multiplication_result = big_integer(std::to_string(first_number_high * second_number_high));
+            multiplication_result <<= (shift * (2 * i + 2 * j + 2));
+            result += multiplication_result;
+        }
+    }
+
+    return result;
+}
+
+// the limb kernel against the string-based multiplication it replaced, which takes too long to
+// run beyond legacy_limbs_limit limbs
+void multiplication_benchmarks(
+    size_t legacy_limbs_limit)
+{
+    std::mt19937 generator(2024);
+
+    for (size_t limbs_count : {1, 10, 100, 1000, 10000}) {
+        big_integer first = random_number(limbs_count, generator);
+        big_integer second = random_number(limbs_count, generator);
+        big_integer product(std::vector<int> {0});
+
+        double kernel_seconds = measure([&]() {
+            product = first;
+            big_integer::multiply(product, second, nullptr, big_integer::multiplication_rule::trivial);
+        });
+
+        if (limbs_count > legacy_limbs_limit) {
+            std::printf("limbs=%6zu  schoolbook=%12.3f us  legacy=%12s     speedup=%10s\n",
+                limbs_count, kernel_seconds * 1e6, "-", "-");
+            continue;
+        }
+
+        big_integer legacy_product(std::vector<int> {0});
+        double legacy_seconds = measure([&]() {
+            legacy_product = legacy_multiply(first, second);
+        }, 0);
+
+        std::printf("limbs=%6zu  schoolbook=%12.3f us  legacy=%12.3f us  speedup=%10.1f%s\n",
+            limbs_count, kernel_seconds * 1e6, legacy_seconds * 1e6, legacy_seconds / kernel_seconds,
+            product == legacy_product ? "" : "  (products differ)");
+    }
+}
+
+// the threshold that makes Karatsuba fastest around a few thousand limbs is the one to keep, then
+// Karatsuba against the schoolbook kernel on balanced and unbalanced operands and on squares
+void Karatsuba_benchmarks()
+{
+    std::mt19937 generator(2024);
+    size_t const default_threshold = big_integer::Karatsuba_threshold;
+
+    for (size_t limbs_count : {512, 2048}) {
+        big_integer first = random_number(limbs_count, generator);
+        big_integer second = random_number(limbs_count, generator);
+        big_integer product(std::vector<int> {0});
+
+        for (size_t threshold : {8, 16, 24, 32, 48, 64, 96, 128}) {
+            big_integer::Karatsuba_threshold = threshold;
+            double seconds = measure([&]() {
+                product = first;
+                big_integer::multiply(product, second, nullptr, big_integer::multiplication_rule::Karatsuba);
+            });
+            std::printf("limbs=%6zu  threshold=%4zu  Karatsuba=%12.3f us\n", limbs_count, threshold, seconds * 1e6);
+        }
+    }
+    big_integer::Karatsuba_threshold = default_threshold;
+
+    struct operands_shape
+    {
+        size_t first_limbs;
+        size_t second_limbs;
+        bool square;
+    };
+    for (auto shape : std::initializer_list<operands_shape> {
+        {16, 16, false}, {64, 64, false}, {256, 256, false}, {1000, 1000, false}, {10000, 10000, false},
+        {100, 10000, false}, {1000, 10000, false},
+        {1000, 1000, true}, {10000, 10000, true}}) {
+        big_integer first = random_number(shape.first_limbs, generator);
+        big_integer second = shape.square ? first : random_number(shape.second_limbs, generator);
+        big_integer schoolbook_product(std::vector<int> {0});
+        big_integer Karatsuba_product(std::vector<int> {0});
+
+        double schoolbook_seconds = measure([&]() {
+            schoolbook_product = first;
+            big_integer::multiply(schoolbook_product, shape.square ? schoolbook_product : second, nullptr, big_integer::multiplication_rule::trivial);
+        });
+        double Karatsuba_seconds = measure([&]() {
+            Karatsuba_product = first;
+            big_integer::multiply(Karatsuba_product, shape.square ? Karatsuba_product : second, nullptr, big_integer::multiplication_rule::Karatsuba);
+        });
+
+        std::printf("limbs=%6zu x %-6zu %-7s schoolbook=%12.3f us  Karatsuba=%12.3f us  speedup=%6.2f%s\n",
+            shape.first_limbs, shape.second_limbs, shape.square ? "square" : "", schoolbook_seconds * 1e6, Karatsuba_seconds * 1e6,
+            schoolbook_seconds / Karatsuba_seconds, schoolbook_product == Karatsuba_product ? "" : "  (products differ)");
+    }
+}
+
+// the number-theoretic transforms against the other rules, from where Karatsuba still wins to
+// hundreds of thousands of limbs; schoolbook is left out beyond 16000 limbs
+void Schonhage_Strassen_benchmarks()
+{
+    std::mt19937 generator(2024);
+    size_t crossover = 0;
+
+    for (size_t limbs_count : {250, 500, 1000, 2000, 4000, 8000, 16000, 32000, 64000, 128000, 256000}) {
+        big_integer first = random_number(limbs_count, generator);
+        big_integer second = random_number(limbs_count, generator);
+        big_integer product(std::vector<int> {0});
+
+        auto time_rule = [&](big_integer::multiplication_rule rule)
+        {
+            return measure([&]() {
+                product = first;
+                big_integer::multiply(product, second, nullptr, rule);
+            });
+        };
+
+        double schoolbook_seconds = limbs_count <= 16000 ? time_rule(big_integer::multiplication_rule::trivial) : 0;
+        double Karatsuba_seconds = time_rule(big_integer::multiplication_rule::Karatsuba);
+        big_integer Karatsuba_product = product;
+        big_integer::Schonhage_Strassen_threads = 1;
+        double transform_seconds = time_rule(big_integer::multiplication_rule::SchonhageStrassen);
+        big_integer::Schonhage_Strassen_threads = 3;
+        double threaded_seconds = time_rule(big_integer::multiplication_rule::SchonhageStrassen);
+        big_integer::Schonhage_Strassen_threads = 1;
+
+        if (crossover == 0 && transform_seconds < Karatsuba_seconds) {
+            crossover = limbs_count;
+        }
+
+        std::string schoolbook_time = schoolbook_seconds == 0 ? "-" : std::to_string(schoolbook_seconds * 1e3);
+        std::printf("limbs=%7zu  schoolbook=%12s ms  Karatsuba=%12.3f ms  Schonhage-Strassen=%12.3f ms  3 threads=%12.3f ms%s\n",
+            limbs_count, schoolbook_time.c_str(), Karatsuba_seconds * 1e3, transform_seconds * 1e3, threaded_seconds * 1e3,
+            product == Karatsuba_product ? "" : "  (products differ)");
+    }
+
+    std::printf("Schonhage-Strassen is faster than Karatsuba from %zu limbs\n", crossover);
+}
+
+// Newton division of a dividend twice the divisor's length under each multiplication rule: cold
+// alternates two divisors so every division computes its reciprocal, cached divides by one;
+// schoolbook products are left out from 1M bits, the trivial division beyond 10k bits
+void Newton_benchmarks()
+{
+    std::mt19937 generator(2024);
+
+    for (size_t bits : {1000, 10000, 100000, 1000000}) {
+        size_t const limbs_count = (bits + 31) / 32;
+        big_integer dividend = random_number(2 * limbs_count, generator);
+        big_integer divisors[] = {random_number(limbs_count, generator), random_number(limbs_count, generator)};
+        big_integer quotient(std::vector<int> {0});
+
+        if (bits <= 10000) {
+            double trivial_seconds = measure([&]() {
+                quotient = dividend;
+                big_integer::divide(quotient, divisors[0], nullptr, big_integer::division_rule::trivial);
+            }, 0);
+            std::printf("bits=%8zu  trivial division=%12.3f ms\n", bits, trivial_seconds * 1e3);
+        }
+
+        big_integer expected(std::vector<int> {0});
+        for (auto rule : {big_integer::multiplication_rule::trivial, big_integer::multiplication_rule::Karatsuba,
+            big_integer::multiplication_rule::SchonhageStrassen}) {
+            if (rule == big_integer::multiplication_rule::trivial && bits >= 1000000) {
+                continue;
+            }
+
+            size_t calls = 0;
+            double cold_seconds = measure([&]() {
+                quotient = dividend;
+                big_integer::divide(quotient, divisors[calls++ % 2], nullptr, big_integer::division_rule::Newton, rule);
+            });
+            double cached_seconds = measure([&]() {
+                quotient = dividend;
+                big_integer::divide(quotient, divisors[0], nullptr, big_integer::division_rule::Newton, rule);
+            });
+            if (rule == big_integer::multiplication_rule::Karatsuba) {
+                expected = quotient;
+            }
+
+            char const *rule_name = rule == big_integer::multiplication_rule::trivial
+                ? "trivial"
+                : rule == big_integer::multiplication_rule::Karatsuba ? "Karatsuba" : "Schonhage-Strassen";
+            std::printf("bits=%8zu  %-18s Newton cold=%12.3f ms  cached=%12.3f ms%s\n", bits, rule_name,
+                cold_seconds * 1e3, cached_seconds * 1e3,
+                expected.is_zero() || quotient == expected ? "" : "  (quotients differ)");
+        }
+    }
+}
+
+// Burnikel-Ziegler against the schoolbook and Newton divisions, all multiplying by Karatsuba, on
+// dividends twice the divisor's length; divmod against divide and modulo called apart
+void Burnikel_Ziegler_benchmarks()
+{
+    std::mt19937 generator(2024);
+    auto const rule = big_integer::multiplication_rule::Karatsuba;
+
+    for (size_t limbs_count : {50, 100, 200, 500, 1000, 2000, 5000, 10000}) {
+        big_integer dividend = random_number(2 * limbs_count, generator);
+        big_integer divisors[] = {random_number(limbs_count, generator), random_number(limbs_count, generator)};
+        std::pair<big_integer, big_integer> results {big_integer(std::vector<int> {0}), big_integer(std::vector<int> {0})};
+
+        auto time_rule = [&](big_integer::division_rule division_rule)
+        {
+            size_t calls = 0;
+            return measure([&]() {
+                results = big_integer::divmod(dividend, divisors[calls++ % 2], nullptr, division_rule, rule);
+            });
+        };
+
+        double schoolbook_seconds = time_rule(big_integer::division_rule::trivial);
+        double Newton_seconds = time_rule(big_integer::division_rule::Newton);
+        double Burnikel_Ziegler_seconds = time_rule(big_integer::division_rule::BurnikelZiegler);
+        bool same = big_integer::divmod(dividend, divisors[0], nullptr, big_integer::division_rule::trivial, rule)
+            == big_integer::divmod(dividend, divisors[0], nullptr, big_integer::division_rule::BurnikelZiegler, rule);
+
+        big_integer quotient(std::vector<int> {0});
+        big_integer remainder(std::vector<int> {0});
+        double apart_seconds = measure([&]() {
+            quotient = dividend;
+            remainder = dividend;
+            big_integer::divide(quotient, divisors[0], nullptr, big_integer::division_rule::BurnikelZiegler, rule);
+            big_integer::modulo(remainder, divisors[0], nullptr, big_integer::division_rule::BurnikelZiegler, rule);
+        });
+
+        std::printf("limbs=%6zu  schoolbook=%10.3f ms  Newton=%10.3f ms  Burnikel-Ziegler=%10.3f ms  divide+modulo=%10.3f ms%s\n",
+            limbs_count, schoolbook_seconds * 1e3, Newton_seconds * 1e3, Burnikel_Ziegler_seconds * 1e3, apart_seconds * 1e3,
+            same ? "" : "  (results differ)");
+    }
+}
+
+int main(
+    int argc,
+    char *argv[])
+{
+    std::string selected = argc > 1 ? argv[1] : "all";
+
+    if (selected == "all" || selected == "multiplication") {
+        multiplication_benchmarks(argc > 2 ? std::stoul(argv[2]) : 100);
+    }
+    if (selected == "all" || selected == "Karatsuba") {
+        Karatsuba_benchmarks();
+    }
+    if (selected == "all" || selected == "Schonhage_Strassen") {
+        Schonhage_Strassen_benchmarks();
+    }
+    if (selected == "all" || selected == "Newton") {
+        Newton_benchmarks();
+    }
+    if (selected == "all" || selected == "Burnikel_Ziegler") {
+        Burnikel_Ziegler_benchmarks();
+    }
+
+    return 0;
+}
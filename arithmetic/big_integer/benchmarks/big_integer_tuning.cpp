@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include <big_integer.h>
+
+using tuning_clock = std::chrono::steady_clock;
+
+// a positive number of exactly limbs_count limbs
+big_integer random_number(
+    size_t limbs_count,
+    std::mt19937 &generator)
+{
+    std::vector<int> digits(limbs_count);
+    for (auto &digit : digits) {
+        digit = static_cast<int>(generator());
+    }
+    digits.back() = static_cast<int>((generator() & 0x7FFFFFFFu) | 1u);
+    return big_integer(digits);
+}
+
+// seconds per call, the best of three rounds of at least min_seconds each
+double measure(
+    std::function<void()> const &call,
+    double min_seconds = 0.05)
+{
+    double best = 0;
+    for (int round = 0; round < 3; ++round) {
+        size_t calls = 0;
+        auto start = tuning_clock::now();
+        double elapsed;
+        do {
+            call();
+            ++calls;
+            elapsed = std::chrono::duration<double>(tuning_clock::now() - start).count();
+        } while (elapsed < min_seconds);
+        best = round == 0 ? elapsed / calls : std::min(best, elapsed / calls);
+    }
+    return best;
+}
+
+// the least size from which challenger is faster than incumbent at every larger size measured,
+// twice the largest size if it is slower there
+size_t crossover(
+    char const *name,
+    std::vector<size_t> const &sizes,
+    std::function<double(size_t)> const &incumbent,
+    std::function<double(size_t)> const &challenger)
+{
+    size_t threshold = 2 * sizes.back();
+    for (auto size = sizes.rbegin(); size != sizes.rend(); ++size) {
+        double incumbent_seconds = incumbent(*size);
+        double challenger_seconds = challenger(*size);
+        std::printf("%s  limbs=%7zu  %12.3f ms against %12.3f ms\n", name, *size, challenger_seconds * 1e3, incumbent_seconds * 1e3);
+        if (challenger_seconds >= incumbent_seconds) {
+            break;
+        }
+        threshold = *size;
+    }
+    return threshold;
+}
+
+double multiplication_seconds(
+    size_t limbs_count,
+    big_integer::multiplication_rule rule)
+{
+    std::mt19937 generator(limbs_count);
+    big_integer first = random_number(limbs_count, generator);
+    big_integer second = random_number(limbs_count, generator);
+    big_integer product(std::vector<int> {0});
+    return measure([&]() {
+        product = first;
+        big_integer::multiply(product, second, nullptr, rule);
+    });
+}
+
+// dividends twice the divisor's length, divisors alternating so no reciprocal is reused
+double division_seconds(
+    size_t limbs_count,
+    big_integer::division_rule rule)
+{
+    std::mt19937 generator(limbs_count);
+    big_integer dividend = random_number(2 * limbs_count, generator);
+    big_integer divisors[] = {random_number(limbs_count, generator), random_number(limbs_count, generator)};
+    size_t calls = 0;
+    return measure([&]() {
+        big_integer::divmod(dividend, divisors[calls++ % 2], nullptr, rule, big_integer::multiplication_rule::automatic);
+    });
+}
+
+// measures the thresholds of the automatic rules on this host, every one with the ones found
+// before it in place, and writes them where big_integer::configure_thresholds reads them:
+// the "big_integer" object of the json file given (big_integer_thresholds.json by default)
+int main(
+    int argc,
+    char *argv[])
+{
+    std::string configuration_file_path = argc > 1 ? argv[1] : "big_integer_thresholds.json";
+
+    size_t best_threshold = big_integer::Karatsuba_threshold;
+    double best_seconds = 0;
+    for (size_t threshold : {8, 16, 24, 32, 48, 64, 96, 128}) {
+        big_integer::Karatsuba_threshold = threshold;
+        double seconds = multiplication_seconds(600, big_integer::multiplication_rule::Karatsuba)
+            + multiplication_seconds(2400, big_integer::multiplication_rule::Karatsuba) / 4;
+        std::printf("Karatsuba_threshold=%4zu  %12.3f ms\n", threshold, seconds * 1e3);
+        if (best_seconds == 0 || seconds < best_seconds) {
+            best_seconds = seconds;
+            best_threshold = threshold;
+        }
+    }
+    big_integer::Karatsuba_threshold = best_threshold;
+
+    size_t const hardware_threads = std::thread::hardware_concurrency();
+    if (hardware_threads > 1) {
+        big_integer::Schonhage_Strassen_threads = 1;
+        double single_seconds = multiplication_seconds(64000, big_integer::multiplication_rule::SchonhageStrassen);
+        big_integer::Schonhage_Strassen_threads = std::min<size_t>(3, hardware_threads);
+        double threaded_seconds = multiplication_seconds(64000, big_integer::multiplication_rule::SchonhageStrassen);
+        std::printf("Schonhage_Strassen_threads=%zu  %12.3f ms against %12.3f ms\n",
+            big_integer::Schonhage_Strassen_threads, threaded_seconds * 1e3, single_seconds * 1e3);
+        if (threaded_seconds >= single_seconds) {
+            big_integer::Schonhage_Strassen_threads = 1;
+        }
+    }
+
+    big_integer::Schonhage_Strassen_threshold = crossover("Schonhage_Strassen_threshold",
+        {1000, 2000, 4000, 8000, 16000, 32000, 64000},
+        [](size_t size) { return multiplication_seconds(size, big_integer::multiplication_rule::Karatsuba); },
+        [](size_t size) { return multiplication_seconds(size, big_integer::multiplication_rule::SchonhageStrassen); });
+
+    big_integer::Burnikel_Ziegler_threshold = crossover("Burnikel_Ziegler_threshold",
+        {20, 40, 60, 80, 120, 160, 240, 320, 480, 640},
+        [](size_t size) { return division_seconds(size, big_integer::division_rule::trivial); },
+        [](size_t size) { return division_seconds(size, big_integer::division_rule::BurnikelZiegler); });
+
+    big_integer::Newton_threshold = crossover("Newton_threshold",
+        {2000, 4000, 8000, 16000, 32000, 64000},
+        [](size_t size) { return division_seconds(size, big_integer::division_rule::BurnikelZiegler); },
+        [](size_t size) { return division_seconds(size, big_integer::division_rule::Newton); });
+
+    nlohmann::json configuration;
+    configuration["big_integer"] = {
+        {"Karatsuba_threshold", big_integer::Karatsuba_threshold},
+        {"Schonhage_Strassen_threads", big_integer::Schonhage_Strassen_threads},
+        {"Schonhage_Strassen_threshold", big_integer::Schonhage_Strassen_threshold},
+        {"Burnikel_Ziegler_threshold", big_integer::Burnikel_Ziegler_threshold},
+        {"Newton_threshold", big_integer::Newton_threshold}
+    };
+
+    std::ofstream configuration_file(configuration_file_path);
+    if (!configuration_file.is_open()) {
+        std::fprintf(stderr, "Can't open %s\n", configuration_file_path.c_str());
+        return 1;
+    }
+    configuration_file << configuration.dump(4) << std::endl;
+    std::printf("%s\n", configuration.dump(4).c_str());
+
+    return 0;
+}
@@ -22,7 +22,9 @@ public:
     {
         trivial,
         Karatsuba,
-        SchonhageStrassen
+        SchonhageStrassen,
+        // by the sizes of the operands against the thresholds below
+        automatic
     };
 
 private:
@@ -73,13 +75,27 @@ private:
         
     };
 
+    class automatic_multiplication final:
+        public multiplication
+    {
+
+    public:
+
+        big_integer &multiply(
+            big_integer &first_multiplier,
+            big_integer const &second_multiplier) const override;
+
+    };
+
 public:
     
     enum class division_rule
     {
         trivial,
         Newton,
-        BurnikelZiegler
+        BurnikelZiegler,
+        // by the size of the divisor against the thresholds below
+        automatic
     };
 
 private:
@@ -158,6 +174,24 @@ private:
         
     };
 
+    class automatic_division final:
+        public division
+    {
+
+    public:
+
+        big_integer &divide(
+            big_integer &dividend,
+            big_integer const &divisor,
+            big_integer::multiplication_rule multiplication_rule) const override;
+
+        big_integer &modulo(
+            big_integer &dividend,
+            big_integer const &divisor,
+            big_integer::multiplication_rule multiplication_rule) const override;
+
+    };
+
 private:
 
     int _oldest_digit;
@@ -285,6 +319,7 @@ public:
 
 public:
 
+    // the product takes memory from the first multiplier's allocator, allocator is not used
     static big_integer &multiply(
         big_integer &first_multiplier,
         big_integer const &second_multiplier,
@@ -297,6 +332,7 @@ public:
         allocator *allocator = nullptr,
         big_integer::multiplication_rule multiplication_rule = big_integer::multiplication_rule::trivial);
 
+    // the quotient and the remainder take memory from the dividend's allocator, allocator is not used
     static big_integer &divide(
         big_integer &dividend,
         big_integer const &divisor,
@@ -325,6 +361,15 @@ public:
         big_integer::division_rule division_rule = big_integer::division_rule::trivial,
         big_integer::multiplication_rule multiplication_rule = big_integer::multiplication_rule::trivial);
 
+    // quotient, truncated towards zero, and remainder, with the sign of the dividend, out of one
+    // division; both take memory from allocator. The trivial rule divides by the schoolbook algorithm
+    static std::pair<big_integer, big_integer> divmod(
+        big_integer const &dividend,
+        big_integer const &divisor,
+        allocator *allocator = nullptr,
+        big_integer::division_rule division_rule = big_integer::division_rule::trivial,
+        big_integer::multiplication_rule multiplication_rule = big_integer::multiplication_rule::trivial);
+
 public:
     
     friend std::ostream &operator<<(std::ostream &stream, big_integer const &value);
@@ -335,19 +380,43 @@ public:
 
     size_t default_base = 1 << (8 * sizeof(int) - 1);
 
+    // Karatsuba multiplication hands operands shorter than this many limbs to the schoolbook
+    // kernel; set it before multiplications start (benchmarks tune it), 4 is the least it takes
+    static inline size_t Karatsuba_threshold = 32;
+
+    // threads the Schonhage-Strassen multiplication runs its transforms and pointwise products
+    // on, the calling one included; up to one per prime (three) are of use
+    static inline size_t Schonhage_Strassen_threads = 1;
+
+    // automatic multiplication transforms when the shorter operand has at least this many limbs,
+    // Karatsuba takes the rest
+    static inline size_t Schonhage_Strassen_threshold = 12000;
+
+    // automatic division recurses by Burnikel-Ziegler from divisors of this many limbs and
+    // switches to Newton's reciprocals from Newton_threshold, below both it is schoolbook
+    static inline size_t Burnikel_Ziegler_threshold = 200;
+
+    static inline size_t Newton_threshold = 64000;
+
+    // sets the thresholds and Schonhage_Strassen_threads found in the configuration_path object of
+    // a json configuration file, as the tuning executable writes it; those left out keep their values
+    static void configure_thresholds(
+        std::string const &configuration_file_path,
+        std::string const &configuration_path = "big_integer");
+
 private:
 
     [[nodiscard]] allocator *get_allocator() const noexcept override;
 
 public:
 
-    inline int sign() const noexcept;
+    int sign() const noexcept;
 
-    inline bool is_zero() const noexcept;
+    bool is_zero() const noexcept;
 
-    inline unsigned int get_digit(int index) const noexcept;
+    unsigned int get_digit(int index) const noexcept;
 
-    inline int get_size() const noexcept;
+    int get_size() const noexcept;
 
     big_integer &change_sign();
 
@@ -379,6 +448,56 @@ private:
 
     int big_int_cmp(big_integer const & first, big_integer const & second) const;
     inline unsigned int get_digit_big_endian(int position) const noexcept;
+
+    // limbs of the absolute value, least significant first, get_size() of them
+    void magnitude_to(unsigned int *limbs) const noexcept;
+
+    // takes digits, allocated by this number's allocator, as its storage: the limbs of the absolute
+    // value are at digits + 1, digits[0] is filled in; zero limbs on top are dropped
+    big_integer &adopt_magnitude(unsigned int *digits, size_t limbs_count, bool negative) noexcept;
+
+    // kernels multiply absolute values given by their limbs into first_size + second_size limbs of
+    // product, with scratch_limbs(first_size, second_size) limbs of scratch
+    using limbs_multiplication = void (*)(
+        unsigned int const *first,
+        size_t first_size,
+        unsigned int const *second,
+        size_t second_size,
+        unsigned int *product,
+        unsigned int *scratch);
+
+    using scratch_size = size_t (*)(size_t first_size, size_t second_size);
+
+    // takes the product of this number and other as its value, all memory comes from this number's allocator
+    big_integer &multiply_magnitudes(big_integer const &other, limbs_multiplication multiply_limbs, scratch_size scratch_limbs);
+
+    // kernels divide absolute values given by their limbs, divisor_size <= numerator_size and the
+    // top limb of divisor not zero, into numerator_size - divisor_size + 1 limbs of quotient and
+    // divisor_size limbs of remainder, multiplying by rule, with
+    // scratch_limbs(numerator_size, divisor_size, rule) limbs of scratch
+    using limbs_division = void (*)(
+        unsigned int const *numerator,
+        size_t numerator_size,
+        unsigned int const *divisor,
+        size_t divisor_size,
+        unsigned int *quotient,
+        unsigned int *remainder,
+        unsigned int *scratch,
+        multiplication_rule rule);
+
+    using division_scratch_size = size_t (*)(size_t numerator_size, size_t divisor_size, multiplication_rule rule);
+
+    // quotient, truncated towards zero, and remainder, with the sign of the dividend, of dividend
+    // and divisor; either may be null or one of the operands, each takes memory from its own
+    // allocator, the scratch comes from the dividend's
+    static void divide_magnitudes(
+        big_integer const &dividend,
+        big_integer const &divisor,
+        big_integer *quotient,
+        big_integer *remainder,
+        limbs_division divide_limbs,
+        division_scratch_size scratch_limbs,
+        multiplication_rule rule);
 };
 
 #endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_BIGINT_H
\ No newline at end of file
@@ -1,5 +1,13 @@
 #include "../include/big_integer.h"
+#include <atomic>
+#include <bit>
 #include <cstdint>
+#include <fstream>
+#include <functional>
+#include <system_error>
+#include <thread>
+
+#include <nlohmann/json.hpp>
 #define MAX_VAL_BASE 4294967296
 
 // summ strings
@@ -161,7 +169,8 @@ std::string big_integer::big_integer_to_string(big_integer const & value) const
         return res;
     }
     int size = value.get_size();
-    uint i;
+    // power of the base the oldest digit stands at
+    uint top = size - 1;
     for (uint i = 1; i < size; ++i) {
         res = string_add(res, string_mult(std::to_string(value._other_digits[i]), string_pow(i - 1, std::to_string(MAX_VAL_BASE))));
     }
@@ -170,10 +179,10 @@ std::string big_integer::big_integer_to_string(big_integer const & value) const
         int tmp = value._oldest_digit;
         tmp = tmp ^ (1 << ((sizeof(int) << 3) - 1));
         std::string mystr = std::to_string(tmp);
-        res = string_add(res, string_mult(mystr, string_pow(i - 1, std::to_string(MAX_VAL_BASE))));
+        res = string_add(res, string_mult(mystr, string_pow(top, std::to_string(MAX_VAL_BASE))));
         res = "-" + res;
     } else {
-        res = string_add(res, string_mult(std::to_string(value._oldest_digit), string_pow(i - 1, std::to_string(MAX_VAL_BASE))));
+        res = string_add(res, string_mult(std::to_string(value._oldest_digit), string_pow(top, std::to_string(MAX_VAL_BASE))));
     }
     return res;
 }
@@ -236,89 +245,742 @@ std::string big_integer::string_to_decimal(const std::string& number, int base)
     return result;
 }
 
+namespace
+{
+
+// result gets first_size + second_size limbs and must not overlap the operands
+void schoolbook_multiply(
+    uint const *first,
+    size_t first_size,
+    uint const *second,
+    size_t second_size,
+    uint *result) noexcept
+{
+    // the longer operand goes to the inner loop
+    if (first_size > second_size) {
+        std::swap(first, second);
+        std::swap(first_size, second_size);
+    }
+    std::fill(result, result + first_size + second_size, 0u);
+
+    for (size_t i = 0; i < first_size; ++i) {
+        uint64_t multiplier = first[i];
+        if (multiplier == 0) {
+            continue;
+        }
+        uint64_t carry = 0;
+        for (size_t j = 0; j < second_size; ++j) {
+            // (2^32 - 1)^2 + 2 * (2^32 - 1) is 2^64 - 1, so nothing is lost
+            carry += multiplier * second[j] + result[i + j];
+            result[i + j] = static_cast<uint>(carry);
+            carry >>= 32;
+        }
+        result[i + second_size] = static_cast<uint>(carry);
+    }
+}
+
+size_t significant_limbs(
+    uint const *limbs,
+    size_t limbs_count) noexcept
+{
+    while (limbs_count > 1 && limbs[limbs_count - 1] == 0) {
+        --limbs_count;
+    }
+    return limbs_count;
+}
+
+void schoolbook_kernel(
+    uint const *first,
+    size_t first_size,
+    uint const *second,
+    size_t second_size,
+    uint *product,
+    uint *) noexcept
+{
+    schoolbook_multiply(first, first_size, second, second_size, product);
+}
+
+size_t no_scratch(
+    size_t,
+    size_t) noexcept
+{
+    return 0;
+}
+
+}
+
 big_integer &big_integer::trivial_multiplication::multiply(
     big_integer &first_multiplier,
     big_integer const &second_multiplier) const
 {
-    if (second_multiplier.is_zero()) {
-        return first_multiplier = second_multiplier;
+    return first_multiplier.multiply_magnitudes(second_multiplier, schoolbook_kernel, no_scratch);
+}
+
+namespace
+{
+
+// target += addend, addend_size <= target_size; returns the carry out of target
+uint add_limbs(
+    uint *target,
+    size_t target_size,
+    uint const *addend,
+    size_t addend_size) noexcept
+{
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < addend_size; ++i) {
+        carry += static_cast<uint64_t>(target[i]) + addend[i];
+        target[i] = static_cast<uint>(carry);
+        carry >>= 32;
     }
-    if (first_multiplier.is_zero()) {
-        return first_multiplier;
+    for (; carry != 0 && i < target_size; ++i) {
+        carry += target[i];
+        target[i] = static_cast<uint>(carry);
+        carry >>= 32;
     }
-    bool negative = false;
+    return static_cast<uint>(carry);
+}
+
+// target -= subtrahend, subtrahend_size <= target_size; returns the borrow out of target, which
+// is then left with the difference modulo B^target_size
+uint subtract_limbs(
+    uint *target,
+    size_t target_size,
+    uint const *subtrahend,
+    size_t subtrahend_size) noexcept
+{
+    uint borrow = 0;
+    size_t i = 0;
+    for (; i < subtrahend_size; ++i) {
+        uint64_t difference = static_cast<uint64_t>(target[i]) - subtrahend[i] - borrow;
+        target[i] = static_cast<uint>(difference);
+        borrow = static_cast<uint>(difference >> 63);
+    }
+    for (; borrow != 0 && i < target_size; ++i) {
+        borrow = target[i] == 0;
+        --target[i];
+    }
+    return borrow;
+}
 
-    if (first_multiplier.sign() < 0) {
-        first_multiplier.change_sign();
-        if (second_multiplier.sign() < 0) {
-            first_multiplier *= -second_multiplier;
-            return first_multiplier;
+// every product of two different limbs is computed once and doubled, then the squares of the
+// limbs are added; product gets 2 * size limbs
+void schoolbook_square(
+    uint const *value,
+    size_t size,
+    uint *product) noexcept
+{
+    std::fill(product, product + 2 * size, 0u);
+
+    for (size_t i = 0; i < size; ++i) {
+        uint64_t multiplier = value[i];
+        uint64_t carry = 0;
+        for (size_t j = i + 1; j < size; ++j) {
+            carry += multiplier * value[j] + product[i + j];
+            product[i + j] = static_cast<uint>(carry);
+            carry >>= 32;
         }
-        negative = true;
+        product[i + size] = static_cast<uint>(carry);
     }
-    if (second_multiplier.sign() < 0) {
-        first_multiplier *= -second_multiplier;
-        first_multiplier.change_sign();
-        return first_multiplier;
+
+    // the doubled sum is less than the square, its top bit is free
+    uint shifted_out = 0;
+    for (size_t i = 0; i < 2 * size; ++i) {
+        uint limb = product[i];
+        product[i] = (limb << 1) | shifted_out;
+        shifted_out = limb >> 31;
     }
 
-    int first_size = first_multiplier.get_size();
-    int second_size = second_multiplier.get_size();
-    
-    constexpr int shift = sizeof(uint) << 2;
-    constexpr uint mask = (1 << shift) - 1;
-
-    big_integer result(std::vector<int> {0});
-    big_integer multiplication_result(std::vector<int> {0});
-
-    // multiplying by O(n^2)
-    for (auto i = 0; i < first_size; ++i) {
-        uint first_number_low = first_multiplier.get_digit(i) & mask;
-        uint first_number_high = first_multiplier.get_digit(i) >> shift;
-        for (auto j = 0; j < second_size; ++j) {
-            uint second_number_low = second_multiplier.get_digit(j) & mask;
-            uint second_number_high = second_multiplier.get_digit(j) >> shift;
-
-            multiplication_result = big_integer(std::to_string(first_number_low * second_number_low));
-            multiplication_result <<= (shift * (2 * i + 2 * j));
-            result += multiplication_result;
-
-            multiplication_result = big_integer(std::to_string(first_number_low * second_number_high));
-            multiplication_result <<= (shift * (2 * i + 2 * j + 1));
-            result += multiplication_result;
-
-            multiplication_result = big_integer(std::to_string(first_number_high * second_number_low));
-            multiplication_result <<= (shift * (2 * i + 2 * j + 1));
-            result += multiplication_result;
-
-            multiplication_result = big_integer(std::to_string(first_number_high * second_number_high));
-            multiplication_result <<= (shift * (2 * i + 2 * j + 2));
-            result += multiplication_result;
+    uint64_t carry = 0;
+    for (size_t i = 0; i < size; ++i) {
+        uint64_t square = static_cast<uint64_t>(value[i]) * value[i];
+        carry += static_cast<uint64_t>(product[2 * i]) + static_cast<uint>(square);
+        product[2 * i] = static_cast<uint>(carry);
+        carry >>= 32;
+        carry += static_cast<uint64_t>(product[2 * i + 1]) + (square >> 32);
+        product[2 * i + 1] = static_cast<uint>(carry);
+        carry >>= 32;
+    }
+}
+
+// halves of 3 limbs would be cut into halves of 3 limbs again
+size_t karatsuba_threshold() noexcept
+{
+    return std::max<size_t>(big_integer::Karatsuba_threshold, 4);
+}
+
+// scratch limbs for operands of at most size limbs; the balanced split takes the most, two sums
+// of half + 1 limbs and their product, then what multiplying the sums takes
+size_t karatsuba_scratch_size(
+    size_t size) noexcept
+{
+    size_t const threshold = karatsuba_threshold();
+    size_t limbs = 0;
+    while (size >= threshold) {
+        size_t const half = (size + 1) / 2;
+        limbs += 4 * (half + 1);
+        size = half + 1;
+    }
+    return limbs;
+}
+
+// (first_high * B^half + first_low) * (second_high * B^half + second_low) takes three products
+// of halves: low * low, high * high and (first_low + first_high) * (second_low + second_high),
+// which less the other two is the middle term
+void karatsuba_multiply(
+    uint const *first,
+    size_t first_size,
+    uint const *second,
+    size_t second_size,
+    uint *product,
+    uint *scratch) noexcept
+{
+    if (first_size < second_size) {
+        std::swap(first, second);
+        std::swap(first_size, second_size);
+    }
+    if (second_size < karatsuba_threshold()) {
+        schoolbook_multiply(first, first_size, second, second_size, product);
+        return;
+    }
+
+    size_t const product_size = first_size + second_size;
+    size_t const half = (first_size + 1) / 2;
+
+    // second has no high half: first is cut into pieces the size of second, each piece makes
+    // a balanced product
+    if (second_size <= half) {
+        uint *piece_product = scratch;
+        std::fill(product, product + product_size, 0u);
+        for (size_t offset = 0; offset < first_size; offset += second_size) {
+            size_t const piece_size = std::min(second_size, first_size - offset);
+            karatsuba_multiply(first + offset, piece_size, second, second_size, piece_product, scratch + 2 * second_size);
+            add_limbs(product + offset, product_size - offset, piece_product, piece_size + second_size);
         }
+        return;
     }
-    
-    first_multiplier = std::move(result);
 
-    if (negative) {
-        first_multiplier.change_sign();
+    karatsuba_multiply(first, half, second, half, product, scratch);
+    karatsuba_multiply(first + half, first_size - half, second + half, second_size - half, product + 2 * half, scratch);
+
+    uint *first_sum = scratch;
+    uint *second_sum = first_sum + half + 1;
+    uint *middle = second_sum + half + 1;
+    std::copy(first, first + half, first_sum);
+    first_sum[half] = add_limbs(first_sum, half, first + half, first_size - half);
+    std::copy(second, second + half, second_sum);
+    second_sum[half] = add_limbs(second_sum, half, second + half, second_size - half);
+
+    karatsuba_multiply(first_sum, half + 1, second_sum, half + 1, middle, middle + 2 * (half + 1));
+    subtract_limbs(middle, 2 * (half + 1), product, 2 * half);
+    subtract_limbs(middle, 2 * (half + 1), product + 2 * half, product_size - 2 * half);
+
+    // limbs of the middle term beyond the product are zero
+    add_limbs(product + half, product_size - half, middle, std::min(2 * (half + 1), product_size - half));
+}
+
+// the same split with both operands one number, each of the three products is a square
+void karatsuba_square(
+    uint const *value,
+    size_t size,
+    uint *product,
+    uint *scratch) noexcept
+{
+    if (size < karatsuba_threshold()) {
+        schoolbook_square(value, size, product);
+        return;
+    }
+
+    size_t const half = (size + 1) / 2;
+
+    karatsuba_square(value, half, product, scratch);
+    karatsuba_square(value + half, size - half, product + 2 * half, scratch);
+
+    uint *sum = scratch;
+    uint *middle = sum + half + 1;
+    std::copy(value, value + half, sum);
+    sum[half] = add_limbs(sum, half, value + half, size - half);
+
+    karatsuba_square(sum, half + 1, middle, middle + 2 * (half + 1));
+    subtract_limbs(middle, 2 * (half + 1), product, 2 * half);
+    subtract_limbs(middle, 2 * (half + 1), product + 2 * half, 2 * (size - half));
+
+    add_limbs(product + half, 2 * size - half, middle, std::min(2 * (half + 1), 2 * size - half));
+}
+
+void karatsuba_kernel(
+    uint const *first,
+    size_t first_size,
+    uint const *second,
+    size_t second_size,
+    uint *product,
+    uint *scratch) noexcept
+{
+    if (first_size == second_size && std::equal(first, first + first_size, second)) {
+        karatsuba_square(first, first_size, product, scratch);
+    } else {
+        karatsuba_multiply(first, first_size, second, second_size, product, scratch);
     }
-    return first_multiplier;
+}
+
+size_t karatsuba_kernel_scratch_size(
+    size_t first_size,
+    size_t second_size) noexcept
+{
+    return karatsuba_scratch_size(std::max(first_size, second_size));
+}
+
 }
 
 big_integer &big_integer::Karatsuba_multiplication::multiply(
     big_integer &first_multiplier,
     big_integer const &second_multiplier) const
 {
-    throw not_implemented("big_integer &big_integer::Karatsuba_multiplication::multiply(big_integer &, big_integer const &)", "your code should be here...");
+    return first_multiplier.multiply_magnitudes(second_multiplier, karatsuba_kernel, karatsuba_kernel_scratch_size);
 }
 
+namespace
+{
+
+// arithmetic modulo an odd prime below 2^31 on numbers kept multiplied by 2^32 (Montgomery form)
+class montgomery_field final
+{
+
+private:
 
+    uint _modulus;
+
+    // -modulus^-1 modulo 2^32
+    uint _inverse;
+
+    // 2^64 modulo the modulus
+    uint _r2;
+
+public:
+
+    constexpr explicit montgomery_field(uint modulus) noexcept:
+        _modulus(modulus),
+        _inverse(0),
+        _r2(static_cast<uint>(-static_cast<uint64_t>(modulus) % modulus))
+    {
+        // every Newton step doubles the bits of the inverse that are right
+        uint inverse = modulus;
+        for (int i = 0; i < 4; ++i) {
+            inverse *= 2 - modulus * inverse;
+        }
+        _inverse = -inverse;
+    }
+
+public:
+
+    // value / 2^32, value less than modulus * 2^32
+    [[nodiscard]] constexpr uint reduce(uint64_t value) const noexcept
+    {
+        uint64_t reduced = (value + static_cast<uint64_t>(static_cast<uint>(value) * _inverse) * _modulus) >> 32;
+        return static_cast<uint>(reduced >= _modulus ? reduced - _modulus : reduced);
+    }
+
+    [[nodiscard]] constexpr uint multiply(uint first, uint second) const noexcept
+    {
+        return reduce(static_cast<uint64_t>(first) * second);
+    }
+
+    [[nodiscard]] constexpr uint add(uint first, uint second) const noexcept
+    {
+        uint sum = first + second;
+        return sum >= _modulus ? sum - _modulus : sum;
+    }
+
+    [[nodiscard]] constexpr uint subtract(uint first, uint second) const noexcept
+    {
+        return first >= second ? first - second : first + _modulus - second;
+    }
+
+    // any 32-bit value, not only residues
+    [[nodiscard]] constexpr uint to_form(uint value) const noexcept
+    {
+        return reduce(static_cast<uint64_t>(value) * _r2);
+    }
+
+    [[nodiscard]] constexpr uint from_form(uint value) const noexcept
+    {
+        return reduce(value);
+    }
+
+    [[nodiscard]] constexpr uint power(uint base, uint64_t exponent) const noexcept
+    {
+        uint result = to_form(1);
+        for (; exponent != 0; exponent >>= 1) {
+            if (exponent & 1) {
+                result = multiply(result, base);
+            }
+            base = multiply(base, base);
+        }
+        return result;
+    }
+
+    [[nodiscard]] constexpr uint modulus() const noexcept
+    {
+        return _modulus;
+    }
+
+};
+
+struct ntt_prime
+{
+    montgomery_field field;
+
+    uint generator;
+};
+
+// a coefficient of the product of two limb sequences is less than 2^64 times the length of the
+// shorter one, the three moduli multiplied are above 2^89; the first one caps transforms at 2^23 points
+constexpr ntt_prime ntt_primes[] =
+{
+    { montgomery_field(998244353), 3 },
+    { montgomery_field(2013265921), 31 },
+    { montgomery_field(469762049), 3 }
+};
+
+constexpr size_t ntt_primes_count = sizeof(ntt_primes) / sizeof(ntt_primes[0]);
+
+constexpr size_t ntt_max_size = size_t(1) << 23;
+
+// transforms this small fit in the first level cache and go level by level, larger ones go depth
+// first so that every half is done while it is in the cache
+constexpr size_t ntt_block = size_t(1) << 12;
+
+size_t ntt_size(
+    size_t first_size,
+    size_t second_size) noexcept
+{
+    return std::bit_ceil(first_size + second_size - 1);
+}
+
+// roots[half + j] is w^j for every power of two 2 * half up to size, w a root of unity of degree
+// 2 * half, in Montgomery form
+void ntt_roots(
+    ntt_prime const &prime,
+    size_t size,
+    uint *roots) noexcept
+{
+    auto const &field = prime.field;
+    for (size_t half = 1; half < size; half <<= 1) {
+        uint root = field.power(field.to_form(prime.generator), (field.modulus() - 1) / (2 * half));
+        uint power = field.to_form(1);
+        for (size_t j = 0; j < half; ++j) {
+            roots[half + j] = power;
+            power = field.multiply(power, root);
+        }
+    }
+}
+
+// decimation in frequency: natural order in, bit-reversed order out
+void ntt_forward(
+    montgomery_field const &field,
+    uint const *roots,
+    uint *values,
+    size_t size) noexcept
+{
+    if (size > ntt_block) {
+        size_t const half = size / 2;
+        for (size_t j = 0; j < half; ++j) {
+            uint first = values[j];
+            uint second = values[j + half];
+            values[j] = field.add(first, second);
+            values[j + half] = field.multiply(field.subtract(first, second), roots[half + j]);
+        }
+        ntt_forward(field, roots, values, half);
+        ntt_forward(field, roots, values + half, half);
+        return;
+    }
+
+    for (size_t length = size; length >= 2; length >>= 1) {
+        size_t const half = length / 2;
+        for (size_t start = 0; start < size; start += length) {
+            uint *block = values + start;
+            for (size_t j = 0; j < half; ++j) {
+                uint first = block[j];
+                uint second = block[j + half];
+                block[j] = field.add(first, second);
+                block[j + half] = field.multiply(field.subtract(first, second), roots[half + j]);
+            }
+        }
+    }
+}
+
+// decimation in time with the inverse roots, w^-j being -w^(half - j): bit-reversed order in,
+// natural order out, not divided by size
+void ntt_inverse(
+    montgomery_field const &field,
+    uint const *roots,
+    uint *values,
+    size_t size) noexcept
+{
+    auto butterflies = [&field, roots](uint *block, size_t half)
+    {
+        for (size_t j = 0; j < half; ++j) {
+            uint first = block[j];
+            uint second = block[j + half];
+            if (j != 0) {
+                second = field.multiply(second, field.subtract(0, roots[2 * half - j]));
+            }
+            block[j] = field.add(first, second);
+            block[j + half] = field.subtract(first, second);
+        }
+    };
+
+    if (size > ntt_block) {
+        size_t const half = size / 2;
+        ntt_inverse(field, roots, values, half);
+        ntt_inverse(field, roots, values + half, half);
+        butterflies(values, half);
+        return;
+    }
+
+    for (size_t length = 2; length <= size; length <<= 1) {
+        for (size_t start = 0; start < size; start += length) {
+            butterflies(values + start, length / 2);
+        }
+    }
+}
+
+// runs every task on up to threads_count threads, the calling one included
+void run_tasks(
+    std::vector<std::function<void()>> const &tasks,
+    size_t threads_count)
+{
+    std::atomic<size_t> next(0);
+    auto worker = [&tasks, &next]()
+    {
+        for (size_t index; (index = next.fetch_add(1)) < tasks.size(); ) {
+            tasks[index]();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min(threads_count, tasks.size()); ++i) {
+        try {
+            threads.emplace_back(worker);
+        } catch (std::system_error const &) {
+            // what is left is done by the threads already running
+            break;
+        }
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+size_t ntt_scratch_size(
+    size_t first_size,
+    size_t second_size) noexcept
+{
+    size_t const size = std::min(ntt_size(first_size, second_size), ntt_max_size);
+    size_t const ntt_limbs = 3 * ntt_primes_count * size;
+    size_t const Karatsuba_limbs = ntt_size(first_size, second_size) > ntt_max_size
+        ? karatsuba_scratch_size(std::max(first_size, second_size))
+        : 0;
+    return std::max(ntt_limbs, Karatsuba_limbs);
+}
+
+// the limbs are taken as coefficients and multiplied modulo every prime by transforms, the
+// coefficients of the product are put together from their residues and carried into limbs;
+// products too long for the transforms are left to Karatsuba
+void ntt_multiply(
+    uint const *first,
+    size_t first_size,
+    uint const *second,
+    size_t second_size,
+    uint *product,
+    uint *scratch)
+{
+    size_t const size = ntt_size(first_size, second_size);
+    if (size > ntt_max_size) {
+        karatsuba_multiply(first, first_size, second, second_size, product, scratch);
+        return;
+    }
+    bool const square = first_size == second_size && std::equal(first, first + first_size, second);
+
+    // per prime: the roots, then the transforms of both operands
+    auto roots_of = [scratch, size](size_t prime) { return scratch + 3 * size * prime; };
+    auto first_of = [scratch, size](size_t prime) { return scratch + 3 * size * prime + size; };
+    auto second_of = [scratch, size](size_t prime) { return scratch + 3 * size * prime + 2 * size; };
+
+    auto load = [size](montgomery_field const &field, uint const *limbs, size_t limbs_count, uint *values)
+    {
+        for (size_t i = 0; i < limbs_count; ++i) {
+            values[i] = field.to_form(limbs[i]);
+        }
+        std::fill(values + limbs_count, values + size, 0u);
+    };
+
+    std::vector<std::function<void()>> transforms;
+    for (size_t prime = 0; prime < ntt_primes_count; ++prime) {
+        transforms.emplace_back([=]()
+        {
+            auto const &field = ntt_primes[prime].field;
+            ntt_roots(ntt_primes[prime], size, roots_of(prime));
+            load(field, first, first_size, first_of(prime));
+            ntt_forward(field, roots_of(prime), first_of(prime), size);
+        });
+    }
+    run_tasks(transforms, big_integer::Schonhage_Strassen_threads);
+
+    std::vector<std::function<void()>> products;
+    for (size_t prime = 0; prime < ntt_primes_count; ++prime) {
+        products.emplace_back([=]()
+        {
+            auto const &field = ntt_primes[prime].field;
+            uint *values = first_of(prime);
+            uint const *other_values = values;
+            if (!square) {
+                load(field, second, second_size, second_of(prime));
+                ntt_forward(field, roots_of(prime), second_of(prime), size);
+                other_values = second_of(prime);
+            }
+            for (size_t i = 0; i < size; ++i) {
+                values[i] = field.multiply(values[i], other_values[i]);
+            }
+            ntt_inverse(field, roots_of(prime), values, size);
+
+            // a value in Montgomery form times a plain one is a plain product, out of the form
+            // and divided by size at once
+            uint const size_inverse = field.from_form(field.power(field.to_form(static_cast<uint>(size)), field.modulus() - 2));
+            for (size_t i = 0; i < size; ++i) {
+                values[i] = field.multiply(values[i], size_inverse);
+            }
+        });
+    }
+    run_tasks(products, big_integer::Schonhage_Strassen_threads);
+
+    // Garner: x = r0 + p0 * v1 + p0 * p1 * v2, x is below p0 * p1 * p2; the inverses are in
+    // Montgomery form, so multiplying plain residues by them gives plain residues
+    constexpr auto const &field_1 = ntt_primes[1].field;
+    constexpr auto const &field_2 = ntt_primes[2].field;
+    constexpr uint p0 = ntt_primes[0].field.modulus();
+    constexpr uint p2 = field_2.modulus();
+    constexpr uint64_t p0_p1 = static_cast<uint64_t>(p0) * field_1.modulus();
+    uint const p0_inverse_1 = field_1.power(field_1.to_form(p0), field_1.modulus() - 2);
+    uint const p0_p1_inverse_2 = field_2.power(field_2.to_form(static_cast<uint>(p0_p1 % p2)), p2 - 2);
+    uint const p0_2 = field_2.to_form(p0);
+
+    uint const *residues_0 = first_of(0);
+    uint const *residues_1 = first_of(1);
+    uint const *residues_2 = first_of(2);
+
+    // carry as three 32-bit places, each below 2^34
+    uint64_t carry_0 = 0;
+    uint64_t carry_1 = 0;
+    uint64_t carry_2 = 0;
+    size_t const product_size = first_size + second_size;
+    for (size_t i = 0; i < product_size; ++i) {
+        if (i < size) {
+            // r0 is a residue modulo p1 as well, p0 being below p1
+            uint r0 = residues_0[i];
+            uint v1 = field_1.multiply(field_1.subtract(residues_1[i], r0), p0_inverse_1);
+            uint64_t low = r0 + static_cast<uint64_t>(v1) * p0;
+            uint low_2 = field_2.add(r0 % p2, field_2.multiply(v1, p0_2));
+            uint v2 = field_2.multiply(field_2.subtract(residues_2[i], low_2), p0_p1_inverse_2);
+
+            // low + v2 * p0_p1 in three places
+            uint64_t term_low = static_cast<uint64_t>(v2) * static_cast<uint>(p0_p1);
+            uint64_t term_high = static_cast<uint64_t>(v2) * static_cast<uint>(p0_p1 >> 32);
+            carry_0 += static_cast<uint64_t>(static_cast<uint>(low)) + static_cast<uint>(term_low);
+            carry_1 += (low >> 32) + (term_low >> 32) + static_cast<uint>(term_high);
+            carry_2 += term_high >> 32;
+        }
+        product[i] = static_cast<uint>(carry_0);
+        carry_0 = (carry_0 >> 32) + carry_1;
+        carry_1 = carry_2;
+        carry_2 = 0;
+    }
+}
+
+// transforms from Schonhage_Strassen_threshold limbs of the shorter operand, Karatsuba (which
+// hands short operands to the schoolbook kernel) below
+bool transforms(
+    size_t first_size,
+    size_t second_size) noexcept
+{
+    return std::min(first_size, second_size) >= big_integer::Schonhage_Strassen_threshold;
+}
+
+void automatic_kernel(
+    uint const *first,
+    size_t first_size,
+    uint const *second,
+    size_t second_size,
+    uint *product,
+    uint *scratch)
+{
+    if (transforms(first_size, second_size)) {
+        ntt_multiply(first, first_size, second, second_size, product, scratch);
+    } else {
+        karatsuba_kernel(first, first_size, second, second_size, product, scratch);
+    }
+}
+
+size_t automatic_scratch_size(
+    size_t first_size,
+    size_t second_size) noexcept
+{
+    return transforms(first_size, second_size)
+        ? ntt_scratch_size(first_size, second_size)
+        : karatsuba_kernel_scratch_size(first_size, second_size);
+}
+
+struct multiplication_kernel
+{
+    void (*multiply)(uint const *first, size_t first_size, uint const *second, size_t second_size, uint *product, uint *scratch);
+
+    size_t (*scratch_limbs)(size_t first_size, size_t second_size);
+};
+
+multiplication_kernel kernel_of(
+    big_integer::multiplication_rule rule) noexcept
+{
+    switch (rule) {
+        case big_integer::multiplication_rule::Karatsuba:
+            return { karatsuba_kernel, karatsuba_kernel_scratch_size };
+        case big_integer::multiplication_rule::SchonhageStrassen:
+            return { ntt_multiply, ntt_scratch_size };
+        case big_integer::multiplication_rule::automatic:
+            return { automatic_kernel, automatic_scratch_size };
+        default:
+            return { schoolbook_kernel, no_scratch };
+    }
+}
+
+// product gets first_size + second_size limbs, the kernel of the rule gets scratch of its own
+void multiply_limbs(
+    big_integer::multiplication_rule rule,
+    uint const *first,
+    size_t first_size,
+    uint const *second,
+    size_t second_size,
+    uint *product)
+{
+    auto kernel = kernel_of(rule);
+    std::vector<uint> scratch(kernel.scratch_limbs(first_size, second_size));
+    kernel.multiply(first, first_size, second, second_size, product, scratch.data());
+}
+
+}
 
 big_integer &big_integer::Schonhage_Strassen_multiplication::multiply(
     big_integer &first_multiplier,
     big_integer const &second_multiplier) const
 {
-    throw not_implemented("big_integer &big_integer::Schonhage_Strassen_multiplication::multiply(big_integer &, big_integer const &)", "your code should be here...");
+    return first_multiplier.multiply_magnitudes(second_multiplier, ntt_multiply, ntt_scratch_size);
+}
+
+big_integer &big_integer::automatic_multiplication::multiply(
+    big_integer &first_multiplier,
+    big_integer const &second_multiplier) const
+{
+    return first_multiplier.multiply_magnitudes(second_multiplier, automatic_kernel, automatic_scratch_size);
 }
 
 inline unsigned int big_integer::get_digit_big_endian(int position) const noexcept
@@ -336,6 +998,152 @@ inline unsigned int big_integer::get_digit_big_endian(int position) const noexce
     return 0;
 }
 
+void big_integer::magnitude_to(
+    uint *limbs) const noexcept
+{
+    int const size = get_size();
+    if (size > 1) {
+        std::memcpy(limbs, _other_digits + 1, sizeof(uint) * (size - 1));
+    }
+    limbs[size - 1] = static_cast<uint>(_oldest_digit) & ~(1u << ((sizeof(int) << 3) - 1));
+}
+
+big_integer &big_integer::adopt_magnitude(
+    uint *digits,
+    size_t limbs_count,
+    bool negative) noexcept
+{
+    limbs_count = significant_limbs(digits + 1, limbs_count);
+    uint oldest = digits[limbs_count];
+
+    // the top bit is the sign, a limb that has it set goes under a zero one
+    if (oldest >> ((sizeof(int) << 3) - 1)) {
+        oldest = 0;
+        ++limbs_count;
+    }
+
+    if (_other_digits) {
+        deallocate_with_guard(_other_digits);
+    }
+    if (limbs_count == 1) {
+        deallocate_with_guard(digits);
+        _other_digits = nullptr;
+    } else {
+        digits[0] = static_cast<uint>(limbs_count);
+        _other_digits = digits;
+    }
+    _oldest_digit = static_cast<int>(oldest);
+
+    if (negative && !is_zero()) {
+        change_sign();
+    }
+    return *this;
+}
+
+big_integer &big_integer::multiply_magnitudes(
+    big_integer const &other,
+    limbs_multiplication multiply_limbs,
+    scratch_size scratch_limbs)
+{
+    bool negative = (sign() < 0) != (other.sign() < 0);
+
+    // both operands are copied first, other may be this number
+    size_t const first_count = get_size();
+    size_t const second_count = other.get_size();
+    size_t const scratch_count = scratch_limbs(first_count, second_count);
+    auto *operands = static_cast<uint *>(allocate_with_guard(sizeof(uint), first_count + second_count + scratch_count));
+    magnitude_to(operands);
+    other.magnitude_to(operands + first_count);
+    size_t const first_size = significant_limbs(operands, first_count);
+    size_t const second_size = significant_limbs(operands + first_count, second_count);
+
+    uint *digits;
+    try {
+        digits = static_cast<uint *>(allocate_with_guard(sizeof(uint), first_size + second_size + 1));
+    } catch (...) {
+        deallocate_with_guard(operands);
+        throw;
+    }
+
+    multiply_limbs(operands, first_size, operands + first_count, second_size, digits + 1, operands + first_count + second_count);
+    deallocate_with_guard(operands);
+
+    return adopt_magnitude(digits, first_size + second_size, negative);
+}
+
+void big_integer::divide_magnitudes(
+    big_integer const &dividend,
+    big_integer const &divisor,
+    big_integer *quotient,
+    big_integer *remainder,
+    limbs_division divide_limbs,
+    division_scratch_size scratch_limbs,
+    multiplication_rule rule)
+{
+    if (divisor.is_zero()) {
+        throw std::logic_error("Division by zero is not defined\n");
+    }
+    bool const quotient_negative = (dividend.sign() < 0) != (divisor.sign() < 0);
+    bool const remainder_negative = dividend.sign() < 0;
+
+    // both operands are copied first, the results may be the operands
+    size_t const numerator_count = dividend.get_size();
+    size_t const divisor_count = divisor.get_size();
+    auto *operands = static_cast<uint *>(dividend.allocate_with_guard(sizeof(uint), numerator_count + divisor_count));
+    dividend.magnitude_to(operands);
+    divisor.magnitude_to(operands + numerator_count);
+    size_t const numerator_size = significant_limbs(operands, numerator_count);
+    size_t const divisor_size = significant_limbs(operands + numerator_count, divisor_count);
+    size_t const quotient_size = numerator_size >= divisor_size ? numerator_size - divisor_size + 1 : 1;
+
+    // results nobody takes are kept by the dividend until the end
+    big_integer const &quotient_owner = quotient ? *quotient : dividend;
+    big_integer const &remainder_owner = remainder ? *remainder : dividend;
+    size_t const scratch_count = numerator_size >= divisor_size ? scratch_limbs(numerator_size, divisor_size, rule) : 0;
+    uint *quotient_digits = nullptr;
+    uint *remainder_digits = nullptr;
+    uint *scratch = nullptr;
+    try {
+        quotient_digits = static_cast<uint *>(quotient_owner.allocate_with_guard(sizeof(uint), quotient_size + 1));
+        remainder_digits = static_cast<uint *>(remainder_owner.allocate_with_guard(sizeof(uint), divisor_size + 1));
+        if (scratch_count != 0) {
+            scratch = static_cast<uint *>(dividend.allocate_with_guard(sizeof(uint), scratch_count));
+        }
+    } catch (...) {
+        if (remainder_digits) {
+            remainder_owner.deallocate_with_guard(remainder_digits);
+        }
+        if (quotient_digits) {
+            quotient_owner.deallocate_with_guard(quotient_digits);
+        }
+        dividend.deallocate_with_guard(operands);
+        throw;
+    }
+
+    if (numerator_size < divisor_size) {
+        quotient_digits[1] = 0;
+        std::copy(operands, operands + numerator_size, remainder_digits + 1);
+        std::fill(remainder_digits + 1 + numerator_size, remainder_digits + 1 + divisor_size, 0u);
+    } else {
+        divide_limbs(operands, numerator_size, operands + numerator_count, divisor_size, quotient_digits + 1, remainder_digits + 1, scratch, rule);
+    }
+    if (scratch) {
+        dividend.deallocate_with_guard(scratch);
+    }
+    dividend.deallocate_with_guard(operands);
+
+    if (quotient) {
+        quotient->adopt_magnitude(quotient_digits, quotient_size, quotient_negative);
+    } else {
+        dividend.deallocate_with_guard(quotient_digits);
+    }
+    if (remainder) {
+        remainder->adopt_magnitude(remainder_digits, divisor_size, remainder_negative);
+    } else {
+        dividend.deallocate_with_guard(remainder_digits);
+    }
+}
+
 big_integer &big_integer::trivial_division::divide(
     big_integer &dividend,
     big_integer const &divisor,
@@ -485,12 +1293,316 @@ big_integer &big_integer::trivial_division::modulo(
     return dividend = remainder;
 }
 
+namespace
+{
+
+uint const one_limb = 1;
+
+// result gets size limbs, the bits shifted out on top (shift below 32) are returned
+uint shift_left_limbs(
+    uint const *limbs,
+    size_t size,
+    unsigned int shift,
+    uint *result) noexcept
+{
+    if (shift == 0) {
+        std::copy(limbs, limbs + size, result);
+        return 0;
+    }
+    uint shifted_out = 0;
+    for (size_t i = 0; i < size; ++i) {
+        uint limb = limbs[i];
+        result[i] = (limb << shift) | shifted_out;
+        shifted_out = limb >> (32 - shift);
+    }
+    return shifted_out;
+}
+
+void shift_right_limbs(
+    uint const *limbs,
+    size_t size,
+    unsigned int shift,
+    uint *result) noexcept
+{
+    if (shift == 0) {
+        std::copy(limbs, limbs + size, result);
+        return;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        result[i] = (limbs[i] >> shift) | (i + 1 < size ? limbs[i + 1] << (32 - shift) : 0);
+    }
+}
+
+int compare_limbs(
+    uint const *first,
+    size_t first_size,
+    uint const *second,
+    size_t second_size) noexcept
+{
+    first_size = significant_limbs(first, first_size);
+    second_size = significant_limbs(second, second_size);
+    if (first_size != second_size) {
+        return first_size < second_size ? -1 : 1;
+    }
+    for (size_t i = first_size; i-- > 0; ) {
+        if (first[i] != second[i]) {
+            return first[i] < second[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+// Knuth's algorithm D: every quotient limb is estimated from the top limbs and is at most one too
+// large after the check against the next divisor limb. The divisor has its top bit set, numerator
+// is left with the remainder in its low divisor_size limbs and quotient gets
+// numerator_size - divisor_size + 1 limbs
+void schoolbook_divide(
+    uint *numerator,
+    size_t numerator_size,
+    uint const *divisor,
+    size_t divisor_size,
+    uint *quotient) noexcept
+{
+    uint64_t const top = divisor[divisor_size - 1];
+    uint64_t const next = divisor_size > 1 ? divisor[divisor_size - 2] : 0;
+
+    for (size_t j = numerator_size - divisor_size + 1; j-- > 0; ) {
+        // the limb above the numerator is zero
+        uint64_t const high = j + divisor_size < numerator_size ? numerator[j + divisor_size] : 0;
+        uint64_t const leading = (high << 32) | numerator[j + divisor_size - 1];
+        uint64_t estimate = leading / top;
+        uint64_t rest = leading % top;
+        uint64_t const below = j + divisor_size >= 2 ? numerator[j + divisor_size - 2] : 0;
+        while (estimate > UINT32_MAX || (divisor_size > 1 && estimate * next > ((rest << 32) | below))) {
+            --estimate;
+            rest += top;
+            if (rest > UINT32_MAX) {
+                break;
+            }
+        }
+
+        uint64_t carry = 0;
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < divisor_size; ++i) {
+            uint64_t product = estimate * divisor[i] + carry;
+            carry = product >> 32;
+            uint64_t difference = static_cast<uint64_t>(numerator[i + j]) - static_cast<uint>(product) - borrow;
+            numerator[i + j] = static_cast<uint>(difference);
+            borrow = difference >> 63;
+        }
+        uint64_t difference = high - carry - borrow;
+        if (j + divisor_size < numerator_size) {
+            numerator[j + divisor_size] = static_cast<uint>(difference);
+        }
+
+        // one too large: the divisor is added back
+        if (difference >> 63) {
+            --estimate;
+            uint64_t sum = 0;
+            for (size_t i = 0; i < divisor_size; ++i) {
+                sum += static_cast<uint64_t>(numerator[i + j]) + divisor[i];
+                numerator[i + j] = static_cast<uint>(sum);
+                sum >>= 32;
+            }
+            if (j + divisor_size < numerator_size) {
+                numerator[j + divisor_size] += static_cast<uint>(sum);
+            }
+        }
+        quotient[j] = static_cast<uint>(estimate);
+    }
+}
+
+// the numerator and the divisor are shifted for the divisor's top bit to be set, the quotient is
+// the same and the remainder comes back shifted
+void schoolbook_division_kernel(
+    uint const *numerator,
+    size_t numerator_size,
+    uint const *divisor,
+    size_t divisor_size,
+    uint *quotient,
+    uint *remainder,
+    uint *scratch,
+    big_integer::multiplication_rule) noexcept
+{
+    unsigned int const shift = std::countl_zero(divisor[divisor_size - 1]);
+    uint *shifted = scratch;
+    uint *normalized_divisor = shifted + numerator_size + 1;
+    uint *quotient_limbs = normalized_divisor + divisor_size;
+
+    shifted[numerator_size] = shift_left_limbs(numerator, numerator_size, shift, shifted);
+    shift_left_limbs(divisor, divisor_size, shift, normalized_divisor);
+    schoolbook_divide(shifted, numerator_size + 1, normalized_divisor, divisor_size, quotient_limbs);
+    std::copy(quotient_limbs, quotient_limbs + (numerator_size - divisor_size + 1), quotient);
+    shift_right_limbs(shifted, divisor_size, shift, remainder);
+}
+
+size_t schoolbook_division_scratch_size(
+    size_t numerator_size,
+    size_t divisor_size,
+    big_integer::multiplication_rule) noexcept
+{
+    return (numerator_size + 1) + divisor_size + (numerator_size - divisor_size + 2);
+}
+
+// divisors up to this many limbs are divided by the schoolbook algorithm, longer ones get their
+// reciprocals down to this size by Newton's iteration
+constexpr size_t newton_threshold = 32;
+
+// floor(B^(2 * size) / divisor), B = 2^32, for divisor of size limbs with its top bit set; size + 1 limbs.
+// The reciprocal of the top half of the divisor, rounded up, is an approximation from below; one
+// Newton step x + x * (B^(2 * size) - divisor * x) / B^(2 * size) leaves it a few units short,
+// which one more product finds
+std::vector<uint> newton_reciprocal(
+    uint const *divisor,
+    size_t size,
+    big_integer::multiplication_rule rule)
+{
+    std::vector<uint> reciprocal(size + 2, 0u);
+    if (size <= newton_threshold) {
+        std::vector<uint> numerator(2 * size + 1, 0u);
+        numerator[2 * size] = 1;
+        schoolbook_divide(numerator.data(), numerator.size(), divisor, size, reciprocal.data());
+        reciprocal.resize(size + 1);
+        return reciprocal;
+    }
+
+    size_t const high = (size + 1) / 2;
+    size_t const low = size - high;
+
+    // the top limbs plus one are above divisor / B^low; all ones make B^high, its reciprocal is B^high
+    std::vector<uint> approximation;
+    std::vector<uint> top(divisor + low, divisor + size);
+    if (add_limbs(top.data(), high, &one_limb, 1) != 0) {
+        approximation.assign(high + 1, 0u);
+        approximation[high] = 1;
+    } else {
+        approximation = newton_reciprocal(top.data(), high, rule);
+    }
+
+    // with x = approximation * B^low, the error B^(2 * size) - divisor * x is error * B^low
+    std::vector<uint> product(size + high + 1);
+    multiply_limbs(rule, divisor, size, approximation.data(), high + 1, product.data());
+    std::vector<uint> error(size + high, 0u);
+    if (product[size + high] == 0) {
+        for (size_t i = 0; i < size + high; ++i) {
+            error[i] = ~product[i];
+        }
+        add_limbs(error.data(), size + high, &one_limb, 1);
+    }
+
+    // x * (B^(2 * size) - divisor * x) / B^(2 * size) is approximation * error / B^(2 * high)
+    std::vector<uint> correction(high + 1 + size + high);
+    multiply_limbs(rule, approximation.data(), high + 1, error.data(), size + high, correction.data());
+    std::copy(approximation.begin(), approximation.end(), reciprocal.begin() + low);
+    add_limbs(reciprocal.data(), size + 2, correction.data() + 2 * high, size + 1);
+
+    std::vector<uint> check(2 * size + 2);
+    multiply_limbs(rule, divisor, size, reciprocal.data(), size + 1, check.data());
+    std::vector<uint> rest(2 * size, 0u);
+    if (check[2 * size] == 0) {
+        for (size_t i = 0; i < 2 * size; ++i) {
+            rest[i] = ~check[i];
+        }
+        add_limbs(rest.data(), 2 * size, &one_limb, 1);
+    }
+    while (compare_limbs(rest.data(), 2 * size, divisor, size) >= 0) {
+        subtract_limbs(rest.data(), 2 * size, divisor, size);
+        add_limbs(reciprocal.data(), size + 2, &one_limb, 1);
+    }
+
+    reciprocal.resize(size + 1);
+    return reciprocal;
+}
+
+// the divisor divided by last on this thread, normalized, and its reciprocal
+struct reciprocal_cache
+{
+    std::vector<uint> divisor;
+
+    std::vector<uint> reciprocal;
+};
+
+thread_local reciprocal_cache cached_reciprocal;
+
+// the numerator is taken size limbs at a time from the top; with the remainder so far above
+// them they make x < divisor * B^size, and q = floor(x / divisor) is estimated as
+// floor(floor(x / B^(size - 1)) * reciprocal / B^(size + 1)), at most three below it
+void newton_divide(
+    uint const *numerator,
+    size_t numerator_size,
+    uint const *divisor,
+    size_t divisor_size,
+    uint *quotient,
+    uint *remainder,
+    uint *,
+    big_integer::multiplication_rule rule)
+{
+    size_t const size = divisor_size;
+    if (size <= newton_threshold) {
+        std::vector<uint> scratch(schoolbook_division_scratch_size(numerator_size, size, rule));
+        schoolbook_division_kernel(numerator, numerator_size, divisor, size, quotient, remainder, scratch.data(), rule);
+        return;
+    }
+    unsigned int const shift = std::countl_zero(divisor[size - 1]);
+
+    std::vector<uint> normalized_divisor(size);
+    shift_left_limbs(divisor, size, shift, normalized_divisor.data());
+
+    size_t const chunks = (numerator_size + size) / size;
+    std::vector<uint> shifted(chunks * size, 0u);
+    shifted[numerator_size] = shift_left_limbs(numerator, numerator_size, shift, shifted.data());
+
+    // a failed computation leaves no divisor cached
+    auto &cache = cached_reciprocal;
+    if (cache.divisor != normalized_divisor) {
+        cache.divisor.clear();
+        cache.reciprocal = newton_reciprocal(normalized_divisor.data(), size, rule);
+        cache.divisor = normalized_divisor;
+    }
+    auto const &reciprocal = cache.reciprocal;
+
+    std::vector<uint> window(2 * size, 0u);
+    std::vector<uint> estimate_product(2 * size + 2);
+    std::vector<uint> subtrahend(2 * size);
+    std::vector<uint> quotient_limbs(chunks * size);
+
+    for (size_t chunk = chunks; chunk-- > 0; ) {
+        std::copy(window.begin(), window.begin() + size, window.begin() + size);
+        std::copy(shifted.begin() + chunk * size, shifted.begin() + (chunk + 1) * size, window.begin());
+
+        multiply_limbs(rule, window.data() + size - 1, size + 1, reciprocal.data(), size + 1, estimate_product.data());
+        uint *estimate = estimate_product.data() + size + 1;
+        multiply_limbs(rule, estimate, size, normalized_divisor.data(), size, subtrahend.data());
+        subtract_limbs(window.data(), 2 * size, subtrahend.data(), 2 * size);
+        while (compare_limbs(window.data(), 2 * size, normalized_divisor.data(), size) >= 0) {
+            subtract_limbs(window.data(), 2 * size, normalized_divisor.data(), size);
+            add_limbs(estimate, size, &one_limb, 1);
+        }
+        std::copy(estimate, estimate + size, quotient_limbs.begin() + chunk * size);
+    }
+
+    std::copy(quotient_limbs.begin(), quotient_limbs.begin() + (numerator_size - size + 1), quotient);
+    shift_right_limbs(window.data(), size, shift, remainder);
+}
+
+// the temporaries of Newton's division are vectors of its own
+size_t newton_scratch_size(
+    size_t,
+    size_t,
+    big_integer::multiplication_rule) noexcept
+{
+    return 0;
+}
+
+}
+
 big_integer &big_integer::Newton_division::divide(
     big_integer &dividend,
     big_integer const &divisor,
     big_integer::multiplication_rule multiplication_rule) const
 {
-    throw not_implemented("big_integer &big_integer::Newton_division::divide(big_integer &, big_integer const &, big_integer::multiplication_rule)", "your code should be here...");
+    divide_magnitudes(dividend, divisor, &dividend, nullptr, newton_divide, newton_scratch_size, multiplication_rule);
+    return dividend;
 }
 
 big_integer &big_integer::Newton_division::modulo(
@@ -498,7 +1610,197 @@ big_integer &big_integer::Newton_division::modulo(
     big_integer const &divisor,
     big_integer::multiplication_rule multiplication_rule) const
 {
-    throw not_implemented("big_integer &big_integer::Newton_division::modulo(big_integer &, big_integer const &, big_integer::multiplication_rule)", "your code should be here...");
+    divide_magnitudes(dividend, divisor, nullptr, &dividend, newton_divide, newton_scratch_size, multiplication_rule);
+    return dividend;
+}
+
+namespace
+{
+
+// divisors are split in halves down to blocks of at most this many limbs, which are divided by
+// the schoolbook algorithm
+constexpr size_t burnikel_ziegler_threshold = 40;
+
+// the top limbs a1 a2 of a = a1 a2 a3 (halves of size limbs) are divided by the top limbs b1
+// of b = b1 b2, or the quotient is taken as B^size - 1 when a1 = b1; it is at most two above the
+// quotient of a by b. a < b * B^size, the remainder is left in the low 2 * size limbs of a
+void burnikel_ziegler_3n_2n(
+    uint *a,
+    uint const *b,
+    size_t size,
+    uint *quotient,
+    uint *scratch,
+    big_integer::multiplication_rule rule);
+
+// a of 2 * size limbs below b * B^size by b of size limbs with its top bit set; the remainder
+// is left in the low size limbs of a
+void burnikel_ziegler_2n_1n(
+    uint *a,
+    uint const *b,
+    size_t size,
+    uint *quotient,
+    uint *scratch,
+    big_integer::multiplication_rule rule)
+{
+    if (size % 2 != 0 || size <= burnikel_ziegler_threshold) {
+        schoolbook_divide(a, 2 * size, b, size, scratch);
+        std::copy(scratch, scratch + size, quotient);
+        return;
+    }
+
+    size_t const half = size / 2;
+    burnikel_ziegler_3n_2n(a + half, b, half, quotient + half, scratch, rule);
+    burnikel_ziegler_3n_2n(a, b, half, quotient, scratch, rule);
+}
+
+void burnikel_ziegler_3n_2n(
+    uint *a,
+    uint const *b,
+    size_t size,
+    uint *quotient,
+    uint *scratch,
+    big_integer::multiplication_rule rule)
+{
+    uint const *b1 = b + size;
+    uint *a1 = a + 2 * size;
+
+    // r1 = a1 a2 - quotient * b1 takes the place of a1 a2
+    if (compare_limbs(a1, size, b1, size) < 0) {
+        burnikel_ziegler_2n_1n(a + size, b1, size, quotient, scratch, rule);
+    } else {
+        std::fill(quotient, quotient + size, UINT32_MAX);
+        subtract_limbs(a1, size, b1, size);
+        add_limbs(a + size, 2 * size, b1, size);
+    }
+
+    // r1 a3 - quotient * b2, the divisor is added back while it is negative
+    auto const kernel = kernel_of(rule);
+    uint *product = scratch;
+    kernel.multiply(quotient, size, b, size, product, product + 2 * size);
+    uint borrow = subtract_limbs(a, 3 * size, product, 2 * size);
+    while (borrow != 0) {
+        subtract_limbs(quotient, size, &one_limb, 1);
+        borrow -= add_limbs(a, 3 * size, b, 2 * size);
+    }
+}
+
+size_t burnikel_ziegler_2n_1n_scratch_size(
+    size_t size,
+    big_integer::multiplication_rule rule) noexcept
+{
+    if (size % 2 != 0 || size <= burnikel_ziegler_threshold) {
+        return size + 1;
+    }
+
+    size_t const half = size / 2;
+    return 2 * half + std::max(burnikel_ziegler_2n_1n_scratch_size(half, rule), kernel_of(rule).scratch_limbs(half, half));
+}
+
+// limbs the divisor is padded to: a block of at most burnikel_ziegler_threshold limbs doubled
+// until it holds the divisor
+size_t burnikel_ziegler_block_size(
+    size_t divisor_size) noexcept
+{
+    size_t block = divisor_size;
+    size_t doublings = 0;
+    while (block > burnikel_ziegler_threshold) {
+        block = (block + 1) / 2;
+        ++doublings;
+    }
+    return block << doublings;
+}
+
+// blocks of the padded numerator, whose top limb stays zero for the top block to be below the divisor
+size_t burnikel_ziegler_blocks(
+    size_t numerator_size,
+    size_t divisor_size,
+    size_t block) noexcept
+{
+    size_t const padded_size = numerator_size + (block - divisor_size) + 2;
+    return std::max<size_t>(2, (padded_size + block - 1) / block);
+}
+
+size_t burnikel_ziegler_scratch_size(
+    size_t numerator_size,
+    size_t divisor_size,
+    big_integer::multiplication_rule rule) noexcept
+{
+    size_t const block = burnikel_ziegler_block_size(divisor_size);
+    size_t const blocks = burnikel_ziegler_blocks(numerator_size, divisor_size, block);
+    return blocks * block + block + (blocks - 1) * block + burnikel_ziegler_2n_1n_scratch_size(block, rule);
+}
+
+// the divisor is shifted for its top bit to be set and padded with zero limbs below to a block
+// of the form j * 2^k, the numerator likewise; then every two blocks of the numerator, the
+// remainder so far and the next block, are divided by the 2n/1n recursion
+void burnikel_ziegler_divide(
+    uint const *numerator,
+    size_t numerator_size,
+    uint const *divisor,
+    size_t divisor_size,
+    uint *quotient,
+    uint *remainder,
+    uint *scratch,
+    big_integer::multiplication_rule rule)
+{
+    size_t const block = burnikel_ziegler_block_size(divisor_size);
+    size_t const blocks = burnikel_ziegler_blocks(numerator_size, divisor_size, block);
+    size_t const padding = block - divisor_size;
+    unsigned int const shift = std::countl_zero(divisor[divisor_size - 1]);
+
+    uint *a = scratch;
+    uint *b = a + blocks * block;
+    uint *quotient_limbs = b + block;
+    uint *rest = quotient_limbs + (blocks - 1) * block;
+
+    std::fill(a, a + blocks * block, 0u);
+    a[padding + numerator_size] = shift_left_limbs(numerator, numerator_size, shift, a + padding);
+    std::fill(b, b + padding, 0u);
+    shift_left_limbs(divisor, divisor_size, shift, b + padding);
+
+    // the remainder of every step is left below the next block
+    for (size_t i = blocks - 1; i-- > 0; ) {
+        burnikel_ziegler_2n_1n(a + i * block, b, block, quotient_limbs + i * block, rest, rule);
+    }
+
+    std::copy(quotient_limbs, quotient_limbs + (numerator_size - divisor_size + 1), quotient);
+    shift_right_limbs(a + padding, divisor_size, shift, remainder);
+}
+
+// Newton from Newton_threshold limbs of divisor, Burnikel-Ziegler from Burnikel_Ziegler_threshold,
+// schoolbook below
+void automatic_divide(
+    uint const *numerator,
+    size_t numerator_size,
+    uint const *divisor,
+    size_t divisor_size,
+    uint *quotient,
+    uint *remainder,
+    uint *scratch,
+    big_integer::multiplication_rule rule)
+{
+    if (divisor_size >= big_integer::Newton_threshold) {
+        newton_divide(numerator, numerator_size, divisor, divisor_size, quotient, remainder, scratch, rule);
+    } else if (divisor_size >= big_integer::Burnikel_Ziegler_threshold) {
+        burnikel_ziegler_divide(numerator, numerator_size, divisor, divisor_size, quotient, remainder, scratch, rule);
+    } else {
+        schoolbook_division_kernel(numerator, numerator_size, divisor, divisor_size, quotient, remainder, scratch, rule);
+    }
+}
+
+size_t automatic_division_scratch_size(
+    size_t numerator_size,
+    size_t divisor_size,
+    big_integer::multiplication_rule rule) noexcept
+{
+    if (divisor_size >= big_integer::Newton_threshold) {
+        return newton_scratch_size(numerator_size, divisor_size, rule);
+    }
+    return divisor_size >= big_integer::Burnikel_Ziegler_threshold
+        ? burnikel_ziegler_scratch_size(numerator_size, divisor_size, rule)
+        : schoolbook_division_scratch_size(numerator_size, divisor_size, rule);
+}
+
 }
 
 big_integer &big_integer::Burnikel_Ziegler_division::divide(
@@ -506,7 +1808,8 @@ big_integer &big_integer::Burnikel_Ziegler_division::divide(
     big_integer const &divisor,
     big_integer::multiplication_rule multiplication_rule) const
 {
-    throw not_implemented("big_integer &big_integer::Burnikel_Ziegler_division::divide(big_integer &, big_integer const &, big_integer::multiplication_rule)", "your code should be here...");
+    divide_magnitudes(dividend, divisor, &dividend, nullptr, burnikel_ziegler_divide, burnikel_ziegler_scratch_size, multiplication_rule);
+    return dividend;
 }
 
 big_integer &big_integer::Burnikel_Ziegler_division::modulo(
@@ -514,7 +1817,26 @@ big_integer &big_integer::Burnikel_Ziegler_division::modulo(
     big_integer const &divisor,
     big_integer::multiplication_rule multiplication_rule) const
 {
-    throw not_implemented("big_integer &big_integer::Burnikel_Ziegler_division::modulo(big_integer &, big_integer const &, big_integer::multiplication_rule)", "your code should be here...");
+    divide_magnitudes(dividend, divisor, nullptr, &dividend, burnikel_ziegler_divide, burnikel_ziegler_scratch_size, multiplication_rule);
+    return dividend;
+}
+
+big_integer &big_integer::automatic_division::divide(
+    big_integer &dividend,
+    big_integer const &divisor,
+    big_integer::multiplication_rule multiplication_rule) const
+{
+    divide_magnitudes(dividend, divisor, &dividend, nullptr, automatic_divide, automatic_division_scratch_size, multiplication_rule);
+    return dividend;
+}
+
+big_integer &big_integer::automatic_division::modulo(
+    big_integer &dividend,
+    big_integer const &divisor,
+    big_integer::multiplication_rule multiplication_rule) const
+{
+    divide_magnitudes(dividend, divisor, nullptr, &dividend, automatic_divide, automatic_division_scratch_size, multiplication_rule);
+    return dividend;
 }
 
 std::vector<int> big_integer::convert_string_to_vector(std::string value_as_string, size_t index)
@@ -755,15 +2077,15 @@ big_integer::big_integer(std::vector<unsigned int> const &digits)
     }
     if (digits[digits_count - 1] < default_base) {
         _oldest_digit = digits[digits_count - 1];
-        _other_digits = new unsigned int[digits_count];
+        _other_digits = static_cast<unsigned int *>(allocate_with_guard(sizeof(unsigned int), digits_count));
         *_other_digits = digits_count;
 
-        for (auto i = 0; i < digits_count; ++i) {
+        for (auto i = 0; i < digits_count - 1; ++i) {
             _other_digits[1 + i] = *reinterpret_cast<unsigned int const *>(&digits[i]);
         }
         return;
     }
-    _other_digits = new unsigned int[digits_count + 1];
+    _other_digits = static_cast<unsigned int *>(allocate_with_guard(sizeof(unsigned int), digits_count + 1));
     *_other_digits = digits_count + 1;
 
     for (auto i = 0; i < digits_count; ++i) {
@@ -1045,7 +2367,7 @@ big_integer big_integer::operator-(
 
 big_integer &big_integer::operator*=(big_integer const &other)
 {
-    return multiply(*this, other);
+    return multiply(*this, other, nullptr, multiplication_rule::automatic);
 }
 
 big_integer big_integer::operator*(big_integer const &other) const
@@ -1065,7 +2387,7 @@ big_integer big_integer::operator*(std::pair<big_integer, allocator *> const &ot
 
 big_integer &big_integer::operator/=(big_integer const &other)
 {
-    return divide(*this, other);
+    return divide(*this, other, nullptr, division_rule::automatic, multiplication_rule::automatic);
 }
 
 big_integer big_integer::operator/(big_integer const &other) const
@@ -1087,7 +2409,7 @@ big_integer big_integer::operator/(
 big_integer &big_integer::operator%=(
     big_integer const &other)
 {
-    return modulo(*this, other);
+    return modulo(*this, other, nullptr, division_rule::automatic, multiplication_rule::automatic);
 }
 
 //rem
@@ -1363,29 +2685,20 @@ big_integer big_integer::operator>>(
 big_integer &big_integer::multiply(
     big_integer &first_multiplier,
     big_integer const &second_multiplier,
-    allocator *allocator,
+    [[maybe_unused]] allocator *allocator,
     big_integer::multiplication_rule multiplication_rule)
 {
-    big_integer::multiplication * _mult;
+    // the strategies keep no state, the product takes memory from first_multiplier's allocator
     switch (multiplication_rule) {
-        case multiplication_rule::trivial:
-            try {
-                if (allocator) {
-                    _mult = static_cast<big_integer::trivial_multiplication *>(allocator->allocate(sizeof(big_integer::trivial_multiplication), 1));
-                } else {
-                    _mult = new big_integer::trivial_multiplication;
-                }
-            } catch(const std::bad_alloc& e) {
-                throw e;
-            }
-            first_multiplier = _mult->multiply(first_multiplier, second_multiplier);
-    }
-    if (allocator) {
-        allocator->deallocate(_mult);
-    } else {
-        delete _mult;
+        case multiplication_rule::Karatsuba:
+            return Karatsuba_multiplication().multiply(first_multiplier, second_multiplier);
+        case multiplication_rule::SchonhageStrassen:
+            return Schonhage_Strassen_multiplication().multiply(first_multiplier, second_multiplier);
+        case multiplication_rule::automatic:
+            return automatic_multiplication().multiply(first_multiplier, second_multiplier);
+        default:
+            return trivial_multiplication().multiply(first_multiplier, second_multiplier);
     }
-    return first_multiplier;
 }
 
 big_integer big_integer::multiply(
@@ -1394,53 +2707,29 @@ big_integer big_integer::multiply(
     allocator *allocator,
     big_integer::multiplication_rule multiplication_rule)
 {
-    big_integer::multiplication * _mult;
-    big_integer * tmp;
-    switch (multiplication_rule)
-    {
-        case multiplication_rule::trivial:
-            try {
-                if (allocator) {
-                    _mult = static_cast<big_integer::trivial_multiplication *>(allocator->allocate(sizeof(big_integer::trivial_multiplication), 1));
-                } else {
-                    _mult = new big_integer::trivial_multiplication;
-                }
-            } catch(const std::bad_alloc& e) {
-                throw e;
-            }
-            *tmp = first_multiplier;
-            *tmp = _mult->multiply(*tmp, second_multiplier);
-    }
-    if (allocator) allocator->deallocate(_mult);
-    else delete _mult;
-    return *tmp;
+    big_integer product(first_multiplier);
+    multiply(product, second_multiplier, allocator, multiplication_rule);
+    return product;
 }
 
 big_integer &big_integer::divide(
     big_integer &dividend,
     big_integer const &divisor,
-    allocator *allocator,
+    [[maybe_unused]] allocator *allocator,
     big_integer::division_rule division_rule,
     big_integer::multiplication_rule multiplication_rule)
 {
-    big_integer::division * _div;
+    // the strategies keep no state, the quotient takes memory from dividend's allocator
     switch (division_rule) {
-        case division_rule::trivial:
-            try {
-                if (allocator) {
-                    _div = static_cast<big_integer::trivial_division *>(allocator->allocate(sizeof(big_integer::trivial_division), 1));
-                } else {
-                    _div = new big_integer::trivial_division;
-                }
-            } catch(const std::bad_alloc& e) {
-                throw e;
-            }
-            dividend =_div->divide(dividend, divisor, multiplication_rule);
-            break;
+        case division_rule::Newton:
+            return Newton_division().divide(dividend, divisor, multiplication_rule);
+        case division_rule::BurnikelZiegler:
+            return Burnikel_Ziegler_division().divide(dividend, divisor, multiplication_rule);
+        case division_rule::automatic:
+            return automatic_division().divide(dividend, divisor, multiplication_rule);
+        default:
+            return trivial_division().divide(dividend, divisor, multiplication_rule);
     }
-    if (allocator) allocator->deallocate(_div);
-    else delete _div;
-    return dividend;
 }
 
 big_integer big_integer::divide(
@@ -1450,50 +2739,27 @@ big_integer big_integer::divide(
     big_integer::division_rule division_rule,
     big_integer::multiplication_rule multiplication_rule)
 {
-    big_integer::division * _div;
-    big_integer * tmp;
-    switch (division_rule)
-    {
-        case division_rule::trivial:
-            try
-            {
-                if (allocator) _div = static_cast<big_integer::trivial_division *>(allocator->allocate(sizeof(big_integer::trivial_division), 1));
-                else _div = new big_integer::trivial_division;
-            }
-            catch(const std::bad_alloc& e)
-            {
-                throw e;
-            }
-            *tmp = dividend;
-            *tmp = _div->divide(*tmp, divisor, multiplication_rule);
-            break;
-    }
-    if (allocator) allocator->deallocate(_div);
-    else delete _div;
-    return *tmp;
+    big_integer quotient(dividend);
+    divide(quotient, divisor, allocator, division_rule, multiplication_rule);
+    return quotient;
 }
 
 big_integer &big_integer::modulo(
     big_integer &dividend,
     big_integer const &divisor,
-    allocator *allocator,
+    [[maybe_unused]] allocator *allocator,
     big_integer::division_rule division_rule,
     big_integer::multiplication_rule multiplication_rule)
 {
-    big_integer::division * _div;
-    switch (division_rule)
-    {
-        case division_rule::trivial:
-            try {
-                if (allocator) {
-                    _div = static_cast<big_integer::trivial_division *>(allocator->allocate(sizeof(big_integer::trivial_division), 1));
-                } else {
-                    _div = new big_integer::trivial_division;
-                }
-            } catch(const std::bad_alloc& e) {
-                throw e;
-            }
-            return _div->modulo(dividend, divisor, multiplication_rule);
+    switch (division_rule) {
+        case division_rule::Newton:
+            return Newton_division().modulo(dividend, divisor, multiplication_rule);
+        case division_rule::BurnikelZiegler:
+            return Burnikel_Ziegler_division().modulo(dividend, divisor, multiplication_rule);
+        case division_rule::automatic:
+            return automatic_division().modulo(dividend, divisor, multiplication_rule);
+        default:
+            return trivial_division().modulo(dividend, divisor, multiplication_rule);
     }
 }
 
@@ -1504,21 +2770,61 @@ big_integer big_integer::modulo(
     big_integer::division_rule division_rule,
     big_integer::multiplication_rule multiplication_rule)
 {
-    big_integer::division * _div;
+    big_integer remainder(dividend);
+    modulo(remainder, divisor, allocator, division_rule, multiplication_rule);
+    return remainder;
+}
+
+void big_integer::configure_thresholds(
+    std::string const &configuration_file_path,
+    std::string const &configuration_path)
+{
+    std::ifstream configuration_file(configuration_file_path, std::ios::binary);
+    if (!configuration_file.is_open()) {
+        throw std::runtime_error("Configuration file doesn't exist\n");
+    }
+    if (configuration_file.peek() == EOF) {
+        throw std::runtime_error("Can't find configuration path\n");
+    }
+
+    nlohmann::json configuration;
+    configuration_file >> configuration;
+    if (configuration.find(configuration_path) == configuration.end()) {
+        throw std::runtime_error("Can't find configuration path\n");
+    }
+
+    auto const &node = configuration[configuration_path];
+    Karatsuba_threshold = node.value("Karatsuba_threshold", Karatsuba_threshold);
+    Schonhage_Strassen_threshold = node.value("Schonhage_Strassen_threshold", Schonhage_Strassen_threshold);
+    Schonhage_Strassen_threads = node.value("Schonhage_Strassen_threads", Schonhage_Strassen_threads);
+    Burnikel_Ziegler_threshold = node.value("Burnikel_Ziegler_threshold", Burnikel_Ziegler_threshold);
+    Newton_threshold = node.value("Newton_threshold", Newton_threshold);
+}
+
+std::pair<big_integer, big_integer> big_integer::divmod(
+    big_integer const &dividend,
+    big_integer const &divisor,
+    allocator *allocator,
+    big_integer::division_rule division_rule,
+    big_integer::multiplication_rule multiplication_rule)
+{
+    big_integer quotient("0", 10, allocator);
+    big_integer remainder("0", 10, allocator);
     switch (division_rule) {
-        case division_rule::trivial:
-            try {
-                if (allocator) {
-                    _div = static_cast<big_integer::trivial_division *>(allocator->allocate(sizeof(big_integer::trivial_division), 1));
-                } else {
-                    _div = new big_integer::trivial_division;
-                }
-            } catch(const std::bad_alloc& e) {
-                throw e;
-            }
-            big_integer tmp(dividend);
-            return _div->modulo(tmp, divisor, multiplication_rule);
+        case division_rule::Newton:
+            divide_magnitudes(dividend, divisor, &quotient, &remainder, newton_divide, newton_scratch_size, multiplication_rule);
+            break;
+        case division_rule::BurnikelZiegler:
+            divide_magnitudes(dividend, divisor, &quotient, &remainder, burnikel_ziegler_divide, burnikel_ziegler_scratch_size, multiplication_rule);
+            break;
+        case division_rule::automatic:
+            divide_magnitudes(dividend, divisor, &quotient, &remainder, automatic_divide, automatic_division_scratch_size, multiplication_rule);
+            break;
+        default:
+            divide_magnitudes(dividend, divisor, &quotient, &remainder, schoolbook_division_kernel, schoolbook_division_scratch_size, multiplication_rule);
+            break;
     }
+    return { std::move(quotient), std::move(remainder) };
 }
 
 std::ostream &operator<<(
@@ -1548,12 +2854,12 @@ big_integer &big_integer::change_sign()
     return *this;
 }
 
-inline bool big_integer::is_zero() const noexcept
+bool big_integer::is_zero() const noexcept
 {
     return _oldest_digit == 0 && !_other_digits;
 }
 
-inline int big_integer::sign() const noexcept
+int big_integer::sign() const noexcept
 {
     if (is_zero()) {
         return 0;
@@ -1561,7 +2867,7 @@ inline int big_integer::sign() const noexcept
     return 1 - (static_cast<int>((*reinterpret_cast<uint const *>(&_oldest_digit) >> ((sizeof(int) << 3) - 1))) << 1);
 }
 
-inline uint big_integer::get_digit(int index) const noexcept
+uint big_integer::get_digit(int index) const noexcept
 {
     if (!_other_digits) {
         return index == 0 ? _oldest_digit : 0;
@@ -1577,7 +2883,7 @@ inline uint big_integer::get_digit(int index) const noexcept
     return 0;
 }
 
-inline int big_integer::get_size() const noexcept
+int big_integer::get_size() const noexcept
 {
     return static_cast<int>(!_other_digits ? 1 : *_other_digits);
 }
@@ -164,6 +164,47 @@ TEST(positive_tests, test7)
     delete logger;
 }
 
+TEST(positive_tests, test8)
+{
+    logger *logger = create_logger(std::vector<std::pair<std::string, logger::severity>>
+                                       {
+                                           {
+                                               "bigint_logs.txt",
+                                               logger::severity::information
+                                           },
+                                       });
+
+    // a divisor long enough for the recursion to reach several levels below the schoolbook blocks
+    std::vector<int> divisor_digits(200), quotient_digits(450), remainder_digits(199);
+    for (size_t i = 0; i < divisor_digits.size(); ++i) {
+        divisor_digits[i] = static_cast<int>((i * 2654435761u) & 0x7FFFFFFFu);
+    }
+    for (size_t i = 0; i < quotient_digits.size(); ++i) {
+        quotient_digits[i] = static_cast<int>((i * 40503u + 7) & 0x7FFFFFFFu);
+    }
+    for (size_t i = 0; i < remainder_digits.size(); ++i) {
+        remainder_digits[i] = static_cast<int>((i * 97u + 3) & 0x7FFFFFFFu);
+    }
+    big_integer divisor(divisor_digits);
+    big_integer quotient(quotient_digits);
+    big_integer remainder(remainder_digits);
+    quotient.change_sign();
+    remainder.change_sign();
+
+    big_integer dividend(quotient);
+    big_integer::multiply(dividend, divisor, nullptr, big_integer::multiplication_rule::Karatsuba);
+    dividend += remainder;
+
+    for (auto rule : {big_integer::multiplication_rule::trivial, big_integer::multiplication_rule::Karatsuba}) {
+        auto [bigint_1, bigint_2] = big_integer::divmod(dividend, divisor, nullptr, big_integer::division_rule::BurnikelZiegler, rule);
+
+        EXPECT_TRUE(bigint_1 == quotient);
+        EXPECT_TRUE(bigint_2 == remainder);
+    }
+
+    delete logger;
+}
+
 int main(
     int argc,
     char **argv)
@@ -165,6 +165,60 @@ TEST(positive_tests, test7)
     delete logger;
 }
 
+TEST(positive_tests, test8)
+{
+    logger *logger = create_logger(std::vector<std::pair<std::string, logger::severity>>
+                                       {
+                                           {
+                                               "bigint_logs.txt",
+                                               logger::severity::information
+                                           },
+                                       });
+
+    std::string first_digits;
+    std::string second_digits;
+    for (int i = 0; i < 120; ++i) {
+        first_digits += "123456789";
+    }
+    for (int i = 0; i < 40; ++i) {
+        second_digits += "987654321";
+    }
+    big_integer bigint_1(first_digits);
+    big_integer bigint_2("-" + second_digits);
+    big_integer bigint_3(bigint_1);
+    big_integer::multiply(bigint_1, bigint_2, nullptr, big_integer::multiplication_rule::Karatsuba);
+    big_integer::multiply(bigint_3, bigint_2, nullptr, big_integer::multiplication_rule::trivial);
+
+    EXPECT_TRUE(bigint_1 == bigint_3);
+    EXPECT_TRUE(bigint_1.sign() < 0);
+
+    delete logger;
+}
+
+TEST(positive_tests, test9)
+{
+    logger *logger = create_logger(std::vector<std::pair<std::string, logger::severity>>
+                                       {
+                                           {
+                                               "bigint_logs.txt",
+                                               logger::severity::information
+                                           },
+                                       });
+
+    std::string digits;
+    for (int i = 0; i < 100; ++i) {
+        digits += "9999999999";
+    }
+    big_integer bigint_1(digits);
+    big_integer bigint_2(bigint_1);
+    big_integer::multiply(bigint_1, bigint_1, nullptr, big_integer::multiplication_rule::Karatsuba);
+    big_integer::multiply(bigint_2, bigint_2, nullptr, big_integer::multiplication_rule::trivial);
+
+    EXPECT_TRUE(bigint_1 == bigint_2);
+
+    delete logger;
+}
+
 int main(
     int argc,
     char **argv)
@@ -165,6 +165,46 @@ TEST(positive_tests, test7)
     delete logger;
 }
 
+TEST(positive_tests, test8)
+{
+    logger *logger = create_logger(std::vector<std::pair<std::string, logger::severity>>
+                                       {
+                                           {
+                                               "bigint_logs.txt",
+                                               logger::severity::information
+                                           },
+                                       });
+
+    // transforms of 8192 points, larger than a cache block, on every thread count of use
+    std::vector<int> first_digits(3000);
+    std::vector<int> second_digits(2500);
+    uint32_t state = 1;
+    for (auto &digit : first_digits) {
+        digit = static_cast<int>(state = state * 1664525u + 1013904223u);
+    }
+    for (auto &digit : second_digits) {
+        digit = static_cast<int>(state = state * 1664525u + 1013904223u);
+    }
+    first_digits.back() &= 0x7FFFFFFF;
+    second_digits.back() = -1;
+    second_digits.push_back(0);
+
+    big_integer bigint_2(second_digits);
+    big_integer expected(first_digits);
+    big_integer::multiply(expected, bigint_2, nullptr, big_integer::multiplication_rule::Karatsuba);
+
+    for (size_t threads : {1, 3}) {
+        big_integer::Schonhage_Strassen_threads = threads;
+        big_integer bigint_1(first_digits);
+        big_integer::multiply(bigint_1, bigint_2, nullptr, big_integer::multiplication_rule::SchonhageStrassen);
+
+        EXPECT_TRUE(bigint_1 == expected);
+    }
+    big_integer::Schonhage_Strassen_threads = 1;
+
+    delete logger;
+}
+
 int main(
     int argc,
     char **argv)
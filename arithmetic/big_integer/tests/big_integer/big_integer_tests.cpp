@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <fstream>
+
 #include <big_integer.h>
 #include <client_logger.h>
 #include <operation_not_supported.h>
@@ -236,6 +238,52 @@ TEST(positive_tests, test10)
     delete logger;
 }
 
+TEST(positive_tests, test11)
+{
+    logger *logger = create_logger(std::vector<std::pair<std::string, logger::severity>>
+        {
+            {
+                "bigint_logs.txt",
+                logger::severity::information
+            },
+        });
+
+    // thresholds low enough for the operators to go through every rule automatic picks
+    {
+        std::ofstream configuration("big_integer_thresholds.json");
+        configuration << R"({"big_integer": {"Schonhage_Strassen_threshold": 300, "Burnikel_Ziegler_threshold": 50, "Newton_threshold": 400}})";
+    }
+    size_t const thresholds[] = {big_integer::Schonhage_Strassen_threshold, big_integer::Burnikel_Ziegler_threshold, big_integer::Newton_threshold};
+    big_integer::configure_thresholds("big_integer_thresholds.json");
+    EXPECT_EQ(big_integer::Schonhage_Strassen_threshold, 300);
+    EXPECT_EQ(big_integer::Burnikel_Ziegler_threshold, 50);
+    EXPECT_EQ(big_integer::Newton_threshold, 400);
+
+    for (size_t limbs_count : {10, 100, 500}) {
+        std::vector<int> first_digits(2 * limbs_count), second_digits(limbs_count);
+        for (size_t i = 0; i < first_digits.size(); ++i) {
+            first_digits[i] = static_cast<int>((i * 2654435761u + 1) & 0x7FFFFFFFu);
+        }
+        for (size_t i = 0; i < second_digits.size(); ++i) {
+            second_digits[i] = static_cast<int>((i * 40503u + 7) & 0x7FFFFFFFu);
+        }
+        big_integer const bigint_1(first_digits);
+        big_integer const bigint_2(second_digits);
+
+        EXPECT_TRUE(bigint_1 * bigint_2 == big_integer::multiply(bigint_1, bigint_2, nullptr, big_integer::multiplication_rule::Karatsuba));
+        auto [quotient, remainder] = big_integer::divmod(bigint_1, bigint_2);
+        EXPECT_TRUE(bigint_1 / bigint_2 == quotient);
+        EXPECT_TRUE(bigint_1 % bigint_2 == remainder);
+    }
+
+    EXPECT_THROW(big_integer::configure_thresholds("nonexistent_thresholds.json"), std::runtime_error);
+    big_integer::Schonhage_Strassen_threshold = thresholds[0];
+    big_integer::Burnikel_Ziegler_threshold = thresholds[1];
+    big_integer::Newton_threshold = thresholds[2];
+
+    delete logger;
+}
+
 int main(
     int argc,
     char **argv)
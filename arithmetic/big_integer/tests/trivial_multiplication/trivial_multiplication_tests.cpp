@@ -167,6 +167,24 @@ TEST(positive_tests, test7)
     delete logger;
 }
 
+TEST(positive_tests, test8)
+{
+    logger *logger = create_logger(std::vector<std::pair<std::string, logger::severity>>
+                                       {
+                                           {
+                                               "bigint_logs.txt",
+                                               logger::severity::information
+                                           },
+                                       });
+
+    big_integer bigint_1("-9999999999999999999999999999999999999999");
+    big_integer::multiply(bigint_1, bigint_1, nullptr, big_integer::multiplication_rule::trivial);
+
+    EXPECT_TRUE((std::ostringstream() << bigint_1).str() == "99999999999999999999999999999999999999980000000000000000000000000000000000000001");
+
+    delete logger;
+}
+
 int main(
     int argc,
     char **argv)
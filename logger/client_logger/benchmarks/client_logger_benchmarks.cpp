@@ -0,0 +1,614 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#include <async_io.h>
+#include <client_logger.h>
+#include <client_logger_builder.h>
+
+using benchmark_clock = std::chrono::steady_clock;
+
+constexpr char const *benchmark_file = "client_logger_benchmark.txt";
+
+logger *create_logger(
+    size_t async_capacity,
+    overflow_policy policy = overflow_policy::block)
+{
+    client_logger_builder builder;
+    builder.add_file_stream(benchmark_file, logger::severity::information);
+    builder.set_async(async_capacity, policy);
+    return builder.build();
+}
+
+// caller-side latency and end-to-end throughput (until the last record is on disk)
+void producers_benchmark(
+    std::string const &name,
+    size_t async_capacity,
+    overflow_policy policy,
+    size_t producers_count,
+    size_t records_per_producer)
+{
+    std::vector<std::vector<double>> latencies(producers_count);
+    auto start = benchmark_clock::now();
+
+    logger *logger_instance = create_logger(async_capacity, policy);
+    std::vector<std::thread> producers;
+    for (size_t i = 0; i < producers_count; ++i) {
+        producers.emplace_back([&, i]() {
+            latencies[i].reserve(records_per_producer);
+            for (size_t j = 0; j < records_per_producer; ++j) {
+                auto call_start = benchmark_clock::now();
+                logger_instance->information("benchmark record with a typical payload size of several dozen bytes");
+                latencies[i].push_back(std::chrono::duration<double, std::nano>(benchmark_clock::now() - call_start).count());
+            }
+        });
+    }
+    for (auto &producer : producers) {
+        producer.join();
+    }
+    size_t dropped = dynamic_cast<client_logger *>(logger_instance)->dropped_records();
+    delete logger_instance;
+
+    double seconds = std::chrono::duration<double>(benchmark_clock::now() - start).count();
+
+    std::vector<double> all;
+    for (auto &thread_latencies : latencies) {
+        all.insert(all.end(), thread_latencies.begin(), thread_latencies.end());
+    }
+    std::sort(all.begin(), all.end());
+    double mean = 0;
+    for (auto latency : all) {
+        mean += latency;
+    }
+    mean /= all.size();
+
+    std::printf("%-28s threads=%2zu  mean=%8.0f ns  p50=%8.0f ns  p99=%9.0f ns  throughput=%10.0f rec/s  dropped=%zu\n",
+        name.c_str(), producers_count, mean, all[all.size() / 2], all[all.size() * 99 / 100],
+        (producers_count * records_per_producer) / seconds, dropped);
+    std::remove(benchmark_file);
+}
+
+void async_benchmarks()
+{
+    size_t constexpr records_total = 1 << 18;
+
+    for (size_t producers_count : {1, 2, 4, 8, 16}) {
+        size_t records_per_producer = records_total / producers_count;
+        producers_benchmark("sync", 0, overflow_policy::block, producers_count, records_per_producer);
+        producers_benchmark("async block", 1 << 14, overflow_policy::block, producers_count, records_per_producer);
+        producers_benchmark("async drop_oldest", 1 << 14, overflow_policy::drop_oldest, producers_count, records_per_producer);
+        producers_benchmark("async drop", 1 << 14, overflow_policy::drop, producers_count, records_per_producer);
+    }
+}
+
+// formatting dominated: synchronous writes of a full format into /dev/null
+void format_benchmarks()
+{
+    size_t constexpr records_count = 1 << 20;
+    std::string format = "%d %t [%s] %m";
+
+    client_logger_builder builder;
+    builder.add_file_stream("/dev/null", logger::severity::information);
+    builder.set_format(format);
+    logger *logger_instance = builder.build();
+
+    auto start = benchmark_clock::now();
+    for (size_t i = 0; i < records_count; ++i) {
+        logger_instance->information("benchmark record with a typical payload size of several dozen bytes");
+    }
+    double nanoseconds = std::chrono::duration<double, std::nano>(benchmark_clock::now() - start).count();
+    delete logger_instance;
+
+    std::printf("%-28s %8.0f ns/record\n", "format \"%d %t [%s] %m\"", nanoseconds / records_count);
+}
+
+// write syscalls issued by this process so far, linux only
+size_t write_syscalls()
+{
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    size_t value;
+    while (io >> key >> value) {
+        if (key == "syscw:") {
+            return value;
+        }
+    }
+    return 0;
+}
+
+void flush_policy_benchmark(
+    std::string const &name,
+    flush_policy policy,
+    size_t async_capacity)
+{
+    size_t constexpr records_count = 1 << 20;
+
+    client_logger_builder builder;
+    builder.add_file_stream(benchmark_file, logger::severity::information);
+    builder.set_async(async_capacity);
+    builder.set_flush_policy(policy);
+
+    size_t syscalls_before = write_syscalls();
+    auto start = benchmark_clock::now();
+
+    logger *logger_instance = builder.build();
+    for (size_t i = 0; i < records_count; ++i) {
+        logger_instance->information("benchmark record with a typical payload size of several dozen bytes");
+    }
+    delete logger_instance;
+
+    double seconds = std::chrono::duration<double>(benchmark_clock::now() - start).count();
+    size_t syscalls = write_syscalls() - syscalls_before;
+
+    std::printf("%-28s %10.4f syscalls/record  throughput=%10.0f rec/s\n",
+        name.c_str(), static_cast<double>(syscalls) / records_count, records_count / seconds);
+    std::remove(benchmark_file);
+}
+
+void flush_policy_benchmarks()
+{
+    flush_policy every_record;
+
+    flush_policy on_error;
+    on_error.severity = logger::severity::error;
+
+    flush_policy by_size;
+    by_size.severity = logger::severity::error;
+    by_size.bytes = 1 << 14;
+
+    flush_policy by_time;
+    by_time.severity = logger::severity::error;
+    by_time.interval = std::chrono::milliseconds(100);
+
+    flush_policy_benchmark("sync flush every record", every_record, 0);
+    flush_policy_benchmark("sync flush on error", on_error, 0);
+    flush_policy_benchmark("sync flush every 16 KiB", by_size, 0);
+    flush_policy_benchmark("sync flush every 100 ms", by_time, 0);
+    flush_policy_benchmark("async flush every batch", every_record, 1 << 14);
+    flush_policy_benchmark("async flush on error", on_error, 1 << 14);
+}
+
+// the common case in hot loops: a trace call nobody listens to
+void suppressed_benchmarks()
+{
+    size_t constexpr calls_count = 1 << 24;
+
+    for (size_t async_capacity : {0, 1 << 14}) {
+        client_logger_builder builder;
+        builder.add_file_stream("/dev/null", logger::severity::information);
+        builder.add_file_stream("/dev/null", logger::severity::warning);
+        builder.add_file_stream(benchmark_file, logger::severity::error);
+        builder.set_async(async_capacity);
+        logger *logger_instance = builder.build();
+
+        std::string const message = "suppressed record";
+        auto start = benchmark_clock::now();
+        for (size_t i = 0; i < calls_count; ++i) {
+            logger_instance->trace(message);
+        }
+        double nanoseconds = std::chrono::duration<double, std::nano>(benchmark_clock::now() - start).count();
+        delete logger_instance;
+
+        std::printf("%-28s %8.2f ns/call\n", async_capacity == 0 ? "suppressed trace (sync)" : "suppressed trace (async)", nanoseconds / calls_count);
+    }
+    std::remove(benchmark_file);
+}
+
+// a burst of trace records from a hot loop: unlimited, sampled 1 in 100 and rate limited
+void rate_limit_benchmarks()
+{
+    size_t constexpr calls_count = 1 << 20;
+
+    struct variant
+    {
+        char const *name;
+        rate_limit limit;
+    };
+    for (auto &[name, limit] : { variant{ "trace unlimited", rate_limit{} },
+                                 variant{ "trace sampled 1/100", rate_limit{ 0, 0, 100 } },
+                                 variant{ "trace limited 10k/s", rate_limit{ 10000, 1000 } } }) {
+        std::string line_format = "%d %t [%s] %m";
+        client_logger_builder builder;
+        builder.add_file_stream(benchmark_file, logger::severity::trace);
+        builder.set_format(line_format);
+        builder.set_rate_limit(logger::severity::trace, limit);
+        logger *logger_instance = builder.build();
+
+        auto start = benchmark_clock::now();
+        for (size_t i = 0; i < calls_count; ++i) {
+            logger_instance->log(logger::severity::trace, "node {} rotated left, height {}", i, i & 31);
+        }
+        double nanoseconds = std::chrono::duration<double, std::nano>(benchmark_clock::now() - start).count();
+        delete logger_instance;
+
+        auto bytes = std::filesystem::file_size(benchmark_file);
+        std::printf("%-28s %8.2f ns/call  %10zu bytes written\n", name, nanoseconds / calls_count, static_cast<size_t>(bytes));
+        std::remove(benchmark_file);
+    }
+}
+
+// caller-side latency while the file rotates underneath, the tail is what rotation costs
+void rotation_benchmarks()
+{
+    size_t constexpr records_count = 1 << 20;
+
+    rotation_policy by_size;
+    by_size.bytes = 4 << 20;
+    by_size.kept_segments = 2;
+
+    for (auto &[name, rotation] : { std::pair{ "no rotation", rotation_policy() }, std::pair{ "rotation every 4 MiB", by_size } }) {
+        flush_policy on_error;
+        on_error.severity = logger::severity::error;
+
+        client_logger_builder builder;
+        builder.add_file_stream(benchmark_file, logger::severity::information);
+        builder.set_flush_policy(on_error);
+        builder.set_rotation(rotation);
+        logger *logger_instance = builder.build();
+
+        std::vector<double> latencies;
+        latencies.reserve(records_count);
+        for (size_t i = 0; i < records_count; ++i) {
+            auto call_start = benchmark_clock::now();
+            logger_instance->information("benchmark record with a typical payload size of several dozen bytes");
+            latencies.push_back(std::chrono::duration<double, std::nano>(benchmark_clock::now() - call_start).count());
+        }
+        delete logger_instance;
+
+        std::sort(latencies.begin(), latencies.end());
+        std::printf("%-28s p50=%6.0f ns  p99.9=%8.0f ns  max=%9.0f ns\n",
+            name, latencies[latencies.size() / 2], latencies[latencies.size() * 999 / 1000], latencies.back());
+        std::remove(benchmark_file);
+        for (size_t index = 1; index <= 256; ++index) {
+            std::remove((std::string(benchmark_file) + "." + std::to_string(index)).c_str());
+        }
+    }
+}
+
+double process_cpu_nanoseconds()
+{
+    timespec now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+// the same records as formatted text and as binary entries formatted later by the decoder
+void structured_benchmarks()
+{
+    size_t constexpr records_count = 1 << 20;
+    auto format = structured::register_format("allocated block {} of {} bytes at offset {} in pool {}");
+    std::string const pool = "global";
+
+    flush_policy on_error;
+    on_error.severity = logger::severity::error;
+
+    for (bool binary : {false, true}) {
+        std::string line_format = "%d %t [%s] %m";
+        client_logger_builder builder;
+        if (binary) {
+            builder.add_binary_file_stream(benchmark_file, logger::severity::information);
+        } else {
+            builder.add_file_stream(benchmark_file, logger::severity::information);
+        }
+        builder.set_format(line_format);
+        builder.set_flush_policy(on_error);
+
+        double cpu_start = process_cpu_nanoseconds();
+        logger *logger_instance = builder.build();
+        auto *structured_logger = dynamic_cast<client_logger *>(logger_instance);
+        for (size_t i = 0; i < records_count; ++i) {
+            structured_logger->log_structured(logger::severity::information, format, i, 64 + (i & 1023), i * 64, pool);
+        }
+        delete logger_instance;
+        double cpu = process_cpu_nanoseconds() - cpu_start;
+
+        auto bytes = std::filesystem::file_size(benchmark_file);
+        std::printf("%-28s %8.1f bytes/record  cpu=%8.0f ns/record\n",
+            binary ? "structured binary" : "structured text", static_cast<double>(bytes) / records_count, cpu / records_count);
+        std::remove(benchmark_file);
+    }
+}
+
+// many threads writing one file: through the locked ofstream and through the mapping
+void mapped_benchmarks()
+{
+    size_t constexpr records_total = 1 << 21;
+
+    flush_policy on_error;
+    on_error.severity = logger::severity::error;
+
+    for (size_t producers_count : {1, 4, 16, 32}) {
+        for (bool mapped : {false, true}) {
+            std::string line_format = "%m";
+            client_logger_builder builder;
+            if (mapped) {
+                builder.add_mapped_file_stream(benchmark_file, logger::severity::information);
+            } else {
+                builder.add_file_stream(benchmark_file, logger::severity::information);
+            }
+            builder.set_format(line_format);
+            builder.set_flush_policy(on_error);
+
+            size_t syscalls_before = write_syscalls();
+            auto start = benchmark_clock::now();
+
+            logger *logger_instance = builder.build();
+            std::vector<std::thread> producers;
+            for (size_t i = 0; i < producers_count; ++i) {
+                producers.emplace_back([&]() {
+                    for (size_t j = 0; j < records_total / producers_count; ++j) {
+                        logger_instance->information("benchmark record with a typical payload size of several dozen bytes");
+                    }
+                });
+            }
+            for (auto &producer : producers) {
+                producer.join();
+            }
+            delete logger_instance;
+
+            double seconds = std::chrono::duration<double>(benchmark_clock::now() - start).count();
+            size_t syscalls = write_syscalls() - syscalls_before;
+
+            std::printf("%-28s threads=%2zu  throughput=%10.0f rec/s  %8.4f write syscalls/record\n",
+                mapped ? "mapped" : "ofstream", producers_count, records_total / seconds, static_cast<double>(syscalls) / records_total);
+            std::remove(benchmark_file);
+        }
+    }
+}
+
+// ratio and cpu of a compressed stream against a plain one, replaying the lines of log files
+// (those the allocator tests write, say) or, with none given, allocator-like trace lines
+void compressed_benchmarks(
+    std::vector<std::string> const &log_files)
+{
+    std::vector<std::string> lines;
+    for (auto &log_file : log_files) {
+        std::ifstream file(log_file);
+        std::string line;
+        while (std::getline(file, line)) {
+            lines.push_back(line);
+        }
+    }
+    if (lines.empty()) {
+        char const *events[] = { "[START] allocation", "[END] allocation", "[START] deallocation", "[END] deallocation" };
+        for (size_t i = 0; i < 1 << 18; ++i) {
+            lines.push_back(std::string("allocator_sorted_list ") + events[i % 4] + " of " + std::to_string(16 + (i * 37) % 1024) + " bytes");
+        }
+    }
+
+    size_t constexpr records_target = 1 << 20;
+    size_t repeats = std::max<size_t>(1, records_target / lines.size());
+
+    // the plain stream is not flushed per record either, both pay for formatting and writing only
+    flush_policy on_error;
+    on_error.severity = logger::severity::error;
+
+    for (bool compressed : {false, true}) {
+        std::string line_format = "%d %t [%s] %m";
+        client_logger_builder builder;
+        builder.set_flush_policy(on_error);
+        if (compressed) {
+            builder.add_compressed_file_stream(benchmark_file, logger::severity::trace);
+        } else {
+            builder.add_file_stream(benchmark_file, logger::severity::trace);
+        }
+        builder.set_format(line_format);
+
+        double cpu_start = process_cpu_nanoseconds();
+        logger *logger_instance = builder.build();
+        for (size_t i = 0; i < repeats; ++i) {
+            for (auto &line : lines) {
+                logger_instance->trace(line);
+            }
+        }
+        delete logger_instance;
+        double cpu = process_cpu_nanoseconds() - cpu_start;
+
+        size_t records_count = repeats * lines.size();
+        auto bytes = std::filesystem::file_size(benchmark_file);
+        std::printf("%-28s %8.1f bytes/record  cpu=%8.0f ns/record\n",
+            compressed ? "compressed" : "plain", static_cast<double>(bytes) / records_count, cpu / records_count);
+        std::remove(benchmark_file);
+    }
+}
+
+// cpu of every thread but the calling one, from /proc/self/task/*/schedstat (linux only)
+double other_threads_cpu_nanoseconds()
+{
+    double total = 0;
+    std::string self = std::to_string(gettid());
+    std::error_code error;
+    for (auto const &task : std::filesystem::directory_iterator("/proc/self/task", error)) {
+        if (task.path().filename() == self) {
+            continue;
+        }
+        std::ifstream schedstat(task.path() / "schedstat");
+        double nanoseconds = 0;
+        if (schedstat >> nanoseconds) {
+            total += nanoseconds;
+        }
+    }
+    return total;
+}
+
+// an asynchronous logger fanning every record out to 64 files: the flusher writing each
+// stream with its own write syscalls against handing buffers to the async_io_writer; writer
+// cpu is the flusher and the io threads, measured until the last record is in its file
+void async_io_logger_benchmarks()
+{
+    size_t constexpr streams_count = 64;
+    size_t constexpr records_count = 1 << 16;
+
+    // flushes come by size, as a busy logger would have them
+    flush_policy by_size;
+    by_size.severity = logger::severity::error;
+    by_size.bytes = 1 << 14;
+
+    for (bool async_io : {false, true}) {
+        std::string line_format = "%m";
+        client_logger_builder builder;
+        builder.set_format(line_format);
+        builder.set_async(1 << 14);
+        builder.set_flush_policy(by_size);
+        builder.set_async_io_buffer(1 << 14);
+        for (size_t i = 0; i < streams_count; ++i) {
+            std::string file_name = std::string(benchmark_file) + "." + std::to_string(i);
+            if (async_io) {
+                builder.add_async_io_file_stream(file_name, logger::severity::information);
+            } else {
+                builder.add_file_stream(file_name, logger::severity::information);
+            }
+        }
+
+        auto *logger_instance = dynamic_cast<client_logger *>(builder.build());
+        size_t syscalls_before = write_syscalls();
+        double writer_cpu_start = other_threads_cpu_nanoseconds();
+        auto start = benchmark_clock::now();
+
+        for (size_t i = 0; i < records_count; ++i) {
+            logger_instance->information("benchmark record with a typical payload size of several dozen bytes");
+        }
+        logger_instance->flush();
+
+        double seconds = std::chrono::duration<double>(benchmark_clock::now() - start).count();
+        double writer_cpu = other_threads_cpu_nanoseconds() - writer_cpu_start;
+        size_t syscalls = write_syscalls() - syscalls_before;
+        delete logger_instance;
+
+        size_t lines = records_count * streams_count;
+        std::printf("%-28s streams=%zu  throughput=%10.0f lines/s  writer cpu=%6.1f ns/line  %8.5f write syscalls/line\n",
+            async_io ? (async_io_writer::shared().kind() == async_io_writer::backend::io_uring ? "async io (io_uring)" : "async io (thread pool)") : "ofstream",
+            streams_count, lines / seconds, writer_cpu / lines, static_cast<double>(syscalls) / lines);
+        for (size_t i = 0; i < streams_count; ++i) {
+            std::remove((std::string(benchmark_file) + "." + std::to_string(i)).c_str());
+        }
+    }
+}
+
+// 64 files written a buffer at a time by one thread: a pwrite per buffer against each backend
+// of the async_io_writer; the cpu is the writing thread's, the one a logger would pay for
+void async_io_backend_benchmarks()
+{
+    size_t constexpr files_count = 64;
+    size_t constexpr buffer_bytes = 1 << 14;
+    size_t constexpr buffers_per_file = 256;
+
+    std::string buffer(buffer_bytes, 'x');
+    for (size_t i = 63; i < buffer.size(); i += 64) {
+        buffer[i] = '\n';
+    }
+
+    enum class method { pwrite, thread_pool, io_uring };
+    for (auto kind : {method::pwrite, method::thread_pool, method::io_uring}) {
+        std::unique_ptr<async_io_writer> writer;
+        try {
+            if (kind != method::pwrite) {
+                writer = std::make_unique<async_io_writer>(kind == method::io_uring ? async_io_writer::backend::io_uring : async_io_writer::backend::thread_pool);
+            }
+        } catch (std::runtime_error const &) {
+            std::printf("%-28s not available\n", "io_uring");
+            continue;
+        }
+
+        std::vector<int> descriptors;
+        std::vector<std::unique_ptr<async_io_file>> files;
+        for (size_t i = 0; i < files_count; ++i) {
+            std::string file_name = std::string(benchmark_file) + "." + std::to_string(i);
+            if (writer == nullptr) {
+                descriptors.push_back(open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+            } else {
+                files.push_back(std::make_unique<async_io_file>(file_name, buffer_bytes, async_io_file::default_buffers, false, *writer));
+            }
+        }
+
+        timespec thread_start;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &thread_start);
+        double process_start = process_cpu_nanoseconds();
+        auto start = benchmark_clock::now();
+
+        for (size_t round = 0; round < buffers_per_file; ++round) {
+            async_io_writer::batch submissions(writer.get());
+            for (size_t i = 0; i < files_count; ++i) {
+                if (writer == nullptr) {
+                    [[maybe_unused]] ssize_t written = pwrite(descriptors[i], buffer.data(), buffer.size(), static_cast<off_t>(round * buffer_bytes));
+                } else {
+                    files[i]->write(buffer.data(), buffer.size());
+                }
+            }
+        }
+        for (auto &file : files) {
+            file->wait();
+        }
+
+        double seconds = std::chrono::duration<double>(benchmark_clock::now() - start).count();
+        timespec thread_end;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &thread_end);
+        double thread_cpu = (thread_end.tv_sec - thread_start.tv_sec) * 1e9 + (thread_end.tv_nsec - thread_start.tv_nsec);
+        double process_cpu = process_cpu_nanoseconds() - process_start;
+
+        double megabytes = static_cast<double>(files_count * buffers_per_file * buffer_bytes) / (1 << 20);
+        size_t buffers = files_count * buffers_per_file;
+        char const *names[] = { "pwrite per buffer", "async io thread pool", "async io io_uring" };
+        std::printf("%-28s files=%zu  throughput=%8.0f MB/s  caller cpu=%7.0f ns/buffer  total cpu=%7.0f ns/buffer\n",
+            names[static_cast<size_t>(kind)], files_count, megabytes / seconds, thread_cpu / buffers, process_cpu / buffers);
+
+        files.clear();
+        for (auto descriptor : descriptors) {
+            close(descriptor);
+        }
+        for (size_t i = 0; i < files_count; ++i) {
+            std::remove((std::string(benchmark_file) + "." + std::to_string(i)).c_str());
+        }
+    }
+}
+
+int main(
+    int argc,
+    char *argv[])
+{
+    std::string selected = argc > 1 ? argv[1] : "all";
+
+    if (selected == "all" || selected == "async") {
+        async_benchmarks();
+    }
+    if (selected == "all" || selected == "format") {
+        format_benchmarks();
+    }
+    if (selected == "all" || selected == "flush") {
+        flush_policy_benchmarks();
+    }
+    if (selected == "all" || selected == "suppressed") {
+        suppressed_benchmarks();
+    }
+    if (selected == "all" || selected == "rotation") {
+        rotation_benchmarks();
+    }
+    if (selected == "all" || selected == "structured") {
+        structured_benchmarks();
+    }
+    if (selected == "all" || selected == "limited") {
+        rate_limit_benchmarks();
+    }
+    if (selected == "all" || selected == "mapped") {
+        mapped_benchmarks();
+    }
+    if (selected == "all" || selected == "compressed") {
+        compressed_benchmarks(std::vector<std::string>(argv + std::min(argc, 2), argv + argc));
+    }
+    if (selected == "all" || selected == "async_io") {
+        async_io_logger_benchmarks();
+        async_io_backend_benchmarks();
+    }
+
+    return 0;
+}
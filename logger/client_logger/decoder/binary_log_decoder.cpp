@@ -0,0 +1,39 @@
+#include <cstdio>
+#include <exception>
+#include <iostream>
+
+#include <binary_log.h>
+#include <log_clock.h>
+
+namespace
+{
+
+    char const *severity_names[] = { "TRACE", "DEBUG", "INFORMATION", "WARNING", "ERROR", "CRITICAL" };
+
+}
+
+// prints a log written by add_binary_file_stream as "date time.nanoseconds [SEVERITY] message"
+int main(
+    int argc,
+    char *argv[])
+{
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <binary log file>" << std::endl;
+        return 1;
+    }
+
+    try {
+        binary_log::reader reader(argv[1]);
+        binary_log::decoded_record record;
+        while (reader.next(record)) {
+            auto &calendar = log_clock::calendar_of(record.seconds);
+            std::printf("%s %s.%09u [%s] %s\n", calendar.date, calendar.time, record.nanoseconds,
+                severity_names[static_cast<size_t>(record.severity)], record.message.c_str());
+        }
+    } catch (std::exception const &error) {
+        std::cerr << argv[1] << ": " << error.what();
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include <compressed_log.h>
+
+// writes the raw bytes of a log written by add_compressed_file_stream to stdout, from the start
+// or from a raw offset on, decompressing only the blocks from there; --blocks lists the blocks
+int main(
+    int argc,
+    char *argv[])
+{
+    bool list = argc == 3 && strcmp(argv[2], "--blocks") == 0;
+    bool seek = argc == 4 && strcmp(argv[2], "--from") == 0;
+    if (argc < 2 || (argc > 2 && !list && !seek)) {
+        std::cerr << "usage: " << argv[0] << " <compressed log file> [--blocks | --from <raw offset>]" << std::endl;
+        return 1;
+    }
+
+    try {
+        compressed_log::reader reader(argv[1]);
+        auto const &blocks = reader.blocks();
+
+        if (list) {
+            uint64_t raw_total = 0;
+            uint64_t stored_total = 0;
+            for (size_t i = 0; i < blocks.size(); ++i) {
+                auto const &block = blocks[i];
+                std::printf("block %zu: raw offset %llu, raw %u bytes, stored %u bytes%s\n", i,
+                    static_cast<unsigned long long>(block.raw_offset), block.raw_size, block.stored_size,
+                    block.method == compressed_log::block_method::stored ? " (not compressed)" : "");
+                raw_total += block.raw_size;
+                stored_total += block.stored_size + compressed_log::block_header_size;
+            }
+            std::printf("%zu blocks, %llu raw bytes in %llu, ratio %.2f\n", blocks.size(),
+                static_cast<unsigned long long>(raw_total), static_cast<unsigned long long>(stored_total),
+                stored_total == 0 ? 0.0 : static_cast<double>(raw_total) / stored_total);
+            return 0;
+        }
+
+        uint64_t from = seek ? std::stoull(argv[3]) : 0;
+        std::string raw;
+        for (size_t i = reader.find_block(from); i < blocks.size(); ++i) {
+            raw.clear();
+            reader.read_block(i, raw);
+
+            // the first block is written from the offset on
+            size_t skipped = from > blocks[i].raw_offset ? static_cast<size_t>(from - blocks[i].raw_offset) : 0;
+            std::fwrite(raw.data() + skipped, 1, raw.size() - skipped, stdout);
+        }
+    } catch (std::exception const &error) {
+        std::cerr << argv[1] << ": " << error.what();
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,237 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ASYNC_IO_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ASYNC_IO_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class async_io_file;
+
+// writes buffers at file offsets for any number of files without the caller waiting on a
+// syscall: an io_uring takes every buffer queued since the last submission in one
+// io_uring_enter, and where there is none (an old kernel, io_uring turned off) a pool of
+// threads writes them with pwritev, buffers next to each other in one file going in one call
+// (linux only)
+class async_io_writer final
+{
+
+    friend class async_io_file;
+
+public:
+
+    enum class backend
+    {
+        // io_uring if the kernel has it, the thread pool otherwise
+        automatic,
+        io_uring,
+        thread_pool
+    };
+
+    // a buffer to write at an offset, owned by its async_io_file; the writer moves data,
+    // size and offset on over short writes
+    struct request
+    {
+        int descriptor;
+        uint64_t offset;
+        char const *data;
+        size_t size;
+        async_io_file *file;
+    };
+
+    // requests submitted while one is open go to the ring or the pool together once the last
+    // batch closes, or earlier if a file has to wait for one of its buffers
+    class batch final
+    {
+
+    private:
+
+        async_io_writer *_writer;
+
+    public:
+
+        // a null writer makes an empty batch
+        explicit batch(async_io_writer *writer) noexcept;
+
+        batch(batch const &other) = delete;
+
+        batch &operator=(batch const &other) = delete;
+
+        ~batch() noexcept;
+
+    };
+
+    static constexpr size_t default_threads = 2;
+
+    // requests in the ring at a time
+    static constexpr unsigned ring_entries = 256;
+
+private:
+
+    struct ring;
+
+    backend _backend;
+
+    std::unique_ptr<ring> _ring;
+
+    std::deque<request *> _queued;
+
+    // submitted while a batch is open
+    std::deque<request *> _held;
+
+    // requests taken by the ring or a pool thread and not completed yet
+    size_t _in_flight;
+
+    bool _stopping;
+
+    size_t _batches;
+
+    std::mutex _mutex;
+
+    std::condition_variable _wakeup;
+
+    std::vector<std::thread> _threads;
+
+private:
+
+    void submitter_loop();
+
+    void reaper_loop();
+
+    void pool_loop();
+
+    // completes the request or, after a short write, queues what is left; called unlocked
+    void finish(request *item, long result);
+
+    // queues the requests held by open batches
+    void release_held();
+
+public:
+
+    // throws if io_uring is asked for and can't be set up
+    explicit async_io_writer(backend kind = backend::automatic, size_t threads = default_threads);
+
+    async_io_writer(async_io_writer const &other) = delete;
+
+    async_io_writer &operator=(async_io_writer const &other) = delete;
+
+    async_io_writer(async_io_writer &&other) noexcept = delete;
+
+    async_io_writer &operator=(async_io_writer &&other) noexcept = delete;
+
+    // writes out every request queued
+    ~async_io_writer() noexcept;
+
+public:
+
+    // writer of the process the asynchronous streams share, made on first use
+    static async_io_writer &shared();
+
+    // queues the request, its file is told once it is written or has failed
+    void submit(request *item);
+
+    [[nodiscard]] backend kind() const noexcept;
+
+};
+
+// file written a buffer at a time through an async_io_writer: while the buffers already handed
+// over are being written the next one is filled, the writer waits only when every buffer of the
+// file is still in flight. Writes come from one thread at a time
+class async_io_file final
+{
+
+    friend class async_io_writer;
+
+public:
+
+    static constexpr size_t default_buffer_bytes = 1 << 16;
+
+    static constexpr size_t default_buffers = 4;
+
+private:
+
+    struct buffer_slot
+    {
+        std::unique_ptr<char[]> bytes;
+
+        // bytes filled, the request keeps its own count once submitted
+        size_t size;
+
+        std::atomic<bool> in_flight;
+
+        async_io_writer::request request;
+    };
+
+private:
+
+    async_io_writer &_writer;
+
+    int _descriptor;
+
+    uint64_t _offset;
+
+    size_t _buffer_bytes;
+
+    std::unique_ptr<buffer_slot[]> _slots;
+
+    size_t _slots_count;
+
+    size_t _current;
+
+    size_t _in_flight;
+
+    // errno of the first write that failed
+    int _error;
+
+    std::mutex _mutex;
+
+    std::condition_variable _completed;
+
+private:
+
+    void completed(async_io_writer::request *item, int error);
+
+public:
+
+    // creates the file or, with append, writes on after what it has; throws if it can't be
+    // opened or is not a regular file
+    async_io_file(std::string const &file_path, size_t buffer_bytes = default_buffer_bytes, size_t buffers = default_buffers,
+        bool append = false, async_io_writer &writer = async_io_writer::shared());
+
+    async_io_file(async_io_file const &other) = delete;
+
+    async_io_file &operator=(async_io_file const &other) = delete;
+
+    async_io_file(async_io_file &&other) noexcept = delete;
+
+    async_io_file &operator=(async_io_file &&other) noexcept = delete;
+
+    // submits what is buffered and waits for every buffer to be written
+    ~async_io_file() noexcept;
+
+public:
+
+    // waits if the buffer it fills next is still in flight
+    void write(char const *data, size_t size);
+
+    // hands the filled part of the current buffer to the writer without waiting for it
+    void submit();
+
+    // waits until every buffer submitted is in the file
+    void wait();
+
+    // bytes written or buffered so far, where the next write goes
+    [[nodiscard]] uint64_t size() const noexcept;
+
+    // errno of the first write that failed, 0 if none did; a failed buffer is lost
+    [[nodiscard]] int error() noexcept;
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ASYNC_IO_H
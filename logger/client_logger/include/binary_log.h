@@ -0,0 +1,66 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_BINARY_LOG_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_BINARY_LOG_H
+
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+
+#include "../../logger/include/logger.h"
+#include "../../logger/include/structured_record.h"
+
+// binary log file: the magic, then entries [uint8 kind][uint32 payload size][payload];
+// a format entry ([uint32 id][format]) comes before the first record using it, so the file
+// decodes on its own; a record entry is
+// [uint8 severity][int64 seconds][uint32 nanoseconds][uint32 format id][arguments]
+namespace binary_log
+{
+
+    constexpr char magic[8] = { 'M', 'P', 'O', 'S', 'B', 'L', 'G', '1' };
+
+    enum class entry_kind : uint8_t
+    {
+        format = 1,
+        record = 2
+    };
+
+    constexpr size_t entry_header_size = sizeof(uint8_t) + sizeof(uint32_t);
+
+    constexpr size_t record_header_size = sizeof(uint8_t) + sizeof(int64_t) + sizeof(uint32_t) + sizeof(structured::format_id);
+
+    struct decoded_record
+    {
+        logger::severity severity;
+        time_t seconds;
+        uint32_t nanoseconds;
+        std::string message;
+    };
+
+    // reads a binary log back, formatting every record
+    class reader final
+    {
+
+    private:
+
+        std::ifstream _file;
+
+        std::unordered_map<structured::format_id, std::string> _formats;
+
+        std::string _payload;
+
+    public:
+
+        // throws if the file can't be opened or is not a binary log
+        explicit reader(std::string const &file_path);
+
+    public:
+
+        // false at the end of the file; throws on a damaged entry
+        bool next(decoded_record &record);
+
+    };
+
+}
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_BINARY_LOG_H
@@ -1,23 +1,176 @@
 #ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_CLIENT_LOGGER_H
 #define MATH_PRACTICE_AND_OPERATING_SYSTEMS_CLIENT_LOGGER_H
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../../logger/include/configuration_watcher.h"
+#include "../../logger/include/log_clock.h"
+#include "../../logger/include/log_limiter.h"
 #include "../../logger/include/logger.h"
+#include "../../logger/include/rcu_pointer.h"
+#include "../../logger/include/ring_buffer.h"
+#include "../../logger/include/structured_record.h"
+#include "file_sink.h"
 #include "client_logger_builder.h"
 
 class client_logger final: public logger
 {
-    
+
     friend class client_logger_builder;
 
-    std::string _format;
+private:
+
+    // format string compiled once into literal and field pieces
+    struct format_segment
+    {
+        enum class field
+        {
+            literal,
+            message,
+            severity,
+            time,
+            date,
+            milliseconds
+        };
+
+        field type;
+        std::string literal;
+    };
+
+    // format of records logged as ready text
+    static constexpr structured::format_id plain_text = UINT32_MAX;
+
+    // text is the message itself or, for a structured record, its encoded arguments
+    struct record
+    {
+        logger::severity severity;
+        std::string text;
+        time_t time;
+        uint32_t nanoseconds;
+        structured::format_id format;
+    };
+
+    // state of asynchronous mode: producers push into records, flusher writes them out
+    struct async_state
+    {
+        ring_buffer<record> records;
+        overflow_policy policy;
+        std::atomic<size_t> dropped;
+        std::atomic<bool> stopping;
+        std::atomic<bool> sleeping;
+        // flush tickets: a flush waits until the records pushed before it are written out and the
+        // streams flushed, it is not held up by records other threads push meanwhile
+        std::atomic<size_t> flush_position;
+        std::atomic<size_t> flushed_position;
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        std::thread flusher;
+
+        async_state(size_t capacity, overflow_policy policy);
+    };
+
+    static constexpr size_t flusher_batch_size = 256;
+
+    static constexpr size_t severities_count = static_cast<size_t>(logger::severity::critical) + 1;
+
+    // where records go; never changed once published, reconfigure() publishes a new one
+    struct routing_table
+    {
+        std::map<std::string, std::set<logger::severity>> streams;
+
+        // sinks in streams order, shared with other loggers writing to the same files
+        std::vector<std::shared_ptr<file_sink>> sinks;
+
+        // sinks to write into, indexed by severity
+        std::array<std::vector<file_sink *>, severities_count> routes;
+
+        // bit per severity that has a route
+        uint32_t enabled = 0;
+
+        // some sink is an asynchronous io stream
+        bool async_io = false;
+    };
+
+private:
+
+    std::vector<format_segment> _format;
+
+    // file name -> sink, only touched while loggers are built, copied or reconfigured, never by log()
+    static std::map<std::string, std::weak_ptr<file_sink>> _sinks_registry;
+
+    static std::mutex _sinks_registry_mutex;
+
+    rcu_pointer<routing_table> _routing;
+
+    // copy of enabled of the published table, lets is_enabled() skip entering _routing
+    std::atomic<uint32_t> _enabled;
+
+    // serializes reconfigurations, so _enabled always matches the last published table
+    std::mutex _reconfiguration_mutex;
+
+    // settings of the sinks this logger opens, kept for streams added by reconfigure()
+    flush_policy _sink_flush_policy;
+
+    // streams without options here are plain text files
+    std::map<std::string, stream_options> _stream_options;
+
+    std::unique_ptr<async_state> _async;
+
+    std::unique_ptr<configuration_watcher> _watcher;
+
+    // configuration path inside the watched file
+    std::string _watched_path;
 
-    std::map<std::string, std::set<logger::severity>> _streams;
-    
-    static std::map<std::string, std::pair<std::ofstream, int>> _streams_users;
+    mutable log_limiter _limiter;
 
-    client_logger(std::map<std::string, std::set<logger::severity>> streams, std::string format);
+    // synchronous records are built here, so a warmed up thread logs without allocating
+    static thread_local record _sync_record;
 
-    void close_streams();
+    client_logger(std::map<std::string, std::set<logger::severity>> streams, std::vector<format_segment> format, size_t async_capacity = 0, overflow_policy policy = overflow_policy::block, flush_policy sink_flush_policy = flush_policy(), std::map<std::string, stream_options> options = std::map<std::string, stream_options>(), log_limiter limiter = log_limiter());
+
+    static std::vector<format_segment> compile_format(std::string const &format);
+
+    static std::shared_ptr<file_sink> acquire_sink(std::string const &file_name, flush_policy sink_flush_policy, stream_options const &options);
+
+    static void stamp(record &item) noexcept;
+
+    // append - streams not open yet are appended to rather than truncated, so one a
+    // reconfiguration dropped keeps what it had when it comes back
+    std::unique_ptr<routing_table> make_routing(std::map<std::string, std::set<logger::severity>> streams, std::map<std::string, stream_options> const &options, bool append = false) const;
+
+    void publish(std::unique_ptr<routing_table> routing);
+
+    void start_flusher(size_t capacity, overflow_policy policy);
+
+    void stop_flusher() noexcept;
+
+    void flusher_loop() const noexcept;
+
+    void enqueue(record &&item) const noexcept;
+
+    void format_record(std::string &buffer, record const &item) const;
+
+    void write_record(routing_table const &routing, record const &item, bool flush) const;
+
+    void submit(record &&item) const noexcept;
+
+    // writes a "N records suppressed" line for every severity the limiter suppressed records of
+    void report_suppressed() const noexcept;
+
+protected:
+
+    [[nodiscard]] bool admit(logger::severity severity) const noexcept override;
+
+    logger const *log_admitted(std::string const &message, logger::severity severity) const noexcept override;
 
 public:
 
@@ -35,6 +188,52 @@ public:
 
     [[nodiscard]] logger const *log(const std::string &message, logger::severity severity) const noexcept override;
 
+    using logger::log;
+
+    [[nodiscard]] bool is_enabled(logger::severity severity) const noexcept override;
+
+    // logs a format registered with structured::register_format and its arguments; binary
+    // streams store them as they are, text streams put the message together when writing
+    template<typename... Args>
+    logger const *log_structured(logger::severity severity, structured::format_id format, Args const &... args) const noexcept
+    {
+        if (!admit(severity)) {
+            return this;
+        }
+
+        record item{severity, std::string(), 0, 0, format};
+        try {
+            structured::encode_arguments(item.text, args...);
+        } catch (...) {
+            return this;
+        }
+        stamp(item);
+        submit(std::move(item));
+        return this;
+    }
+
+    [[nodiscard]] size_t dropped_records() const noexcept;
+
+    // writes out everything logged so far, in asynchronous mode waits for the records queued
+    // before the call
+    void flush() const;
+
+    // routes severities anew without rebuilding the logger, loggers holding it need no rewiring;
+    // streams both routings have stay open, new text and binary streams are appended to, and a
+    // record is written by either the old routes or the new ones; throws and keeps the old
+    // routes if a stream can't be opened. Streams given no options keep the ones they had,
+    // new ones are plain text files
+    void reconfigure(std::map<std::string, std::set<logger::severity>> streams, std::map<std::string, stream_options> options = std::map<std::string, stream_options>());
+
+    // the same with streams read like client_logger_builder::transform_with_configuration does
+    void reconfigure(std::string const &configuration_file_path, std::string const &configuration_path);
+
+    // reconfigures from the file every time it is saved, until unwatch_configuration(); a file
+    // that can't be read or opened keeps the routes as they are; copies of the logger don't watch
+    void watch_configuration(std::string const &configuration_file_path, std::string const &configuration_path);
+
+    void unwatch_configuration() noexcept;
+
 };
 
-#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_CLIENT_LOGGER_H
\ No newline at end of file
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_CLIENT_LOGGER_H
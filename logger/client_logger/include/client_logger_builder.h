@@ -8,6 +8,9 @@
 #include <set>
 
 #include <logger_builder.h>
+#include <log_limiter.h>
+#include <ring_buffer.h>
+#include <file_sink.h>
 #include <client_logger.h>
 #define CONSOLE "CON"
 #ifdef _WIN32
@@ -20,14 +23,76 @@
 class client_logger_builder final: public logger_builder
 {
 
+    friend class client_logger;
+
+    // options of a stream as added; sizes and the rotation are the builder's unless the
+    // configuration file gives the stream a rotation of its own
+    struct configured_stream
+    {
+        stream_options options;
+
+        bool own_rotation = false;
+    };
+
     std::map<std::string, std::set<logger::severity>> _streams;
 
+    // streams added as plain text files have no entry
+    std::map<std::string, configured_stream> _stream_options;
+
+    size_t _map_window;
+
+    size_t _compression_block;
+
+    size_t _async_io_buffer;
+
     std::string _format;
 
+    size_t _async_capacity;
+
+    overflow_policy _overflow_policy;
+
+    flush_policy _flush_policy;
+
+    rotation_policy _rotation;
+
+    std::array<rate_limit, log_limiter::severities_count> _rate_limits;
+
+    std::chrono::milliseconds _summary_interval;
+
+private:
+
+    // throws if the stream is already of another kind
+    void set_kind(std::string const &stream_file_path, stream_kind kind);
+
+    [[nodiscard]] stream_options resolve_options(configured_stream const &stream) const;
+
 public:
 
+    // %d - date, %t - time, %f - milliseconds, %s - severity, %m - message
     logger_builder * set_format(std::string &format);
 
+    logger_builder * set_async(size_t buffer_capacity, overflow_policy policy = overflow_policy::block);
+
+    logger_builder * set_flush_policy(flush_policy policy);
+
+    // rotation of the file streams this logger opens, consoles are never rotated
+    logger_builder * set_rotation(rotation_policy policy);
+
+    // token bucket and 1-in-n sampling for records of the severity
+    logger_builder * set_rate_limit(logger::severity severity, rate_limit limit);
+
+    // how often "N records suppressed" lines are written for rate limited severities
+    logger_builder * set_suppression_summary(std::chrono::milliseconds interval);
+
+    // size of the windows mapped streams of this logger map at a time
+    logger_builder * set_map_window(size_t window_bytes);
+
+    // raw bytes in a block of the compressed streams of this logger
+    logger_builder * set_compression_block(size_t block_bytes);
+
+    // bytes in each of the buffers asynchronous io streams of this logger keep in flight
+    logger_builder * set_async_io_buffer(size_t buffer_bytes);
+
 public:
 
     client_logger_builder();
@@ -48,8 +113,32 @@ public:
 
     logger_builder *add_console_stream(logger::severity severity) override;
 
+    // the configuration is either an array of streams
+    // [file, [severities], {rotation, "mapped": .., "compressed": .., "async_io": ..}] or
+    // {"streams": [...], "rate_limits": {"trace": {"rate": .., "burst": .., "sample_every": ..}},
+    //  "summary_interval_ms": .., "map_window_bytes": .., "compression_block_bytes": ..,
+    //  "async_io_buffer_bytes": ..}
     logger_builder* transform_with_configuration(std::string const &configuration_file_path, std::string const &configuration_path) override;
 
+    // the stream gets binary log entries instead of formatted lines, see binary_log.h
+    logger_builder *add_binary_file_stream(std::string const &stream_file_path, logger::severity severity);
+
+    // the stream is written through memory mappings instead of a file stream: writers copy
+    // into the mapped file without locking and without syscalls, it is never rotated and is
+    // cut to its length once the last logger using it is gone (linux only)
+    logger_builder *add_mapped_file_stream(std::string const &stream_file_path, logger::severity severity);
+
+    // the stream is a compressed log of independent blocks, compressed and written on a thread
+    // of the stream's own; it is never rotated, compressed_log::reader and the decompressor tool
+    // read it back
+    logger_builder *add_compressed_file_stream(std::string const &stream_file_path, logger::severity severity);
+
+    // the stream's buffers are written by the async_io_writer all such streams share, through
+    // io_uring or, without it, a pool of threads calling pwritev; the thread logging (or the
+    // flusher) copies into the next buffer while earlier ones are written and never makes a
+    // write syscall itself. Regular files only, never rotated (linux only)
+    logger_builder *add_async_io_file_stream(std::string const &stream_file_path, logger::severity severity);
+
     logger_builder *clear() override;
 
     [[nodiscard]] logger *build() const override;
@@ -0,0 +1,147 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_COMPRESSED_LOG_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_COMPRESSED_LOG_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// compressed log file: the magic, then blocks [uint8 method][3 bytes reserved][uint32 stored
+// size][uint32 raw size][uint32 fnv-1a of the raw bytes][uint64 raw offset][stored bytes];
+// every block decompresses on its own (see lz_block.h) and tells where its bytes are in the
+// raw stream, so a reader seeks by walking the headers without decompressing anything
+namespace compressed_log
+{
+
+    constexpr char magic[8] = { 'M', 'P', 'O', 'S', 'L', 'Z', 'B', '1' };
+
+    enum class block_method : uint8_t
+    {
+        stored = 0,
+        lz = 1
+    };
+
+    constexpr size_t block_header_size = 4 * sizeof(uint32_t) + sizeof(uint64_t);
+
+    constexpr size_t default_block_bytes = 1 << 16;
+
+    struct block_info
+    {
+        block_method method;
+        uint32_t stored_size;
+        uint32_t raw_size;
+        uint32_t checksum;
+        uint64_t raw_offset;
+
+        // where the stored bytes start in the file
+        uint64_t file_offset;
+    };
+
+    uint32_t checksum(char const *data, size_t size) noexcept;
+
+    // collects what is written into blocks and compresses and writes full ones on a thread
+    // of its own; write() and seal() are called by one thread at a time
+    class writer final
+    {
+
+    private:
+
+        std::ofstream _file;
+
+        size_t _block_bytes;
+
+        std::string _block;
+
+        // sealed blocks waiting for the compressor
+        std::deque<std::string> _sealed;
+
+        bool _compressing;
+
+        bool _stopping;
+
+        // raw bytes of the blocks written so far
+        uint64_t _raw_offset;
+
+        std::mutex _mutex;
+
+        std::condition_variable _wakeup;
+
+        std::condition_variable _drained;
+
+        std::thread _compressor;
+
+    private:
+
+        void compressor_loop();
+
+        // stored is where the block is compressed to, kept by the compressor between blocks
+        void write_block(std::string const &raw, std::string &stored);
+
+    public:
+
+        // creates or truncates the file, throws if it can't be opened
+        explicit writer(std::string const &file_path, size_t block_bytes = default_block_bytes);
+
+        writer(writer const &other) = delete;
+
+        writer &operator=(writer const &other) = delete;
+
+        writer(writer &&other) noexcept = delete;
+
+        writer &operator=(writer &&other) noexcept = delete;
+
+        // writes out what is left
+        ~writer() noexcept;
+
+    public:
+
+        void write(char const *data, size_t size);
+
+        // ends the current block early and hands it to the compressor
+        void seal();
+
+        // seals the current block and waits until every block is in the file
+        void flush();
+
+        [[nodiscard]] bool is_open() const noexcept;
+
+    };
+
+    // reads the blocks of a compressed log back, in order or by raw offset
+    class reader final
+    {
+
+    private:
+
+        std::ifstream _file;
+
+        std::vector<block_info> _blocks;
+
+        std::string _stored;
+
+    public:
+
+        // throws if the file can't be opened or is not a compressed log; a block cut short by
+        // a crash ends the file
+        explicit reader(std::string const &file_path);
+
+    public:
+
+        [[nodiscard]] std::vector<block_info> const &blocks() const noexcept;
+
+        // index of the block holding the raw byte at offset, blocks().size() past the end
+        [[nodiscard]] size_t find_block(uint64_t raw_offset) const noexcept;
+
+        // appends the raw bytes of the block to out; throws if the block is damaged
+        void read_block(size_t index, std::string &out);
+
+    };
+
+}
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_COMPRESSED_LOG_H
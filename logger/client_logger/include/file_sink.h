@@ -0,0 +1,234 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_FILE_SINK_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_FILE_SINK_H
+
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../../logger/include/logger.h"
+#include "../../logger/include/structured_record.h"
+#include "async_io.h"
+#include "binary_log.h"
+#include "compressed_log.h"
+#include "mapped_file.h"
+
+// when a sink pushes its buffer to the file; error and critical records are always flushed at once
+struct flush_policy
+{
+    // flush after every record of this severity or higher
+    logger::severity severity = logger::severity::trace;
+
+    // flush once this many bytes are buffered, 0 - don't flush by size
+    size_t bytes = 0;
+
+    // flush when the previous flush is older than this, 0 - don't flush by time
+    std::chrono::milliseconds interval = std::chrono::milliseconds(0);
+};
+
+// when a file moves on to a new segment; the full one is renamed to "<path>.<n>", n growing by
+// one per rotation, and a segment prepared in the background takes its place
+struct rotation_policy
+{
+    // rotate once the segment holds this many bytes, 0 - don't rotate by size
+    size_t bytes = 0;
+
+    // rotate when the segment is older than this, 0 - don't rotate by time
+    std::chrono::milliseconds interval = std::chrono::milliseconds(0);
+
+    // rotated segments left on disk, older ones are removed; 0 - keep all
+    size_t kept_segments = 0;
+
+    // reserve bytes on disk for every new segment up front (linux only)
+    bool preallocate = true;
+
+    [[nodiscard]] bool enabled() const noexcept
+    {
+        return bytes != 0 || interval.count() != 0;
+    }
+
+    bool operator==(rotation_policy const &other) const noexcept = default;
+};
+
+// how a file is written: through the stream buffer, through mapped windows (see mapped_file.h),
+// as a compressed log (see compressed_log.h) or through the shared async_io_writer (see async_io.h)
+enum class stream_kind
+{
+    plain,
+    mapped,
+    compressed,
+    async_io
+};
+
+// what a file stream is opened with besides the flush policy
+struct stream_options
+{
+    // binary log entries instead of formatted lines, see binary_log.h
+    bool binary = false;
+
+    stream_kind kind = stream_kind::plain;
+
+    // window, block or buffer size of a mapped, compressed or asynchronous io stream,
+    // 0 - the kind's default
+    size_t kind_bytes = 0;
+
+    // plain regular files only, other streams are never rotated
+    rotation_policy rotation;
+
+    // keep what a text, binary or asynchronous io file has, mapped and compressed files are
+    // truncated all the same
+    bool append = false;
+};
+
+// one per file, shared by every logger writing there; all operations lock the sink itself
+class file_sink final
+{
+
+public:
+
+    static constexpr size_t default_buffer_size = 1 << 16;
+
+private:
+
+    std::unique_ptr<char[]> _buffer;
+
+    std::ofstream _stream;
+
+    flush_policy _policy;
+
+    size_t _unflushed;
+
+    std::chrono::steady_clock::time_point _last_flush;
+
+    bool _flush_requested;
+
+    std::mutex _mutex;
+
+    // binary sinks take structured records only, formats already written are marked
+    bool _binary;
+
+    std::vector<bool> _written_formats;
+
+    // as opened, with the kind's default size filled in; matches() compares against it
+    stream_options _options;
+
+    // a plain regular file, its rotation counts when the sink is shared
+    bool _rotatable;
+
+    std::string _path;
+
+    std::ios::openmode _mode;
+
+    size_t _buffer_size;
+
+    // rotation; the preparer thread creates the next segment and removes old ones, so writers
+    // only close, rename and reopen
+    rotation_policy _rotation;
+
+    size_t _segment_size;
+
+    std::chrono::steady_clock::time_point _segment_start;
+
+    size_t _next_segment_index;
+
+    bool _spare_ready;
+
+    bool _prepare_requested;
+
+    bool _stopping;
+
+    std::condition_variable _prepare_wakeup;
+
+    std::thread _preparer;
+
+    // set for mapped streams, text is then copied into the mapping without taking the lock
+    std::unique_ptr<mapped_file> _mapped;
+
+    // set for compressed streams, whole blocks are compressed and written on its thread
+    std::unique_ptr<compressed_log::writer> _compressed;
+
+    // set for asynchronous io streams, full buffers are written by the shared async_io_writer
+    std::unique_ptr<async_io_file> _async_io;
+
+private:
+
+    void open_segment();
+
+    // wait - for asynchronous io streams, until what is flushed is in the file
+    void flush_locked(bool wait = false);
+
+    void append_locked(char const *data, size_t size);
+
+    void written_locked(size_t size, logger::severity severity, bool defer_flush);
+
+    void rotate_locked();
+
+    void preparer_loop();
+
+    void prepare_spare() const;
+
+    void remove_old_segments(size_t index) const;
+
+    std::string spare_path() const;
+
+    std::string segment_path(size_t index) const;
+
+public:
+
+    // a mapped stream is never rotated and has nothing to flush; a compressed stream is never
+    // rotated either and a block is only cut short by an error record, the flush interval or
+    // flush(); an asynchronous io stream is never rotated, a flush only submits the buffer and
+    // flush() and error records wait for it to be written. Only plain streams go through a
+    // stream buffer of buffer_size bytes, 0 - unbuffered
+    file_sink(std::string const &file_path, flush_policy policy, stream_options const &options = stream_options(), size_t buffer_size = default_buffer_size);
+
+    file_sink(file_sink const &other) = delete;
+
+    file_sink &operator=(file_sink const &other) = delete;
+
+    file_sink(file_sink &&other) noexcept = delete;
+
+    file_sink &operator=(file_sink &&other) noexcept = delete;
+
+    ~file_sink() noexcept;
+
+public:
+
+    // appends to the buffer; a flush the policy asks for is done at once or, if deferred, left for flush_if_requested
+    void write(char const *data, size_t size, logger::severity severity, bool defer_flush = false);
+
+    // binary sinks only: appends a record entry, preceded by its format on first use
+    void write_structured(
+        logger::severity severity,
+        time_t seconds,
+        uint32_t nanoseconds,
+        structured::format_id format,
+        std::string_view arguments,
+        bool defer_flush = false);
+
+    void flush_if_requested();
+
+    void flush_if_expired();
+
+    void flush();
+
+    [[nodiscard]] bool is_open() const noexcept;
+
+    [[nodiscard]] bool is_binary() const noexcept;
+
+    [[nodiscard]] bool is_mapped() const noexcept;
+
+    [[nodiscard]] bool is_async_io() const noexcept;
+
+    // whether a logger asking for these options can share the sink; append is not compared,
+    // it only matters when the file is opened
+    [[nodiscard]] bool matches(stream_options const &options) const noexcept;
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_FILE_SINK_H
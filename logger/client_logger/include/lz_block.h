@@ -0,0 +1,30 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_LZ_BLOCK_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_LZ_BLOCK_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// LZ77 block codec in the LZ4 layout: sequences of [token][literals][uint16 offset], the token
+// holding the literal length and the match length less 4 in its two halves, 15 in a half
+// continued by bytes of 255 and a last byte below it; the last sequence has literals only.
+// Blocks are independent, a match never reaches back beyond the start of its block
+namespace lz_block
+{
+
+    // compressed size of size bytes in the worst case
+    constexpr size_t compress_bound(size_t size) noexcept
+    {
+        return size + size / 255 + 16;
+    }
+
+    // appends the compressed input to out
+    void compress(std::string_view input, std::string &out);
+
+    // appends raw_size bytes decompressed from input to out; throws std::runtime_error if the
+    // input is damaged or doesn't decompress to exactly raw_size bytes
+    void decompress(std::string_view input, size_t raw_size, std::string &out);
+
+}
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_LZ_BLOCK_H
@@ -0,0 +1,106 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_MAPPED_FILE_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_MAPPED_FILE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// file written through shared memory mappings: a writer reserves the next bytes with one
+// fetch_add and copies into the mapped window holding them, no lock and no syscall; a mapper
+// thread maps the windows ahead of the writers and unmaps the ones they are done with.
+// The file grows a window at a time and is cut to the bytes written on close (linux only)
+class mapped_file final
+{
+
+public:
+
+    static constexpr size_t default_window_bytes = 1 << 22;
+
+private:
+
+    // windows mapped at a time, the writers are at most this many windows ahead of the oldest
+    // one still being written
+    static constexpr size_t slots_count = 4;
+
+    struct alignas(64) window_slot
+    {
+        // window in the slot, its mapping is valid once the index is published
+        std::atomic<uint64_t> index;
+
+        std::atomic<char *> bytes;
+
+        // bytes copied into the window, it can be unmapped once this reaches the window size
+        std::atomic<size_t> written;
+    };
+
+private:
+
+    int _descriptor;
+
+    size_t _page_bytes;
+
+    size_t _window_bytes;
+
+    alignas(64) std::atomic<uint64_t> _reserved;
+
+    window_slot _slots[slots_count];
+
+    // next window the mapper maps
+    uint64_t _next_window;
+
+    // set when the file can't grow, writers then drop what doesn't fit
+    std::atomic<bool> _failed;
+
+    std::atomic<size_t> _lost_bytes;
+
+    bool _stopping;
+
+    std::mutex _mutex;
+
+    std::condition_variable _wakeup;
+
+    std::thread _mapper;
+
+private:
+
+    // maps the next window into its slot if the window there before is written; false if
+    // there is nothing to do yet
+    bool map_next();
+
+    void mapper_loop();
+
+    void copy_into_window(uint64_t window, size_t offset, char const *data, size_t size) noexcept;
+
+public:
+
+    // creates or truncates the file; throws if it can't be opened or mapped, window_bytes is
+    // rounded up to whole pages
+    explicit mapped_file(std::string const &file_path, size_t window_bytes = default_window_bytes);
+
+    mapped_file(mapped_file const &other) = delete;
+
+    mapped_file &operator=(mapped_file const &other) = delete;
+
+    mapped_file(mapped_file &&other) noexcept = delete;
+
+    mapped_file &operator=(mapped_file &&other) noexcept = delete;
+
+    // must not run while writes are in progress
+    ~mapped_file() noexcept;
+
+public:
+
+    // safe from any number of threads; the bytes of one call stay together in the file
+    void write(char const *data, size_t size) noexcept;
+
+    [[nodiscard]] size_t size() const noexcept;
+
+    // bytes dropped because the file couldn't grow
+    [[nodiscard]] size_t lost_bytes() const noexcept;
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_MAPPED_FILE_H
@@ -0,0 +1,573 @@
+#include "../include/async_io.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef __linux__
+    #include <fcntl.h>
+    #include <linux/io_uring.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/syscall.h>
+    #include <sys/uio.h>
+    #include <unistd.h>
+#endif
+
+namespace
+{
+
+    // buffers a pool thread writes in one pwritev
+    constexpr size_t max_vectors = 64;
+
+    // user data of the request that stops the reaper
+    constexpr uint64_t stop_request = 0;
+
+    #ifdef __linux__
+
+        int io_uring_setup(unsigned entries, io_uring_params *params) noexcept
+        {
+            return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+        }
+
+        int io_uring_enter(int descriptor, unsigned to_submit, unsigned min_complete, unsigned flags) noexcept
+        {
+            return static_cast<int>(syscall(__NR_io_uring_enter, descriptor, to_submit, min_complete, flags, nullptr, 0));
+        }
+
+        int io_uring_register(int descriptor, unsigned opcode, void *argument, unsigned count) noexcept
+        {
+            return static_cast<int>(syscall(__NR_io_uring_register, descriptor, opcode, argument, count));
+        }
+
+        unsigned load_acquire(unsigned *value) noexcept
+        {
+            return std::atomic_ref<unsigned>(*value).load(std::memory_order_acquire);
+        }
+
+        void store_release(unsigned *value, unsigned stored) noexcept
+        {
+            std::atomic_ref<unsigned>(*value).store(stored, std::memory_order_release);
+        }
+
+    #endif
+
+}
+
+#ifdef __linux__
+
+// the rings shared with the kernel; the submitter thread alone fills the submission ring and
+// the reaper thread alone empties the completion ring
+struct async_io_writer::ring
+{
+    int descriptor = -1;
+
+    void *submission_map = MAP_FAILED;
+
+    size_t submission_map_bytes = 0;
+
+    void *completion_map = MAP_FAILED;
+
+    size_t completion_map_bytes = 0;
+
+    io_uring_sqe *entries = static_cast<io_uring_sqe *>(MAP_FAILED);
+
+    size_t entries_bytes = 0;
+
+    unsigned *submission_head = nullptr;
+
+    unsigned *submission_tail = nullptr;
+
+    unsigned submission_mask = 0;
+
+    unsigned submission_size = 0;
+
+    unsigned *completion_head = nullptr;
+
+    unsigned *completion_tail = nullptr;
+
+    unsigned completion_mask = 0;
+
+    io_uring_cqe *completions = nullptr;
+
+    // null if the kernel has no io_uring or no write operation in it
+    static std::unique_ptr<ring> set_up(unsigned size);
+
+    ~ring() noexcept;
+};
+
+std::unique_ptr<async_io_writer::ring> async_io_writer::ring::set_up(unsigned size)
+{
+    io_uring_params params{};
+    auto made = std::make_unique<ring>();
+    made->descriptor = io_uring_setup(size, &params);
+    if (made->descriptor < 0) {
+        return nullptr;
+    }
+
+    // IORING_OP_WRITE came with the probe, a kernel without the probe has no write either
+    size_t probe_bytes = sizeof(io_uring_probe) + IORING_OP_LAST * sizeof(io_uring_probe_op);
+    auto probe_storage = std::make_unique<char[]>(probe_bytes);
+    memset(probe_storage.get(), 0, probe_bytes);
+    auto *probe = reinterpret_cast<io_uring_probe *>(probe_storage.get());
+    if (io_uring_register(made->descriptor, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) < 0
+        || probe->last_op < IORING_OP_WRITE || (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED) == 0) {
+        return nullptr;
+    }
+
+    made->submission_map_bytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    made->completion_map_bytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    made->submission_map = mmap(nullptr, made->submission_map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        made->descriptor, IORING_OFF_SQ_RING);
+    if (made->submission_map == MAP_FAILED) {
+        return nullptr;
+    }
+    made->completion_map = mmap(nullptr, made->completion_map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        made->descriptor, IORING_OFF_CQ_RING);
+    made->entries_bytes = params.sq_entries * sizeof(io_uring_sqe);
+    made->entries = static_cast<io_uring_sqe *>(mmap(nullptr, made->entries_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        made->descriptor, IORING_OFF_SQES));
+    if (made->completion_map == MAP_FAILED || made->entries == MAP_FAILED) {
+        return nullptr;
+    }
+
+    auto *submission = static_cast<char *>(made->submission_map);
+    made->submission_head = reinterpret_cast<unsigned *>(submission + params.sq_off.head);
+    made->submission_tail = reinterpret_cast<unsigned *>(submission + params.sq_off.tail);
+    made->submission_mask = *reinterpret_cast<unsigned *>(submission + params.sq_off.ring_mask);
+    made->submission_size = params.sq_entries;
+
+    // entry i of the ring always takes submission entry i
+    auto *array = reinterpret_cast<unsigned *>(submission + params.sq_off.array);
+    for (unsigned i = 0; i < params.sq_entries; ++i) {
+        array[i] = i;
+    }
+
+    auto *completion = static_cast<char *>(made->completion_map);
+    made->completion_head = reinterpret_cast<unsigned *>(completion + params.cq_off.head);
+    made->completion_tail = reinterpret_cast<unsigned *>(completion + params.cq_off.tail);
+    made->completion_mask = *reinterpret_cast<unsigned *>(completion + params.cq_off.ring_mask);
+    made->completions = reinterpret_cast<io_uring_cqe *>(completion + params.cq_off.cqes);
+
+    return made;
+}
+
+async_io_writer::ring::~ring() noexcept
+{
+    if (entries != MAP_FAILED) {
+        munmap(entries, entries_bytes);
+    }
+    if (completion_map != MAP_FAILED) {
+        munmap(completion_map, completion_map_bytes);
+    }
+    if (submission_map != MAP_FAILED) {
+        munmap(submission_map, submission_map_bytes);
+    }
+    if (descriptor >= 0) {
+        close(descriptor);
+    }
+}
+
+#else
+
+struct async_io_writer::ring
+{
+};
+
+#endif
+
+async_io_writer::async_io_writer(backend kind, size_t threads) :
+    _backend(kind), _in_flight(0), _stopping(false), _batches(0)
+{
+    #ifdef __linux__
+        if (kind != backend::thread_pool) {
+            _ring = ring::set_up(ring_entries);
+            if (_ring == nullptr && kind == backend::io_uring) {
+                throw std::runtime_error("io_uring is not available\n");
+            }
+        }
+
+        if (_ring != nullptr) {
+            _backend = backend::io_uring;
+            _threads.emplace_back(&async_io_writer::reaper_loop, this);
+            _threads.emplace_back(&async_io_writer::submitter_loop, this);
+            return;
+        }
+
+        _backend = backend::thread_pool;
+        for (size_t i = 0; i < std::max<size_t>(threads, 1); ++i) {
+            _threads.emplace_back(&async_io_writer::pool_loop, this);
+        }
+    #else
+        throw std::runtime_error("Asynchronous io streams are not supported\n");
+    #endif
+}
+
+async_io_writer::~async_io_writer() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+        _batches = 0;
+        _queued.insert(_queued.end(), _held.begin(), _held.end());
+        _held.clear();
+    }
+    _wakeup.notify_all();
+    for (auto &thread : _threads) {
+        thread.join();
+    }
+}
+
+async_io_writer &async_io_writer::shared()
+{
+    static async_io_writer writer;
+    return writer;
+}
+
+void async_io_writer::submit(request *item)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_batches != 0) {
+        _held.push_back(item);
+        return;
+    }
+    _queued.push_back(item);
+    _wakeup.notify_all();
+}
+
+void async_io_writer::release_held()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_held.empty()) {
+        return;
+    }
+    _queued.insert(_queued.end(), _held.begin(), _held.end());
+    _held.clear();
+    _wakeup.notify_all();
+}
+
+async_io_writer::backend async_io_writer::kind() const noexcept
+{
+    return _backend;
+}
+
+async_io_writer::batch::batch(async_io_writer *writer) noexcept :
+    _writer(writer)
+{
+    if (_writer != nullptr) {
+        std::lock_guard<std::mutex> lock(_writer->_mutex);
+        ++_writer->_batches;
+    }
+}
+
+async_io_writer::batch::~batch() noexcept
+{
+    if (_writer == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_writer->_mutex);
+        if (_writer->_batches == 0 || --_writer->_batches != 0) {
+            return;
+        }
+    }
+    _writer->release_held();
+}
+
+void async_io_writer::finish(request *item, long result)
+{
+    int error = 0;
+    if (result == -EINTR || result == -EAGAIN) {
+        result = 0;
+    } else if (result < 0) {
+        error = static_cast<int>(-result);
+    }
+
+    if (error == 0) {
+        item->data += result;
+        item->size -= static_cast<size_t>(result);
+        item->offset += static_cast<uint64_t>(result);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        --_in_flight;
+        if (error == 0 && item->size != 0) {
+            _queued.push_front(item);
+        }
+        _wakeup.notify_all();
+    }
+
+    if (error != 0 || item->size == 0) {
+        item->file->completed(item, error);
+    }
+}
+
+void async_io_writer::submitter_loop()
+{
+    #ifdef __linux__
+        std::vector<request *> taken;
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        while (true) {
+            _wakeup.wait(lock, [this]() {
+                return (!_queued.empty() && _in_flight < _ring->submission_size)
+                    || (_stopping && _queued.empty() && _in_flight == 0);
+            });
+
+            // everything is written, a no-op tells the reaper to stop
+            if (_queued.empty()) {
+                lock.unlock();
+                unsigned tail = *_ring->submission_tail;
+                io_uring_sqe &entry = _ring->entries[tail & _ring->submission_mask];
+                memset(&entry, 0, sizeof(entry));
+                entry.opcode = IORING_OP_NOP;
+                entry.user_data = stop_request;
+                store_release(_ring->submission_tail, tail + 1);
+                while (io_uring_enter(_ring->descriptor, 1, 0, 0) < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY)) {
+                    std::this_thread::yield();
+                }
+                return;
+            }
+
+            size_t count = std::min<size_t>(_queued.size(), _ring->submission_size - _in_flight);
+            taken.assign(_queued.begin(), _queued.begin() + static_cast<std::ptrdiff_t>(count));
+            _queued.erase(_queued.begin(), _queued.begin() + static_cast<std::ptrdiff_t>(count));
+            _in_flight += count;
+            lock.unlock();
+
+            unsigned tail = *_ring->submission_tail;
+            for (auto *item : taken) {
+                io_uring_sqe &entry = _ring->entries[tail & _ring->submission_mask];
+                memset(&entry, 0, sizeof(entry));
+                entry.opcode = IORING_OP_WRITE;
+                entry.fd = item->descriptor;
+                entry.off = item->offset;
+                entry.addr = reinterpret_cast<uint64_t>(item->data);
+                entry.len = static_cast<uint32_t>(std::min<size_t>(item->size, UINT32_MAX));
+                entry.user_data = reinterpret_cast<uint64_t>(item);
+                ++tail;
+            }
+            store_release(_ring->submission_tail, tail);
+
+            // the whole batch goes in one call unless the kernel takes fewer
+            size_t submitted = 0;
+            while (submitted < count) {
+                int entered = io_uring_enter(_ring->descriptor, static_cast<unsigned>(count - submitted), 0, 0);
+                if (entered >= 0) {
+                    submitted += static_cast<size_t>(entered);
+                    continue;
+                }
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                // the kernel took none of the rest, they are taken back and failed
+                int error = errno;
+                store_release(_ring->submission_tail, load_acquire(_ring->submission_head));
+                for (size_t i = submitted; i < count; ++i) {
+                    finish(taken[i], -error);
+                }
+                break;
+            }
+
+            lock.lock();
+        }
+    #endif
+}
+
+void async_io_writer::reaper_loop()
+{
+    #ifdef __linux__
+        while (true) {
+            if (io_uring_enter(_ring->descriptor, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+                std::this_thread::yield();
+            }
+
+            bool stopping = false;
+            unsigned head = *_ring->completion_head;
+            unsigned tail = load_acquire(_ring->completion_tail);
+            for (; head != tail; ++head) {
+                io_uring_cqe const &completion = _ring->completions[head & _ring->completion_mask];
+                if (completion.user_data == stop_request) {
+                    stopping = true;
+                    continue;
+                }
+                finish(reinterpret_cast<request *>(completion.user_data), completion.res);
+            }
+            store_release(_ring->completion_head, head);
+
+            if (stopping) {
+                return;
+            }
+        }
+    #endif
+}
+
+void async_io_writer::pool_loop()
+{
+    #ifdef __linux__
+        std::vector<request *> taken;
+        iovec vectors[max_vectors];
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        while (true) {
+            _wakeup.wait(lock, [this]() { return !_queued.empty() || _stopping; });
+            if (_queued.empty()) {
+                return;
+            }
+
+            // buffers next to each other in one file go in one call
+            taken.clear();
+            taken.push_back(_queued.front());
+            _queued.pop_front();
+            while (!_queued.empty() && taken.size() < max_vectors && _queued.front()->descriptor == taken.back()->descriptor
+                && _queued.front()->offset == taken.back()->offset + taken.back()->size) {
+                taken.push_back(_queued.front());
+                _queued.pop_front();
+            }
+            _in_flight += taken.size();
+            lock.unlock();
+
+            for (size_t i = 0; i < taken.size(); ++i) {
+                vectors[i].iov_base = const_cast<char *>(taken[i]->data);
+                vectors[i].iov_len = taken[i]->size;
+            }
+            ssize_t written = pwritev(taken.front()->descriptor, vectors, static_cast<int>(taken.size()), static_cast<off_t>(taken.front()->offset));
+            int error = written < 0 ? errno : 0;
+
+            // a short write leaves the rest of its buffers queued again
+            for (auto *item : taken) {
+                if (error != 0) {
+                    finish(item, -error);
+                    continue;
+                }
+                size_t part = std::min(static_cast<size_t>(written), item->size);
+                written -= static_cast<ssize_t>(part);
+                finish(item, static_cast<long>(part));
+            }
+
+            lock.lock();
+        }
+    #endif
+}
+
+async_io_file::async_io_file(std::string const &file_path, size_t buffer_bytes, size_t buffers, bool append, async_io_writer &writer) :
+    _writer(writer), _descriptor(-1), _offset(0), _buffer_bytes(buffer_bytes == 0 ? default_buffer_bytes : buffer_bytes),
+    _slots_count(0), _current(0), _in_flight(0), _error(0)
+{
+    #ifdef __linux__
+        _descriptor = open(file_path.c_str(), O_WRONLY | O_CREAT | (append ? 0 : O_TRUNC) | O_CLOEXEC, 0644);
+        if (_descriptor == -1) {
+            throw std::runtime_error("Failed to open stream\n");
+        }
+
+        // writes go at offsets, a console or a pipe has none
+        struct stat status;
+        if (fstat(_descriptor, &status) != 0 || !S_ISREG(status.st_mode)) {
+            close(_descriptor);
+            throw std::runtime_error("Asynchronous io stream must be a regular file\n");
+        }
+        _offset = append ? static_cast<uint64_t>(status.st_size) : 0;
+
+        _slots_count = std::max<size_t>(buffers, 1);
+        _slots = std::make_unique<buffer_slot[]>(_slots_count);
+        for (size_t i = 0; i < _slots_count; ++i) {
+            _slots[i].bytes = std::make_unique<char[]>(_buffer_bytes);
+            _slots[i].size = 0;
+            _slots[i].in_flight.store(false, std::memory_order_relaxed);
+        }
+    #else
+        throw std::runtime_error("Asynchronous io streams are not supported\n");
+    #endif
+}
+
+async_io_file::~async_io_file() noexcept
+{
+    #ifdef __linux__
+        try {
+            submit();
+            wait();
+        } catch (...) {
+        }
+        close(_descriptor);
+    #endif
+}
+
+void async_io_file::write(char const *data, size_t size)
+{
+    while (size != 0) {
+        buffer_slot &slot = _slots[_current];
+        if (slot.in_flight.load(std::memory_order_acquire)) {
+            // the buffer may be held by a batch this thread has open
+            _writer.release_held();
+            std::unique_lock<std::mutex> lock(_mutex);
+            _completed.wait(lock, [&slot]() { return !slot.in_flight.load(std::memory_order_acquire); });
+        }
+
+        size_t part = std::min(size, _buffer_bytes - slot.size);
+        memcpy(slot.bytes.get() + slot.size, data, part);
+        slot.size += part;
+        data += part;
+        size -= part;
+        if (slot.size == _buffer_bytes) {
+            submit();
+        }
+    }
+}
+
+void async_io_file::submit()
+{
+    buffer_slot &slot = _slots[_current];
+    if (slot.size == 0) {
+        return;
+    }
+
+    slot.request = async_io_writer::request{_descriptor, _offset, slot.bytes.get(), slot.size, this};
+    _offset += slot.size;
+    slot.size = 0;
+    slot.in_flight.store(true, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++_in_flight;
+    }
+    _current = (_current + 1) % _slots_count;
+    _writer.submit(&slot.request);
+}
+
+void async_io_file::wait()
+{
+    _writer.release_held();
+    std::unique_lock<std::mutex> lock(_mutex);
+    _completed.wait(lock, [this]() { return _in_flight == 0; });
+}
+
+void async_io_file::completed(async_io_writer::request *item, int error)
+{
+    // the file may be gone once the lock is released, so everything is done under it
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (size_t i = 0; i < _slots_count; ++i) {
+        if (&_slots[i].request == item) {
+            _slots[i].in_flight.store(false, std::memory_order_release);
+        }
+    }
+    if (error != 0 && _error == 0) {
+        _error = error;
+    }
+    --_in_flight;
+    _completed.notify_all();
+}
+
+uint64_t async_io_file::size() const noexcept
+{
+    return _offset + _slots[_current].size;
+}
+
+int async_io_file::error() noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _error;
+}
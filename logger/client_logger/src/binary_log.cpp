@@ -0,0 +1,79 @@
+#include "../include/binary_log.h"
+
+#include <cstring>
+#include <stdexcept>
+
+binary_log::reader::reader(std::string const &file_path) :
+    _file(file_path, std::ios::binary)
+{
+    if (!_file.is_open()) {
+        throw std::runtime_error("Can't open file\n");
+    }
+
+    char header[sizeof(magic)];
+    if (!_file.read(header, sizeof(header)) || memcmp(header, magic, sizeof(magic)) != 0) {
+        throw std::runtime_error("Not a binary log\n");
+    }
+}
+
+bool binary_log::reader::next(decoded_record &record)
+{
+    std::runtime_error damaged_entry("Damaged binary log entry\n");
+
+    while (true) {
+        char header[entry_header_size];
+        if (!_file.read(header, sizeof(header))) {
+            if (_file.gcount() == 0) {
+                return false;
+            }
+            throw damaged_entry;
+        }
+
+        auto kind = static_cast<entry_kind>(header[0]);
+        uint32_t size;
+        memcpy(&size, header + 1, sizeof(size));
+
+        _payload.resize(size);
+        if (!_file.read(_payload.data(), size)) {
+            throw damaged_entry;
+        }
+
+        if (kind == entry_kind::format) {
+            if (size < sizeof(structured::format_id)) {
+                throw damaged_entry;
+            }
+            structured::format_id id;
+            memcpy(&id, _payload.data(), sizeof(id));
+            _formats[id] = _payload.substr(sizeof(id));
+            continue;
+        }
+
+        if (kind != entry_kind::record || size < record_header_size) {
+            throw damaged_entry;
+        }
+
+        char const *position = _payload.data();
+        if (static_cast<uint8_t>(*position) > static_cast<uint8_t>(logger::severity::critical)) {
+            throw damaged_entry;
+        }
+        record.severity = static_cast<logger::severity>(static_cast<uint8_t>(*position));
+        position += sizeof(uint8_t);
+        int64_t seconds;
+        memcpy(&seconds, position, sizeof(seconds));
+        record.seconds = static_cast<time_t>(seconds);
+        position += sizeof(int64_t);
+        memcpy(&record.nanoseconds, position, sizeof(uint32_t));
+        position += sizeof(uint32_t);
+        structured::format_id id;
+        memcpy(&id, position, sizeof(id));
+
+        auto format = _formats.find(id);
+        if (format == _formats.end()) {
+            throw damaged_entry;
+        }
+
+        record.message.clear();
+        structured::format(record.message, format->second, std::string_view(_payload).substr(record_header_size));
+        return true;
+    }
+}
@@ -1,30 +1,30 @@
 #include "../include/client_logger.h"
 
-std::map<std::string, std::pair<std::ofstream, int>> client_logger::_streams_users = std::map<std::string, std::pair<std::ofstream, int>>();
-
-client_logger::client_logger(std::map<std::string, std::set<logger::severity>> streams, std::string format)
-{
-    std::runtime_error file_opening("Failed to open stream\n");
-    for (auto &[file_name, severities] : streams) {
-        if (_streams_users.find(file_name) != _streams_users.end() && _streams_users[file_name].second != 0) {
-            _streams[file_name] = severities;
-        } else {
-            _streams_users[file_name].first.open(file_name);
-            if (!(_streams_users[file_name].first.is_open())) {
-                throw file_opening;
-            }
-            _streams[file_name] = severities;
-        }
-        (_streams_users[file_name].second)++;
+std::map<std::string, std::weak_ptr<file_sink>> client_logger::_sinks_registry = std::map<std::string, std::weak_ptr<file_sink>>();
+
+std::mutex client_logger::_sinks_registry_mutex;
+
+thread_local client_logger::record client_logger::_sync_record;
+
+client_logger::async_state::async_state(size_t capacity, overflow_policy policy) :
+    records(capacity), policy(policy), dropped(0), stopping(false), sleeping(false), flush_position(0), flushed_position(0) {}
+
+client_logger::client_logger(std::map<std::string, std::set<logger::severity>> streams, std::vector<format_segment> format, size_t async_capacity, overflow_policy policy, flush_policy sink_flush_policy, std::map<std::string, stream_options> options, log_limiter limiter) :
+    _format(std::move(format)), _routing(std::make_unique<routing_table>()), _enabled(0),
+    _sink_flush_policy(sink_flush_policy), _stream_options(std::move(options)), _limiter(limiter)
+{
+    publish(make_routing(std::move(streams), _stream_options));
+    if (async_capacity != 0) {
+        start_flusher(async_capacity, policy);
     }
-    _format = format;
 }
 
 client_logger::client_logger(client_logger const &other) :
-    _format(other._format), _streams(other._streams)
+    _format(other._format), _routing(std::make_unique<routing_table>(*other._routing.read())), _enabled(other._enabled.load()),
+    _sink_flush_policy(other._sink_flush_policy), _stream_options(other._stream_options), _limiter(other._limiter)
 {
-    for (auto &[key, pair] : _streams_users) {
-        pair.second++;
+    if (other._async != nullptr) {
+        start_flusher(other._async->records.capacity(), other._async->policy);
     }
 }
 
@@ -33,82 +33,534 @@ client_logger &client_logger::operator=(client_logger const &other)
     if (this == &other) {
         return *this;
     }
-    close_streams();
-    _streams = other._streams;
+    unwatch_configuration();
+    stop_flusher();
+    std::lock_guard<std::mutex> lock(_reconfiguration_mutex);
     _format = other._format;
-    for (auto &[key, pair] : _streams) {
-        _streams_users[key].second++;
+    _sink_flush_policy = other._sink_flush_policy;
+    _stream_options = other._stream_options;
+    _limiter = other._limiter;
+    publish(std::make_unique<routing_table>(*other._routing.read()));
+    if (other._async != nullptr) {
+        start_flusher(other._async->records.capacity(), other._async->policy);
     }
     return *this;
 }
 
 client_logger::client_logger(client_logger &&other) noexcept :
-    _streams(std::move(other._streams)), _format(std::move(other._format)) {}
+    _routing(std::make_unique<routing_table>()), _enabled(0)
+{
+    *this = std::move(other);
+}
 
 client_logger &client_logger::operator=(client_logger &&other) noexcept
 {
     if (this == &other) {
         return *this;
     }
-    close_streams();
+    unwatch_configuration();
+    stop_flusher();
+
+    // flusher and watcher threads are bound to the object, so they are stopped before the
+    // routes move and restarted here
+    size_t async_capacity = 0;
+    overflow_policy policy = overflow_policy::block;
+    if (other._async != nullptr) {
+        async_capacity = other._async->records.capacity();
+        policy = other._async->policy;
+        other.stop_flusher();
+    }
+    std::string watched_file;
+    std::string watched_path;
+    if (other._watcher != nullptr) {
+        watched_file = other._watcher->file_path();
+        watched_path = other._watched_path;
+        other.unwatch_configuration();
+    }
+
+    std::unique_lock<std::mutex> lock(_reconfiguration_mutex);
     _format = std::move(other._format);
-    _streams = std::move(other._streams);
+    _sink_flush_policy = other._sink_flush_policy;
+    _stream_options = std::move(other._stream_options);
+    _limiter = other._limiter;
+    try {
+        publish(other._routing.exchange(std::make_unique<routing_table>()));
+    } catch (...) {
+    }
+    other._enabled.store(0, std::memory_order_relaxed);
+    lock.unlock();
+
+    if (async_capacity != 0) {
+        start_flusher(async_capacity, policy);
+    }
+    if (!watched_file.empty()) {
+        try {
+            watch_configuration(watched_file, watched_path);
+        } catch (...) {
+        }
+    }
     return *this;
 }
 
-void client_logger::close_streams()
+std::shared_ptr<file_sink> client_logger::acquire_sink(std::string const &file_name, flush_policy sink_flush_policy, stream_options const &options)
 {
-    for (auto &[file_name, severities] : _streams) {
-        if ((--_streams_users[file_name].second) == 0) {
-            _streams_users[file_name].first.close();
-            _streams_users.erase(file_name);
+    std::lock_guard<std::mutex> lock(_sinks_registry_mutex);
+
+    auto found = _sinks_registry.find(file_name);
+    if (found != _sinks_registry.end()) {
+        if (auto sink = found->second.lock()) {
+            if (sink->is_binary() != options.binary) {
+                throw std::runtime_error("Stream is used both as text and binary\n");
+            }
+            if (!sink->matches(options)) {
+                throw std::runtime_error("Stream is already opened with other options\n");
+            }
+            return sink;
         }
     }
+
+    auto sink = std::make_shared<file_sink>(file_name, sink_flush_policy, options);
+    if (!sink->is_open()) {
+        throw std::runtime_error("Failed to open stream\n");
+    }
+    _sinks_registry[file_name] = sink;
+
+    // dropping entries whose last logger is gone
+    std::erase_if(_sinks_registry, [](auto const &entry) { return entry.second.expired(); });
+    return sink;
+}
+
+std::unique_ptr<client_logger::routing_table> client_logger::make_routing(std::map<std::string, std::set<logger::severity>> streams, std::map<std::string, stream_options> const &options, bool append) const
+{
+    auto routing = std::make_unique<routing_table>();
+    routing->streams = std::move(streams);
+
+    for (auto &[file_name, severities] : routing->streams) {
+        auto found = options.find(file_name);
+        stream_options stream = found == options.end() ? stream_options() : found->second;
+        stream.append = append;
+        routing->sinks.push_back(acquire_sink(file_name, _sink_flush_policy, stream));
+        routing->async_io |= routing->sinks.back()->is_async_io();
+        for (auto severity : severities) {
+            routing->routes[static_cast<size_t>(severity)].push_back(routing->sinks.back().get());
+            routing->enabled |= 1u << static_cast<size_t>(severity);
+        }
+    }
+    return routing;
+}
+
+void client_logger::publish(std::unique_ptr<routing_table> routing)
+{
+    uint32_t enabled = routing->enabled;
+
+    // a severity turned off stops first and one turned on starts once its routes are there,
+    // anything in between only finds a severity without routes
+    _enabled.fetch_and(enabled, std::memory_order_release);
+    auto retired = _routing.exchange(std::move(routing));
+    _enabled.store(enabled, std::memory_order_release);
+
+    // records of the old routing still in the queue go by the new one, so the old sinks
+    // get what they were given before it is dropped
+    for (auto &sink : retired->sinks) {
+        sink->flush();
+    }
+}
+
+void client_logger::reconfigure(std::map<std::string, std::set<logger::severity>> streams, std::map<std::string, stream_options> options)
+{
+    std::lock_guard<std::mutex> lock(_reconfiguration_mutex);
+
+    // the options are kept only once the new routes are published
+    for (auto &[file_name, stream] : _stream_options) {
+        options.try_emplace(file_name, stream);
+    }
+    publish(make_routing(std::move(streams), options, true));
+    _stream_options = std::move(options);
+}
+
+void client_logger::reconfigure(std::string const &configuration_file_path, std::string const &configuration_path)
+{
+    client_logger_builder builder;
+    builder.transform_with_configuration(configuration_file_path, configuration_path);
+
+    // streams the configuration says nothing else about keep their options
+    std::map<std::string, stream_options> options;
+    for (auto &[file_name, stream] : builder._stream_options) {
+        options[file_name] = builder.resolve_options(stream);
+    }
+    reconfigure(std::move(builder._streams), std::move(options));
+}
+
+void client_logger::watch_configuration(std::string const &configuration_file_path, std::string const &configuration_path)
+{
+    unwatch_configuration();
+    _watched_path = configuration_path;
+    _watcher = std::make_unique<configuration_watcher>(configuration_file_path, [this, configuration_file_path, configuration_path]() {
+        reconfigure(configuration_file_path, configuration_path);
+    });
+}
+
+void client_logger::unwatch_configuration() noexcept
+{
+    _watcher.reset();
 }
 
 client_logger::~client_logger() noexcept
 {
-    close_streams();
+    unwatch_configuration();
+    report_suppressed();
+    stop_flusher();
 }
 
-void replace_substring(std::string &str, const std::string &to_replace, const std::string &replace_with)
+void client_logger::start_flusher(size_t capacity, overflow_policy policy)
 {
-    size_t pos = 0;
-    while ((pos = str.find(to_replace, pos)) != std::string::npos)
+    _async = std::make_unique<async_state>(capacity, policy);
+    _async->flusher = std::thread(&client_logger::flusher_loop, this);
+}
+
+void client_logger::stop_flusher() noexcept
+{
+    if (_async == nullptr) {
+        return;
+    }
     {
-        str.replace(pos, to_replace.size(), replace_with);
-        pos += replace_with.size();
+        std::lock_guard<std::mutex> lock(_async->mutex);
+        _async->stopping.store(true, std::memory_order_release);
+    }
+    _async->wakeup.notify_one();
+    if (_async->flusher.joinable()) {
+        _async->flusher.join();
     }
+    _async.reset();
 }
 
-void format_to_message(std::string &replaced_format, const std::string &message, const std::string & string_severity)
+void client_logger::flusher_loop() const noexcept
 {
-    time_t time_now = time(NULL);
-    char tmp_date_time[20];
+    record item;
 
-    std::string MSG = "%m";
-    std::string SEV = "%s";
-    std::string TIME = "%t";
-    std::string DATE = "%d";
+    while (true) {
+        size_t written = 0;
+        {
+            // a batch goes by one routing, a reconfiguration waits for the batch at most
+            auto routing = _routing.read();
+            while (written < flusher_batch_size && _async->records.try_pop(item)) {
+                write_record(*routing, item, false);
+                ++written;
+            }
 
-    replace_substring(replaced_format, MSG, message);
-    replace_substring(replaced_format, SEV, string_severity);
-    strftime(tmp_date_time, sizeof(tmp_date_time), "%T", localtime(&time_now));
-    replace_substring(replaced_format, TIME, tmp_date_time);
-    strftime(tmp_date_time, sizeof(tmp_date_time), "%F", localtime(&time_now));
-    replace_substring(replaced_format, DATE, tmp_date_time);
+            // flushes requested by the batch are coalesced into one per stream, the buffers of
+            // asynchronous io streams then go to the kernel in one submission
+            async_io_writer::batch submissions(routing->async_io ? &async_io_writer::shared() : nullptr);
+            for (auto &sink : routing->sinks) {
+                sink->flush_if_requested();
+            }
+        }
+
+        // a ticket is served once every record pushed before it is off the queue, whether
+        // written by this thread or evicted by a producer
+        size_t requested = _async->flush_position.load(std::memory_order_acquire);
+        if (requested > _async->flushed_position.load(std::memory_order_relaxed) && _async->records.popped() >= requested) {
+            auto routing = _routing.read();
+            for (auto &sink : routing->sinks) {
+                sink->flush();
+            }
+            _async->flushed_position.store(requested, std::memory_order_release);
+            continue;
+        }
+
+        if (written != 0) {
+            continue;
+        }
+
+        if (_async->stopping.load(std::memory_order_acquire)) {
+            if (_async->records.empty()) {
+                return;
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_async->mutex);
+        _async->sleeping.store(true, std::memory_order_seq_cst);
+        if (_async->records.empty() && !_async->stopping.load(std::memory_order_acquire)
+            && _async->flush_position.load(std::memory_order_acquire) == _async->flushed_position.load(std::memory_order_acquire)) {
+            _async->wakeup.wait_for(lock, std::chrono::milliseconds(10));
+        }
+        _async->sleeping.store(false, std::memory_order_relaxed);
+        lock.unlock();
+
+        auto routing = _routing.read();
+        for (auto &sink : routing->sinks) {
+            sink->flush_if_expired();
+        }
+    }
 }
 
-logger const *client_logger::log(const std::string &text, logger::severity severity) const noexcept
+void client_logger::enqueue(record &&item) const noexcept
 {
-    std::string string_severity = severity_to_string(severity);
-    std::string message = _format;
-    format_to_message(message, text, string_severity);
+    switch (_async->policy) {
+        case overflow_policy::block:
+            while (!_async->records.try_push(std::move(item))) {
+                _async->wakeup.notify_one();
+                std::this_thread::yield();
+            }
+            break;
+        case overflow_policy::drop_oldest:
+            while (!_async->records.try_push(std::move(item))) {
+                record evicted;
+                if (_async->records.try_pop(evicted)) {
+                    _async->dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            break;
+        case overflow_policy::drop:
+            if (!_async->records.try_push(std::move(item))) {
+                _async->dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            break;
+    }
 
-    for (auto & [file_name, severities] : _streams) {
-        if (severities.find(severity) != severities.end()) {
-            _streams_users[file_name].first << message << std::endl;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_async->sleeping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(_async->mutex);
+        _async->wakeup.notify_one();
+    }
+}
+
+std::vector<client_logger::format_segment> client_logger::compile_format(std::string const &format)
+{
+    std::vector<format_segment> segments;
+    std::string literal;
+
+    for (size_t i = 0; i < format.size(); ++i) {
+        format_segment::field type = format_segment::field::literal;
+        if (format[i] == '%' && i + 1 < format.size()) {
+            switch (format[i + 1]) {
+                case 'm':
+                    type = format_segment::field::message;
+                    break;
+                case 's':
+                    type = format_segment::field::severity;
+                    break;
+                case 't':
+                    type = format_segment::field::time;
+                    break;
+                case 'd':
+                    type = format_segment::field::date;
+                    break;
+                case 'f':
+                    type = format_segment::field::milliseconds;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        if (type == format_segment::field::literal) {
+            literal += format[i];
+            continue;
+        }
+        if (!literal.empty()) {
+            segments.push_back(format_segment{format_segment::field::literal, std::move(literal)});
+            literal.clear();
         }
+        segments.push_back(format_segment{type, ""});
+        ++i;
+    }
+    if (!literal.empty()) {
+        segments.push_back(format_segment{format_segment::field::literal, std::move(literal)});
     }
+
+    return segments;
+}
+
+namespace
+{
+
+    std::string_view severity_name(logger::severity severity) noexcept
+    {
+        static constexpr std::string_view names[] = { "TRACE", "DEBUG", "INFORMATION", "WARNING", "ERROR", "CRITICAL" };
+        return names[static_cast<size_t>(severity)];
+    }
+
+    thread_local std::string format_buffer;
+
+    // plain text records encoded for binary streams
+    thread_local std::string arguments_buffer;
+
+}
+
+void client_logger::format_record(std::string &buffer, record const &item) const
+{
+    buffer.clear();
+    for (auto &segment : _format) {
+        switch (segment.type) {
+            case format_segment::field::literal:
+                buffer += segment.literal;
+                break;
+            case format_segment::field::message:
+                if (item.format == plain_text) {
+                    buffer += item.text;
+                } else {
+                    structured::format(buffer, structured::format_of(item.format), item.text);
+                }
+                break;
+            case format_segment::field::severity:
+                buffer += severity_name(item.severity);
+                break;
+            case format_segment::field::time:
+                buffer += log_clock::calendar_of(item.time).time;
+                break;
+            case format_segment::field::date:
+                buffer += log_clock::calendar_of(item.time).date;
+                break;
+            case format_segment::field::milliseconds:
+            {
+                char fraction[log_clock::max_fraction_digits + 1];
+                buffer.append(fraction, log_clock::format_fraction(fraction, item.nanoseconds, 3));
+                break;
+            }
+        }
+    }
+    buffer += '\n';
+}
+
+void client_logger::write_record(routing_table const &routing, record const &item, bool flush) const
+{
+    bool formatted = false;
+    bool encoded = false;
+
+    for (auto sink : routing.routes[static_cast<size_t>(item.severity)]) {
+        if (!sink->is_binary()) {
+            if (!formatted) {
+                format_record(format_buffer, item);
+                formatted = true;
+            }
+            sink->write(format_buffer.data(), format_buffer.size(), item.severity, !flush);
+            continue;
+        }
+
+        if (item.format != plain_text) {
+            sink->write_structured(item.severity, item.time, item.nanoseconds, item.format, item.text, !flush);
+            continue;
+        }
+        if (!encoded) {
+            arguments_buffer.clear();
+            structured::encode_arguments(arguments_buffer, item.text);
+            encoded = true;
+        }
+        sink->write_structured(item.severity, item.time, item.nanoseconds, structured::text_format, arguments_buffer, !flush);
+    }
+}
+
+void client_logger::stamp(record &item) noexcept
+{
+    auto now = log_clock::now();
+    item.time = now.seconds;
+    item.nanoseconds = now.nanoseconds;
+}
+
+void client_logger::submit(record &&item) const noexcept
+{
+    if (_async == nullptr) {
+        write_record(*_routing.read(), item, true);
+        return;
+    }
+    enqueue(std::move(item));
+}
+
+void client_logger::report_suppressed() const noexcept
+{
+    if (!_limiter.active()) {
+        return;
+    }
+    for (size_t i = 0; i < severities_count; ++i) {
+        auto severity = static_cast<logger::severity>(i);
+        size_t suppressed = _limiter.take_suppressed(severity);
+        if (suppressed == 0 || !is_enabled(severity)) {
+            continue;
+        }
+        try {
+            log_admitted(log_limiter::summary(suppressed), severity);
+        } catch (...) {
+        }
+    }
+}
+
+bool client_logger::admit(logger::severity severity) const noexcept
+{
+    if (!is_enabled(severity)) {
+        return false;
+    }
+    if (!_limiter.active()) {
+        return true;
+    }
+
+    int64_t now = token_bucket::now();
+    if (_limiter.summary_due(now)) {
+        report_suppressed();
+    }
+    return _limiter.admit(severity, now);
+}
+
+logger const *client_logger::log(const std::string &text, logger::severity severity) const noexcept
+{
+    if (!admit(severity)) {
+        return this;
+    }
+    return log_admitted(text, severity);
+}
+
+logger const *client_logger::log_admitted(const std::string &text, logger::severity severity) const noexcept
+{
+    if (_async == nullptr) {
+        auto &item = _sync_record;
+        item.severity = severity;
+        item.text.assign(text);
+        item.format = plain_text;
+        stamp(item);
+        write_record(*_routing.read(), item, true);
+        return this;
+    }
+
+    record item{severity, text, 0, 0, plain_text};
+    stamp(item);
+    enqueue(std::move(item));
     return this;
-}
\ No newline at end of file
+}
+
+bool client_logger::is_enabled(logger::severity severity) const noexcept
+{
+    return (_enabled.load(std::memory_order_relaxed) >> static_cast<size_t>(severity) & 1) != 0;
+}
+
+size_t client_logger::dropped_records() const noexcept
+{
+    return _async == nullptr ? 0 : _async->dropped.load(std::memory_order_relaxed);
+}
+
+void client_logger::flush() const
+{
+    report_suppressed();
+
+    if (_async == nullptr) {
+        auto routing = _routing.read();
+        for (auto &sink : routing->sinks) {
+            sink->flush();
+        }
+        return;
+    }
+
+    // records logged before this call hold positions below the snapshot
+    size_t target = _async->records.pushed();
+    size_t requested = _async->flush_position.load(std::memory_order_relaxed);
+    while (requested < target && !_async->flush_position.compare_exchange_weak(requested, target, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+    {
+        std::lock_guard<std::mutex> lock(_async->mutex);
+        _async->wakeup.notify_one();
+    }
+    while (_async->flushed_position.load(std::memory_order_acquire) < target) {
+        std::this_thread::yield();
+    }
+}
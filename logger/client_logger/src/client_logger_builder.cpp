@@ -1,9 +1,15 @@
 #include "../include/client_logger_builder.h"
 
-client_logger_builder::client_logger_builder() : _format("[%s] %m\n") {}
+client_logger_builder::client_logger_builder() :
+    _map_window(mapped_file::default_window_bytes), _compression_block(compressed_log::default_block_bytes),
+    _async_io_buffer(async_io_file::default_buffer_bytes), _format("[%s] %m\n"), _async_capacity(0), _overflow_policy(overflow_policy::block),
+    _summary_interval(log_limiter::default_summary_interval) {}
 
 client_logger_builder::client_logger_builder(client_logger_builder const &other) :
-    _format(other._format), _streams(other._streams) {}
+    _streams(other._streams), _stream_options(other._stream_options), _map_window(other._map_window),
+    _compression_block(other._compression_block), _async_io_buffer(other._async_io_buffer), _format(other._format),
+    _async_capacity(other._async_capacity), _overflow_policy(other._overflow_policy), _flush_policy(other._flush_policy),
+    _rotation(other._rotation), _rate_limits(other._rate_limits), _summary_interval(other._summary_interval) {}
 
 client_logger_builder &client_logger_builder::operator=(client_logger_builder const &other)
 {
@@ -11,12 +17,25 @@ client_logger_builder &client_logger_builder::operator=(client_logger_builder co
         return *this;
     }
     _streams = other._streams;
+    _stream_options = other._stream_options;
+    _map_window = other._map_window;
+    _compression_block = other._compression_block;
+    _async_io_buffer = other._async_io_buffer;
     _format = other._format;
+    _async_capacity = other._async_capacity;
+    _overflow_policy = other._overflow_policy;
+    _flush_policy = other._flush_policy;
+    _rotation = other._rotation;
+    _rate_limits = other._rate_limits;
+    _summary_interval = other._summary_interval;
     return *this;
 }
 
 client_logger_builder::client_logger_builder(client_logger_builder &&other) noexcept :
-    _streams(std::move(other._streams)), _format(std::move(other._format)) {}
+    _streams(std::move(other._streams)), _stream_options(std::move(other._stream_options)), _map_window(other._map_window),
+    _compression_block(other._compression_block), _async_io_buffer(other._async_io_buffer), _format(std::move(other._format)),
+    _async_capacity(other._async_capacity), _overflow_policy(other._overflow_policy), _flush_policy(other._flush_policy),
+    _rotation(other._rotation), _rate_limits(other._rate_limits), _summary_interval(other._summary_interval) {}
 
 client_logger_builder &client_logger_builder::operator=(client_logger_builder &&other) noexcept
 {
@@ -25,6 +44,16 @@ client_logger_builder &client_logger_builder::operator=(client_logger_builder &&
     }
     _format = std::move(other._format);
     _streams = std::move(other._streams);
+    _stream_options = std::move(other._stream_options);
+    _map_window = other._map_window;
+    _compression_block = other._compression_block;
+    _async_io_buffer = other._async_io_buffer;
+    _async_capacity = other._async_capacity;
+    _overflow_policy = other._overflow_policy;
+    _flush_policy = other._flush_policy;
+    _rotation = other._rotation;
+    _rate_limits = other._rate_limits;
+    _summary_interval = other._summary_interval;
     return *this;
 }
 
@@ -42,6 +71,65 @@ logger_builder *client_logger_builder::add_console_stream(logger::severity sever
     return this;
 }
 
+logger_builder *client_logger_builder::add_binary_file_stream(std::string const &stream_file_path, logger::severity severity)
+{
+    _streams[stream_file_path].insert(severity);
+    _stream_options[stream_file_path].options.binary = true;
+    return this;
+}
+
+logger_builder *client_logger_builder::add_mapped_file_stream(std::string const &stream_file_path, logger::severity severity)
+{
+    set_kind(stream_file_path, stream_kind::mapped);
+    _streams[stream_file_path].insert(severity);
+    return this;
+}
+
+logger_builder *client_logger_builder::add_compressed_file_stream(std::string const &stream_file_path, logger::severity severity)
+{
+    set_kind(stream_file_path, stream_kind::compressed);
+    _streams[stream_file_path].insert(severity);
+    return this;
+}
+
+logger_builder *client_logger_builder::add_async_io_file_stream(std::string const &stream_file_path, logger::severity severity)
+{
+    set_kind(stream_file_path, stream_kind::async_io);
+    _streams[stream_file_path].insert(severity);
+    return this;
+}
+
+void client_logger_builder::set_kind(std::string const &stream_file_path, stream_kind kind)
+{
+    auto &options = _stream_options[stream_file_path].options;
+    if (options.kind != stream_kind::plain && options.kind != kind) {
+        throw std::runtime_error("Stream can be only one of mapped, compressed and asynchronous io\n");
+    }
+    options.kind = kind;
+}
+
+stream_options client_logger_builder::resolve_options(configured_stream const &stream) const
+{
+    stream_options options = stream.options;
+    switch (options.kind) {
+        case stream_kind::mapped:
+            options.kind_bytes = _map_window;
+            break;
+        case stream_kind::compressed:
+            options.kind_bytes = _compression_block;
+            break;
+        case stream_kind::async_io:
+            options.kind_bytes = _async_io_buffer;
+            break;
+        case stream_kind::plain:
+            break;
+    }
+    if (!stream.own_rotation) {
+        options.rotation = _rotation;
+    }
+    return options;
+}
+
 logger_builder* client_logger_builder::transform_with_configuration(std::string const &configuration_file_path, std::string const &configuration_path)
 {
     std::runtime_error nonexistent_file("Configuration file doesn't exist\n");
@@ -65,13 +153,47 @@ logger_builder* client_logger_builder::transform_with_configuration(std::string
     std::string string_severity;
     logger::severity logger_severity;
 
-    for (auto & file : configuration[configuration_path]) {
+    auto &node = configuration[configuration_path];
+    auto &files = node.is_object() ? node["streams"] : node;
+    if (node.is_object()) {
+        if (node.contains("rate_limits")) {
+            log_limiter::read_limits(node["rate_limits"], _rate_limits, &string_to_severity);
+        }
+        _summary_interval = std::chrono::milliseconds(node.value("summary_interval_ms", static_cast<int64_t>(_summary_interval.count())));
+        _map_window = node.value("map_window_bytes", _map_window);
+        _compression_block = node.value("compression_block_bytes", _compression_block);
+        _async_io_buffer = node.value("async_io_buffer_bytes", _async_io_buffer);
+    }
+
+    for (auto & file : files) {
         file_name = file[0];
         for (auto & severity : file[1]) {
             string_severity = severity;
             logger_severity = string_to_severity(string_severity);
             _streams[file_name].insert(logger_severity);
         }
+
+        // optional third element: {"rotate_bytes": n, "rotate_interval_ms": n, "kept_segments": n, "preallocate": bool,
+        // "mapped": bool, "compressed": bool, "async_io": bool}
+        if (file.size() > 2 && file[2].is_object()) {
+            if (file[2].value("mapped", false)) {
+                set_kind(file_name, stream_kind::mapped);
+            }
+            if (file[2].value("compressed", false)) {
+                set_kind(file_name, stream_kind::compressed);
+            }
+            if (file[2].value("async_io", false)) {
+                set_kind(file_name, stream_kind::async_io);
+            }
+            auto &stream = _stream_options[file_name];
+            auto &rotation = stream.options.rotation;
+            rotation = rotation_policy();
+            rotation.bytes = file[2].value("rotate_bytes", rotation.bytes);
+            rotation.interval = std::chrono::milliseconds(file[2].value("rotate_interval_ms", static_cast<int64_t>(rotation.interval.count())));
+            rotation.kept_segments = file[2].value("kept_segments", rotation.kept_segments);
+            rotation.preallocate = file[2].value("preallocate", rotation.preallocate);
+            stream.own_rotation = true;
+        }
     }
     return this;
 }
@@ -82,16 +204,75 @@ logger_builder *client_logger_builder::clear()
         file.second.clear();
     }
     _streams.clear();
+    _stream_options.clear();
     return this;
 }
 
 logger *client_logger_builder::build() const
 {
-    return new client_logger(_streams, _format);
+    std::map<std::string, stream_options> options;
+    for (auto &[file_name, severities] : _streams) {
+        auto configured = _stream_options.find(file_name);
+        options[file_name] = resolve_options(configured == _stream_options.end() ? configured_stream() : configured->second);
+    }
+
+    return new client_logger(_streams, client_logger::compile_format(_format), _async_capacity, _overflow_policy, _flush_policy,
+        std::move(options), log_limiter(_rate_limits, _summary_interval));
 }
 
 logger_builder * client_logger_builder::set_format(std::string &format)
 {
     _format = format;
     return this;
+}
+
+logger_builder * client_logger_builder::set_async(size_t buffer_capacity, overflow_policy policy)
+{
+    // zero capacity switches back to synchronous writes
+    _async_capacity = buffer_capacity;
+    _overflow_policy = policy;
+    return this;
+}
+
+logger_builder * client_logger_builder::set_flush_policy(flush_policy policy)
+{
+    // applies to the streams this logger opens, already opened ones keep their policy
+    _flush_policy = policy;
+    return this;
+}
+
+logger_builder * client_logger_builder::set_rotation(rotation_policy policy)
+{
+    // like the flush policy, streams already opened by other loggers keep their rotation
+    _rotation = policy;
+    return this;
+}
+logger_builder * client_logger_builder::set_rate_limit(logger::severity severity, rate_limit limit)
+{
+    _rate_limits[static_cast<size_t>(severity)] = limit;
+    return this;
+}
+
+logger_builder * client_logger_builder::set_suppression_summary(std::chrono::milliseconds interval)
+{
+    _summary_interval = interval;
+    return this;
+}
+
+logger_builder * client_logger_builder::set_compression_block(size_t block_bytes)
+{
+    _compression_block = block_bytes == 0 ? compressed_log::default_block_bytes : block_bytes;
+    return this;
+}
+
+logger_builder * client_logger_builder::set_map_window(size_t window_bytes)
+{
+    _map_window = window_bytes == 0 ? mapped_file::default_window_bytes : window_bytes;
+    return this;
+}
+
+logger_builder * client_logger_builder::set_async_io_buffer(size_t buffer_bytes)
+{
+    _async_io_buffer = buffer_bytes == 0 ? async_io_file::default_buffer_bytes : buffer_bytes;
+    return this;
 }
\ No newline at end of file
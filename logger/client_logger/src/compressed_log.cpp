@@ -0,0 +1,240 @@
+#include "../include/compressed_log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "../include/lz_block.h"
+
+uint32_t compressed_log::checksum(char const *data, size_t size) noexcept
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<uint8_t>(data[i])) * 16777619u;
+    }
+    return hash;
+}
+
+compressed_log::writer::writer(std::string const &file_path, size_t block_bytes) :
+    _file(file_path, std::ios::out | std::ios::binary), _block_bytes(block_bytes == 0 ? default_block_bytes : block_bytes),
+    _compressing(false), _stopping(false), _raw_offset(0)
+{
+    if (!_file.is_open()) {
+        throw std::runtime_error("Failed to open stream\n");
+    }
+    _file.write(magic, sizeof(magic));
+    _file.flush();
+    _block.reserve(_block_bytes);
+    _compressor = std::thread(&writer::compressor_loop, this);
+}
+
+compressed_log::writer::~writer() noexcept
+{
+    try {
+        seal();
+    } catch (...) {
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wakeup.notify_one();
+    _compressor.join();
+    _file.close();
+}
+
+void compressed_log::writer::write(char const *data, size_t size)
+{
+    while (size != 0) {
+        size_t part = std::min(size, _block_bytes - _block.size());
+        _block.append(data, part);
+        data += part;
+        size -= part;
+        if (_block.size() == _block_bytes) {
+            seal();
+        }
+    }
+}
+
+void compressed_log::writer::seal()
+{
+    if (_block.empty()) {
+        return;
+    }
+
+    std::string next;
+    next.reserve(_block_bytes);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _sealed.push_back(std::move(_block));
+    }
+    _block = std::move(next);
+    _wakeup.notify_one();
+}
+
+void compressed_log::writer::flush()
+{
+    seal();
+    std::unique_lock<std::mutex> lock(_mutex);
+    _drained.wait(lock, [this]() { return _sealed.empty() && !_compressing; });
+}
+
+void compressed_log::writer::compressor_loop()
+{
+    std::string stored;
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    while (true) {
+        _wakeup.wait(lock, [this]() { return _stopping || !_sealed.empty(); });
+        if (_sealed.empty()) {
+            return;
+        }
+
+        std::string raw = std::move(_sealed.front());
+        _sealed.pop_front();
+        _compressing = true;
+        lock.unlock();
+
+        write_block(raw, stored);
+
+        lock.lock();
+        _compressing = false;
+        if (_sealed.empty()) {
+            _file.flush();
+            _drained.notify_all();
+        }
+    }
+}
+
+void compressed_log::writer::write_block(std::string const &raw, std::string &stored)
+{
+    stored.clear();
+    lz_block::compress(raw, stored);
+
+    // what doesn't get smaller is kept as it is
+    auto method = block_method::lz;
+    std::string_view payload = stored;
+    if (stored.size() >= raw.size()) {
+        method = block_method::stored;
+        payload = raw;
+    }
+
+    char header[block_header_size] = {};
+    char *position = header;
+    *position = static_cast<char>(method);
+    position += sizeof(uint32_t);
+    auto stored_size = static_cast<uint32_t>(payload.size());
+    memcpy(position, &stored_size, sizeof(stored_size));
+    position += sizeof(stored_size);
+    auto raw_size = static_cast<uint32_t>(raw.size());
+    memcpy(position, &raw_size, sizeof(raw_size));
+    position += sizeof(raw_size);
+    uint32_t raw_checksum = checksum(raw.data(), raw.size());
+    memcpy(position, &raw_checksum, sizeof(raw_checksum));
+    position += sizeof(raw_checksum);
+    memcpy(position, &_raw_offset, sizeof(_raw_offset));
+
+    _file.write(header, sizeof(header));
+    _file.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+    _raw_offset += raw.size();
+}
+
+bool compressed_log::writer::is_open() const noexcept
+{
+    return _file.is_open();
+}
+
+compressed_log::reader::reader(std::string const &file_path) :
+    _file(file_path, std::ios::binary)
+{
+    if (!_file.is_open()) {
+        throw std::runtime_error("Can't open file\n");
+    }
+
+    char header[block_header_size];
+    if (!_file.read(header, sizeof(magic)) || memcmp(header, magic, sizeof(magic)) != 0) {
+        throw std::runtime_error("Not a compressed log\n");
+    }
+
+    _file.seekg(0, std::ios::end);
+    auto file_size = static_cast<uint64_t>(_file.tellg());
+    uint64_t file_offset = sizeof(magic);
+
+    // only the headers are read, every block is skipped over
+    while (file_offset + block_header_size <= file_size) {
+        _file.seekg(static_cast<std::streamoff>(file_offset));
+        if (!_file.read(header, sizeof(header))) {
+            break;
+        }
+
+        block_info block;
+        char const *position = header;
+        block.method = static_cast<block_method>(*position);
+        position += sizeof(uint32_t);
+        memcpy(&block.stored_size, position, sizeof(block.stored_size));
+        position += sizeof(block.stored_size);
+        memcpy(&block.raw_size, position, sizeof(block.raw_size));
+        position += sizeof(block.raw_size);
+        memcpy(&block.checksum, position, sizeof(block.checksum));
+        position += sizeof(block.checksum);
+        memcpy(&block.raw_offset, position, sizeof(block.raw_offset));
+        block.file_offset = file_offset + block_header_size;
+
+        if (block.file_offset + block.stored_size > file_size) {
+            break;
+        }
+        _blocks.push_back(block);
+        file_offset = block.file_offset + block.stored_size;
+    }
+    _file.clear();
+}
+
+std::vector<compressed_log::block_info> const &compressed_log::reader::blocks() const noexcept
+{
+    return _blocks;
+}
+
+size_t compressed_log::reader::find_block(uint64_t raw_offset) const noexcept
+{
+    auto found = std::upper_bound(_blocks.begin(), _blocks.end(), raw_offset, [](uint64_t offset, block_info const &block) {
+        return offset < block.raw_offset + block.raw_size;
+    });
+    return static_cast<size_t>(found - _blocks.begin());
+}
+
+void compressed_log::reader::read_block(size_t index, std::string &out)
+{
+    std::runtime_error damaged_block("Damaged compressed block\n");
+
+    auto const &block = _blocks.at(index);
+    _stored.resize(block.stored_size);
+    _file.seekg(static_cast<std::streamoff>(block.file_offset));
+    if (!_file.read(_stored.data(), block.stored_size)) {
+        throw damaged_block;
+    }
+
+    size_t start = out.size();
+    switch (block.method) {
+        case block_method::stored:
+            if (block.stored_size != block.raw_size) {
+                throw damaged_block;
+            }
+            out.append(_stored);
+            break;
+        case block_method::lz:
+            try {
+                lz_block::decompress(_stored, block.raw_size, out);
+            } catch (...) {
+                out.resize(start);
+                throw;
+            }
+            break;
+        default:
+            throw damaged_block;
+    }
+
+    if (checksum(out.data() + start, block.raw_size) != block.checksum) {
+        out.resize(start);
+        throw damaged_block;
+    }
+}
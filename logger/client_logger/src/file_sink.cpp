@@ -0,0 +1,420 @@
+#include "../include/file_sink.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#ifdef __linux__
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace
+{
+
+    size_t kind_bytes_or_default(stream_kind kind, size_t bytes) noexcept
+    {
+        switch (kind) {
+            case stream_kind::mapped:
+                return bytes == 0 ? mapped_file::default_window_bytes : bytes;
+            case stream_kind::compressed:
+                return bytes == 0 ? compressed_log::default_block_bytes : bytes;
+            case stream_kind::async_io:
+                return bytes == 0 ? async_io_file::default_buffer_bytes : bytes;
+            case stream_kind::plain:
+                break;
+        }
+        return 0;
+    }
+
+}
+
+file_sink::file_sink(std::string const &file_path, flush_policy policy, stream_options const &options, size_t buffer_size) :
+    _buffer(buffer_size == 0 || options.kind != stream_kind::plain ? nullptr : std::make_unique<char[]>(buffer_size)),
+    _policy(policy),
+    _unflushed(0),
+    _last_flush(std::chrono::steady_clock::now()),
+    _flush_requested(false),
+    _binary(options.binary),
+    _options(options),
+    _rotatable(false),
+    _path(file_path),
+    _mode((options.binary ? std::ios::out | std::ios::binary : std::ios::out) | (options.append ? std::ios::app : std::ios::openmode())),
+    _buffer_size(_buffer == nullptr ? 0 : buffer_size),
+    _rotation(options.kind == stream_kind::plain ? options.rotation : rotation_policy()),
+    _segment_size(0),
+    _next_segment_index(1),
+    _spare_ready(false),
+    _prepare_requested(false),
+    _stopping(false)
+{
+    _options.kind_bytes = kind_bytes_or_default(options.kind, options.kind_bytes);
+
+    switch (options.kind) {
+        case stream_kind::async_io:
+            _async_io = std::make_unique<async_io_file>(_path, _options.kind_bytes, async_io_file::default_buffers, options.append);
+            if (_binary && _async_io->size() == 0) {
+                _async_io->write(binary_log::magic, sizeof(binary_log::magic));
+            }
+            return;
+        case stream_kind::compressed:
+            _compressed = std::make_unique<compressed_log::writer>(_path, _options.kind_bytes);
+            if (_binary) {
+                _compressed->write(binary_log::magic, sizeof(binary_log::magic));
+            }
+            return;
+        case stream_kind::mapped:
+            _mapped = std::make_unique<mapped_file>(_path, _options.kind_bytes);
+            if (_binary) {
+                _mapped->write(binary_log::magic, sizeof(binary_log::magic));
+            }
+            return;
+        case stream_kind::plain:
+            break;
+    }
+
+    open_segment();
+
+    // consoles and pipes are never rotated
+    std::error_code error;
+    _rotatable = _stream.is_open() && std::filesystem::is_regular_file(_path, error);
+    if (!_rotation.enabled() || !_rotatable) {
+        _rotation = rotation_policy();
+        return;
+    }
+
+    // numbering goes on from segments left by earlier runs
+    std::filesystem::path path(_path);
+    std::string prefix = path.filename().string() + ".";
+    auto directory = path.parent_path().empty() ? std::filesystem::path(".") : path.parent_path();
+    for (auto const &entry : std::filesystem::directory_iterator(directory, error)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        auto suffix = name.substr(prefix.size());
+        if (std::all_of(suffix.begin(), suffix.end(), [](char symbol) { return symbol >= '0' && symbol <= '9'; }) && suffix.size() < 19) {
+            _next_segment_index = std::max(_next_segment_index, static_cast<size_t>(std::stoull(suffix)) + 1);
+        }
+    }
+
+    _prepare_requested = true;
+    _preparer = std::thread(&file_sink::preparer_loop, this);
+}
+
+file_sink::~file_sink() noexcept
+{
+    if (_preparer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _prepare_wakeup.notify_one();
+        _preparer.join();
+
+        std::error_code error;
+        std::filesystem::remove(spare_path(), error);
+        remove_old_segments(_next_segment_index);
+    }
+
+    if (_stream.is_open()) {
+        _stream.flush();
+        _stream.close();
+    }
+}
+
+void file_sink::open_segment()
+{
+    // the buffer has to be installed before the file is opened
+    if (_buffer != nullptr) {
+        _stream.rdbuf()->pubsetbuf(_buffer.get(), static_cast<std::streamsize>(_buffer_size));
+    }
+    // a file appended to has its magic already and counts towards the segment size
+    std::error_code error;
+    uintmax_t existing = (_mode & std::ios::app) == 0 ? 0 : std::filesystem::file_size(_path, error);
+    if (error) {
+        existing = 0;
+    }
+
+    _stream.open(_path, _mode);
+    _segment_size = existing;
+    if (_binary && existing == 0) {
+        _stream.write(binary_log::magic, sizeof(binary_log::magic));
+        _written_formats.assign(_written_formats.size(), false);
+        _segment_size = sizeof(binary_log::magic);
+    }
+    _segment_start = std::chrono::steady_clock::now();
+}
+
+void file_sink::write(char const *data, size_t size, logger::severity severity, bool defer_flush)
+{
+    if (_mapped != nullptr) {
+        _mapped->write(data, size);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    append_locked(data, size);
+    written_locked(size, severity, defer_flush);
+}
+
+void file_sink::write_structured(
+    logger::severity severity,
+    time_t seconds,
+    uint32_t nanoseconds,
+    structured::format_id format,
+    std::string_view arguments,
+    bool defer_flush)
+{
+    char header[binary_log::entry_header_size + binary_log::record_header_size];
+    size_t size = 0;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (format >= _written_formats.size()) {
+        _written_formats.resize(format + 1, false);
+    }
+    if (!_written_formats[format]) {
+        std::string_view text = structured::format_of(format);
+        header[0] = static_cast<char>(binary_log::entry_kind::format);
+        auto payload_size = static_cast<uint32_t>(sizeof(format) + text.size());
+        memcpy(header + 1, &payload_size, sizeof(payload_size));
+        memcpy(header + binary_log::entry_header_size, &format, sizeof(format));
+        append_locked(header, binary_log::entry_header_size + sizeof(format));
+        append_locked(text.data(), text.size());
+        size += binary_log::entry_header_size + payload_size;
+        _written_formats[format] = true;
+    }
+
+    char *position = header;
+    *position++ = static_cast<char>(binary_log::entry_kind::record);
+    auto payload_size = static_cast<uint32_t>(binary_log::record_header_size + arguments.size());
+    memcpy(position, &payload_size, sizeof(payload_size));
+    position += sizeof(payload_size);
+    *position++ = static_cast<char>(severity);
+    auto wide_seconds = static_cast<int64_t>(seconds);
+    memcpy(position, &wide_seconds, sizeof(wide_seconds));
+    position += sizeof(wide_seconds);
+    memcpy(position, &nanoseconds, sizeof(nanoseconds));
+    position += sizeof(nanoseconds);
+    memcpy(position, &format, sizeof(format));
+
+    append_locked(header, sizeof(header));
+    append_locked(arguments.data(), arguments.size());
+    size += sizeof(header) + arguments.size();
+
+    written_locked(size, severity, defer_flush);
+}
+
+void file_sink::append_locked(char const *data, size_t size)
+{
+    // binary records of a mapped stream still take the lock, their format entries have to
+    // come first in the file
+    if (_mapped != nullptr) {
+        _mapped->write(data, size);
+        return;
+    }
+    if (_compressed != nullptr) {
+        _compressed->write(data, size);
+        return;
+    }
+    if (_async_io != nullptr) {
+        _async_io->write(data, size);
+        return;
+    }
+    _stream.write(data, static_cast<std::streamsize>(size));
+}
+
+void file_sink::written_locked(size_t size, logger::severity severity, bool defer_flush)
+{
+    if (_mapped != nullptr) {
+        return;
+    }
+
+    // flushing by severity or size would cut blocks too short to compress, only errors do
+    if (_compressed != nullptr) {
+        _unflushed += size;
+        if (severity >= logger::severity::error) {
+            flush_locked();
+        }
+        return;
+    }
+
+    _unflushed += size;
+    _segment_size += size;
+
+    // with no spare segment yet the current one keeps growing rather than making the writer wait
+    if (_spare_ready
+        && ((_rotation.bytes != 0 && _segment_size >= _rotation.bytes)
+            || (_rotation.interval.count() != 0 && std::chrono::steady_clock::now() - _segment_start >= _rotation.interval))) {
+        rotate_locked();
+        return;
+    }
+
+    if (severity >= logger::severity::error) {
+        flush_locked(true);
+        return;
+    }
+
+    if (severity >= _policy.severity
+        || (_policy.bytes != 0 && _unflushed >= _policy.bytes)
+        || (_policy.interval.count() != 0 && std::chrono::steady_clock::now() - _last_flush >= _policy.interval)) {
+        _flush_requested = true;
+    }
+
+    if (_flush_requested && !defer_flush) {
+        flush_locked();
+    }
+}
+
+void file_sink::flush_if_requested()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_flush_requested) {
+        flush_locked();
+    }
+}
+
+void file_sink::flush_if_expired()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_unflushed != 0 && _policy.interval.count() != 0 && std::chrono::steady_clock::now() - _last_flush >= _policy.interval) {
+        flush_locked();
+    }
+}
+
+void file_sink::flush()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    flush_locked(true);
+}
+
+void file_sink::rotate_locked()
+{
+    // closing flushes the buffer; both renames are atomic, so readers always find a whole file at _path
+    _stream.close();
+    std::rename(_path.c_str(), segment_path(_next_segment_index).c_str());
+    std::rename(spare_path().c_str(), _path.c_str());
+    ++_next_segment_index;
+
+    // the spare is empty, appending keeps the reserved space instead of truncating it away
+    _mode |= std::ios::app;
+    open_segment();
+
+    _unflushed = 0;
+    _flush_requested = false;
+    _last_flush = std::chrono::steady_clock::now();
+
+    _spare_ready = false;
+    _prepare_requested = true;
+    _prepare_wakeup.notify_one();
+}
+
+void file_sink::preparer_loop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        _prepare_wakeup.wait(lock, [this]() { return _prepare_requested || _stopping; });
+        if (_stopping) {
+            return;
+        }
+        _prepare_requested = false;
+        size_t index = _next_segment_index;
+
+        lock.unlock();
+        remove_old_segments(index);
+        prepare_spare();
+        lock.lock();
+
+        _spare_ready = true;
+    }
+}
+
+void file_sink::prepare_spare() const
+{
+    #ifdef __linux__
+        int descriptor = open(spare_path().c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (descriptor == -1) {
+            return;
+        }
+        if (_rotation.preallocate && _rotation.bytes != 0) {
+            // the size stays 0, the blocks are just reserved for the appends to come
+            fallocate(descriptor, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(_rotation.bytes));
+        }
+        close(descriptor);
+    #else
+        std::ofstream spare(spare_path(), std::ios::trunc);
+    #endif
+}
+
+void file_sink::remove_old_segments(size_t index) const
+{
+    if (_rotation.kept_segments == 0 || index <= _rotation.kept_segments + 1) {
+        return;
+    }
+
+    // segments below index - kept_segments are gone, walking down until one is missing
+    std::error_code error;
+    for (size_t old = index - _rotation.kept_segments - 1; old != 0; --old) {
+        if (!std::filesystem::remove(segment_path(old), error)) {
+            break;
+        }
+    }
+}
+
+std::string file_sink::spare_path() const
+{
+    return _path + ".next";
+}
+
+std::string file_sink::segment_path(size_t index) const
+{
+    return _path + "." + std::to_string(index);
+}
+
+void file_sink::flush_locked(bool wait)
+{
+    if (_compressed != nullptr) {
+        _compressed->flush();
+    } else if (_async_io != nullptr) {
+        _async_io->submit();
+        if (wait) {
+            _async_io->wait();
+        }
+    } else {
+        _stream.flush();
+    }
+    _unflushed = 0;
+    _flush_requested = false;
+    _last_flush = std::chrono::steady_clock::now();
+}
+
+bool file_sink::is_open() const noexcept
+{
+    return _mapped != nullptr || _compressed != nullptr || _async_io != nullptr || _stream.is_open();
+}
+
+bool file_sink::is_binary() const noexcept
+{
+    return _binary;
+}
+
+bool file_sink::is_mapped() const noexcept
+{
+    return _mapped != nullptr;
+}
+
+bool file_sink::is_async_io() const noexcept
+{
+    return _async_io != nullptr;
+}
+bool file_sink::matches(stream_options const &options) const noexcept
+{
+    if (options.binary != _options.binary || options.kind != _options.kind
+        || kind_bytes_or_default(options.kind, options.kind_bytes) != _options.kind_bytes) {
+        return false;
+    }
+    return !_rotatable
+        || (!options.rotation.enabled() && !_options.rotation.enabled())
+        || options.rotation == _options.rotation;
+}
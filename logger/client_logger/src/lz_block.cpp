@@ -0,0 +1,190 @@
+#include "../include/lz_block.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+
+    constexpr size_t min_match = 4;
+
+    constexpr size_t max_offset = 65535;
+
+    constexpr size_t hash_bits = 14;
+
+    // the last bytes are always literals, so a match never needs to look past the end
+    constexpr size_t last_literals = 5;
+
+    uint32_t read32(char const *position) noexcept
+    {
+        uint32_t value;
+        memcpy(&value, position, sizeof(value));
+        return value;
+    }
+
+    uint32_t hash(uint32_t sequence) noexcept
+    {
+        return (sequence * 2654435761u) >> (32 - hash_bits);
+    }
+
+    void append_length(std::string &out, size_t length)
+    {
+        while (length >= 255) {
+            out.push_back(static_cast<char>(255));
+            length -= 255;
+        }
+        out.push_back(static_cast<char>(length));
+    }
+
+    void append_sequence(std::string &out, char const *literals, size_t literals_count, size_t offset, size_t match_length)
+    {
+        size_t match_code = match_length == 0 ? 0 : match_length - min_match;
+        out.push_back(static_cast<char>((std::min<size_t>(literals_count, 15) << 4) | std::min<size_t>(match_code, 15)));
+        if (literals_count >= 15) {
+            append_length(out, literals_count - 15);
+        }
+        out.append(literals, literals_count);
+        if (match_length == 0) {
+            return;
+        }
+        out.push_back(static_cast<char>(offset & 0xff));
+        out.push_back(static_cast<char>(offset >> 8));
+        if (match_code >= 15) {
+            append_length(out, match_code - 15);
+        }
+    }
+
+    // positions of the last sequences seen by their hash, relative to the block start plus one
+    thread_local std::array<uint32_t, size_t{ 1 } << hash_bits> positions;
+
+}
+
+void lz_block::compress(std::string_view input, std::string &out)
+{
+    char const *begin = input.data();
+    char const *end = begin + input.size();
+    char const *anchor = begin;
+
+    out.reserve(out.size() + compress_bound(input.size()));
+
+    if (input.size() > min_match + last_literals) {
+        positions.fill(0);
+        char const *match_limit = end - last_literals;
+        char const *position = begin;
+
+        while (position + min_match <= match_limit) {
+            uint32_t sequence = read32(position);
+            uint32_t &slot = positions[hash(sequence)];
+            char const *candidate = slot == 0 ? nullptr : begin + slot - 1;
+            slot = static_cast<uint32_t>(position - begin + 1);
+
+            if (candidate == nullptr || static_cast<size_t>(position - candidate) > max_offset || read32(candidate) != sequence) {
+                ++position;
+                continue;
+            }
+
+            // the match is extended both ways, backwards over literals not yet written
+            char const *match_end = position + min_match;
+            char const *candidate_end = candidate + min_match;
+            while (match_end < match_limit && *match_end == *candidate_end) {
+                ++match_end;
+                ++candidate_end;
+            }
+            while (position > anchor && candidate > begin && position[-1] == candidate[-1]) {
+                --position;
+                --candidate;
+            }
+
+            append_sequence(out, anchor, static_cast<size_t>(position - anchor), static_cast<size_t>(position - candidate),
+                static_cast<size_t>(match_end - position));
+            position = match_end;
+            anchor = position;
+
+            // the position just before the end of the match is indexed too, long runs of
+            // repeated records then chain from match to match
+            if (position - 2 > begin && position + min_match <= match_limit) {
+                positions[hash(read32(position - 2))] = static_cast<uint32_t>(position - 2 - begin + 1);
+            }
+        }
+    }
+
+    append_sequence(out, anchor, static_cast<size_t>(end - anchor), 0, 0);
+}
+
+void lz_block::decompress(std::string_view input, size_t raw_size, std::string &out)
+{
+    std::runtime_error damaged_block("Damaged compressed block\n");
+
+    size_t start = out.size();
+    out.resize(start + raw_size);
+    char *destination = out.data() + start;
+    char *destination_end = destination + raw_size;
+    char const *position = input.data();
+    char const *end = position + input.size();
+
+    auto read_length = [&](size_t length) {
+        if (length != 15) {
+            return length;
+        }
+        while (true) {
+            if (position == end) {
+                throw damaged_block;
+            }
+            auto part = static_cast<uint8_t>(*position++);
+            length += part;
+            if (part != 255) {
+                return length;
+            }
+        }
+    };
+
+    while (true) {
+        if (position == end) {
+            throw damaged_block;
+        }
+        auto token = static_cast<uint8_t>(*position++);
+
+        size_t literals_count = read_length(token >> 4);
+        if (literals_count > static_cast<size_t>(end - position) || literals_count > static_cast<size_t>(destination_end - destination)) {
+            throw damaged_block;
+        }
+        memcpy(destination, position, literals_count);
+        destination += literals_count;
+        position += literals_count;
+
+        // the last sequence ends the input
+        if (position == end) {
+            break;
+        }
+
+        if (end - position < 2) {
+            throw damaged_block;
+        }
+        size_t offset = static_cast<uint8_t>(position[0]) | static_cast<size_t>(static_cast<uint8_t>(position[1])) << 8;
+        position += 2;
+        size_t match_length = read_length(token & 0x0f) + min_match;
+        if (offset == 0 || offset > static_cast<size_t>(destination - (out.data() + start))
+            || match_length > static_cast<size_t>(destination_end - destination)) {
+            throw damaged_block;
+        }
+
+        // an offset shorter than the match repeats the bytes being written, so they are
+        // copied one by one
+        char const *source = destination - offset;
+        if (offset >= match_length) {
+            memcpy(destination, source, match_length);
+            destination += match_length;
+        } else {
+            for (size_t i = 0; i < match_length; ++i) {
+                *destination++ = source[i];
+            }
+        }
+    }
+
+    if (destination != destination_end) {
+        throw damaged_block;
+    }
+}
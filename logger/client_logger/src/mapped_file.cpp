@@ -0,0 +1,187 @@
+#include "../include/mapped_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef __linux__
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+namespace
+{
+
+    constexpr uint64_t no_window = UINT64_MAX;
+
+}
+
+mapped_file::mapped_file(std::string const &file_path, size_t window_bytes) :
+    _descriptor(-1), _page_bytes(0), _window_bytes(0), _reserved(0), _next_window(0), _failed(false), _lost_bytes(0), _stopping(false)
+{
+    #ifdef __linux__
+        _page_bytes = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        _window_bytes = std::max(_page_bytes, (window_bytes + _page_bytes - 1) / _page_bytes * _page_bytes);
+
+        for (auto &slot : _slots) {
+            slot.index.store(no_window, std::memory_order_relaxed);
+            slot.bytes.store(nullptr, std::memory_order_relaxed);
+            slot.written.store(0, std::memory_order_relaxed);
+        }
+
+        _descriptor = open(file_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (_descriptor == -1) {
+            throw std::runtime_error("Failed to open stream\n");
+        }
+
+        // the first windows are there before the first write
+        for (size_t i = 0; i < slots_count; ++i) {
+            if (!map_next()) {
+                for (auto &slot : _slots) {
+                    if (slot.index.load(std::memory_order_relaxed) != no_window) {
+                        munmap(slot.bytes.load(std::memory_order_relaxed), _window_bytes);
+                    }
+                }
+                close(_descriptor);
+                throw std::runtime_error("Failed to map stream\n");
+            }
+        }
+        _mapper = std::thread(&mapped_file::mapper_loop, this);
+    #else
+        throw std::runtime_error("Mapped streams are not supported\n");
+    #endif
+}
+
+mapped_file::~mapped_file() noexcept
+{
+    #ifdef __linux__
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _wakeup.notify_one();
+        _mapper.join();
+
+        for (auto &slot : _slots) {
+            if (slot.index.load(std::memory_order_relaxed) != no_window) {
+                munmap(slot.bytes.load(std::memory_order_relaxed), _window_bytes);
+            }
+        }
+
+        // the file grew by whole windows, the tail of the last one was never written
+        [[maybe_unused]] int truncated = ftruncate(_descriptor, static_cast<off_t>(_reserved.load(std::memory_order_relaxed)));
+        close(_descriptor);
+    #endif
+}
+
+bool mapped_file::map_next()
+{
+    #ifdef __linux__
+        auto &slot = _slots[_next_window % slots_count];
+        if (slot.index.load(std::memory_order_relaxed) != no_window) {
+            if (slot.written.load(std::memory_order_acquire) != _window_bytes) {
+                return false;
+            }
+            munmap(slot.bytes.load(std::memory_order_relaxed), _window_bytes);
+            slot.index.store(no_window, std::memory_order_relaxed);
+        }
+
+        // blocks are allocated up front, a store into a hole the disk has no room for would
+        // end in SIGBUS instead of an error
+        auto offset = static_cast<off_t>(_next_window * _window_bytes);
+        if (posix_fallocate(_descriptor, offset, static_cast<off_t>(_window_bytes)) != 0) {
+            _failed.store(true, std::memory_order_release);
+            return false;
+        }
+
+        void *bytes = mmap(nullptr, _window_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _descriptor, offset);
+        if (bytes == MAP_FAILED) {
+            _failed.store(true, std::memory_order_release);
+            return false;
+        }
+
+        // populated pages are still write protected until the first store dirties them, a store
+        // here takes that fault instead of a writer
+        for (size_t page = 0; page < _window_bytes; page += _page_bytes) {
+            static_cast<char volatile *>(bytes)[page] = 0;
+        }
+
+        slot.written.store(0, std::memory_order_relaxed);
+        slot.bytes.store(static_cast<char *>(bytes), std::memory_order_relaxed);
+        slot.index.store(_next_window, std::memory_order_release);
+        ++_next_window;
+        return true;
+    #else
+        return false;
+    #endif
+}
+
+void mapped_file::mapper_loop()
+{
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wakeup.wait(lock, [this]() {
+                auto &slot = _slots[_next_window % slots_count];
+                return _stopping || (!_failed.load(std::memory_order_relaxed)
+                    && slot.written.load(std::memory_order_relaxed) == _window_bytes);
+            });
+            if (_stopping) {
+                return;
+            }
+        }
+        while (map_next()) {
+        }
+    }
+}
+
+void mapped_file::copy_into_window(uint64_t window, size_t offset, char const *data, size_t size) noexcept
+{
+    auto &slot = _slots[window % slots_count];
+
+    // the writers got a whole set of windows ahead of the mapper
+    while (slot.index.load(std::memory_order_acquire) != window) {
+        if (_failed.load(std::memory_order_acquire)) {
+            _lost_bytes.fetch_add(size, std::memory_order_relaxed);
+            return;
+        }
+        std::this_thread::yield();
+    }
+
+    memcpy(slot.bytes.load(std::memory_order_relaxed) + offset, data, size);
+
+    // the last writer of a window hands its slot to the mapper
+    if (slot.written.fetch_add(size, std::memory_order_acq_rel) + size == _window_bytes) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+        }
+        _wakeup.notify_one();
+    }
+}
+
+void mapped_file::write(char const *data, size_t size) noexcept
+{
+    uint64_t position = _reserved.fetch_add(size, std::memory_order_relaxed);
+
+    // a write crossing a window boundary is copied piece by piece
+    while (size != 0) {
+        uint64_t window = position / _window_bytes;
+        size_t offset = static_cast<size_t>(position % _window_bytes);
+        size_t piece = std::min(size, _window_bytes - offset);
+        copy_into_window(window, offset, data, piece);
+        position += piece;
+        data += piece;
+        size -= piece;
+    }
+}
+
+size_t mapped_file::size() const noexcept
+{
+    return _reserved.load(std::memory_order_relaxed);
+}
+
+size_t mapped_file::lost_bytes() const noexcept
+{
+    return _lost_bytes.load(std::memory_order_relaxed);
+}
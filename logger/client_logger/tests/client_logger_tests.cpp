@@ -1,8 +1,27 @@
 #include <gtest/gtest.h>
+#include <async_io.h>
+#include <binary_log.h>
 #include <client_logger.h>
 #include <client_logger_builder.h>
+#include <compressed_log.h>
+#include <lz_block.h>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <thread>
+#include <vector>
 
+size_t count_lines(std::string const &file_name)
+{
+    std::ifstream file(file_name);
+    std::string line;
+    size_t count = 0;
+    while (std::getline(file, line)) {
+        count++;
+    }
+    return count;
+}
 
 TEST(ClientLoggerTest, LogToFileAndConsole) {
     logger_builder* builder = new client_logger_builder();
@@ -38,6 +57,890 @@ TEST(ClientLoggerTest, LogToFileAndConsole) {
     std::cout << "Check console output for logged messages\n";
 }
 
+TEST(ClientLoggerTest, AsyncBlockKeepsEveryRecord) {
+    client_logger_builder builder;
+    builder.set_async(8, overflow_policy::block);
+    builder.add_file_stream("async_block.txt", logger::severity::information);
+    logger *logger_tmp = builder.build();
+
+    std::vector<std::thread> producers;
+    for (int i = 0; i < 4; ++i) {
+        producers.emplace_back([logger_tmp]() {
+            for (int j = 0; j < 1000; ++j) {
+                logger_tmp->information("async message");
+            }
+        });
+    }
+    for (auto &producer : producers) {
+        producer.join();
+    }
+
+    ASSERT_EQ(dynamic_cast<client_logger *>(logger_tmp)->dropped_records(), 0);
+    delete logger_tmp;
+
+    // every record is "[%s] %m\n" plus the line terminator
+    ASSERT_EQ(count_lines("async_block.txt"), 2 * 4 * 1000);
+}
+
+TEST(ClientLoggerTest, AsyncDropCountsLostRecords) {
+    client_logger_builder builder;
+    builder.set_async(2, overflow_policy::drop);
+    builder.add_file_stream("async_drop.txt", logger::severity::information);
+    logger *logger_tmp = builder.build();
+
+    std::vector<std::thread> producers;
+    for (int i = 0; i < 4; ++i) {
+        producers.emplace_back([logger_tmp]() {
+            for (int j = 0; j < 1000; ++j) {
+                logger_tmp->information("async message");
+            }
+        });
+    }
+    for (auto &producer : producers) {
+        producer.join();
+    }
+
+    size_t dropped = dynamic_cast<client_logger *>(logger_tmp)->dropped_records();
+    delete logger_tmp;
+
+    ASSERT_EQ(count_lines("async_drop.txt") / 2 + dropped, 4 * 1000);
+}
+TEST(ClientLoggerTest, CompiledFormatFields) {
+    std::string format = "%d %t [%s] %m %x%";
+    client_logger_builder builder;
+    builder.set_format(format);
+    builder.add_file_stream("format.txt", logger::severity::warning);
+    logger *logger_tmp = builder.build();
+
+    logger_tmp->warning("text with %s inside");
+    delete logger_tmp;
+
+    std::ifstream file("format.txt");
+    std::string line;
+    std::getline(file, line);
+
+    // "YYYY-MM-DD HH:MM:SS [WARNING] text with %s inside %x%"
+    ASSERT_EQ(line.size(), 10 + 1 + 8 + 1 + std::string("[WARNING] text with %s inside %x%").size());
+    ASSERT_EQ(line[4], '-');
+    ASSERT_EQ(line[13], ':');
+    ASSERT_EQ(line.substr(20), "[WARNING] text with %s inside %x%");
+}
+TEST(ClientLoggerTest, MillisecondsAndCachedCalendar) {
+    std::string format = "%t%f|%m";
+    client_logger_builder builder;
+    builder.set_format(format);
+    builder.add_file_stream("milliseconds.txt", logger::severity::information);
+    logger *logger_tmp = builder.build();
+    logger_tmp->information("text");
+    delete logger_tmp;
+
+    std::ifstream file("milliseconds.txt");
+    std::string line;
+    std::getline(file, line);
+
+    // "HH:MM:SS.mmm|text"
+    ASSERT_EQ(line.size(), 8 + 4 + 5);
+    ASSERT_EQ(line[8], '.');
+    ASSERT_EQ(line.substr(12), "|text");
+
+    char fraction[log_clock::max_fraction_digits + 1];
+    ASSERT_EQ(std::string(fraction, log_clock::format_fraction(fraction, 12345678, 3)), ".012");
+    ASSERT_EQ(std::string(fraction, log_clock::format_fraction(fraction, 12345678, 9)), ".012345678");
+
+    // every thread keeps its own cached second
+    std::vector<std::thread> threads;
+    std::vector<std::string> texts(4);
+    for (size_t t = 0; t < texts.size(); ++t) {
+        threads.emplace_back([&texts, t]() {
+            for (time_t second = 0; second < 1000; ++second) {
+                log_clock::calendar_of(second + 86400 * t);
+            }
+            texts[t] = log_clock::calendar_of(86400 * 365).datetime;
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (auto &text : texts) {
+        ASSERT_EQ(text, log_clock::calendar_of(86400 * 365).datetime);
+    }
+}
+
+TEST(ClientLoggerTest, VariadicLogFormatsEnabledSeverities) {
+    std::string format = "%m";
+    client_logger_builder builder;
+    builder.set_format(format);
+    builder.add_file_stream("variadic.txt", logger::severity::information);
+    logger *logger_tmp = builder.build();
+
+    ASSERT_TRUE(logger_tmp->is_enabled(logger::severity::information));
+    ASSERT_FALSE(logger_tmp->is_enabled(logger::severity::debug));
+
+    std::string const name = "pool";
+    logger_tmp->log(logger::severity::information, "{} of {} bytes, {{{}}} {} {} {}", name, size_t(4096), -1, true, 'x', 0.25);
+    logger_tmp->log(logger::severity::information, "{} and {}", 1);
+    logger_tmp->log(logger::severity::debug, "nobody listens {}", 1);
+    delete logger_tmp;
+
+    std::ifstream file("variadic.txt");
+    std::string line;
+    std::getline(file, line);
+    ASSERT_EQ(line, "pool of 4096 bytes, {-1} true x 0.25");
+    std::getline(file, line);
+    ASSERT_EQ(line, "1 and {}");
+    ASSERT_FALSE(std::getline(file, line));
+}
+
+TEST(ClientLoggerTest, RateLimitsAndSamplingSummarizeSuppressed) {
+    std::filesystem::remove("limited.txt");
+    {
+        std::ofstream configuration("limited.json");
+        configuration << R"({"limited": {"streams": [["limited.txt", ["trace", "debug", "information"]]],
+            "rate_limits": {"trace": {"sample_every": 10}, "debug": {"rate": 1, "burst": 5}},
+            "summary_interval_ms": 3600000}})";
+    }
+
+    std::string format = "[%s] %m";
+    client_logger_builder builder;
+    builder.transform_with_configuration("limited.json", "limited");
+    builder.set_format(format);
+    logger *logger_tmp = builder.build();
+    for (int i = 0; i < 100; ++i) {
+        logger_tmp->log(logger::severity::trace, "trace {}", i);
+        logger_tmp->debug("debug " + std::to_string(i));
+        logger_tmp->information("information " + std::to_string(i));
+    }
+    delete logger_tmp;
+
+    std::vector<std::string> trace, debug;
+    size_t information = 0;
+    std::ifstream file("limited.txt");
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.starts_with("[TRACE] ")) {
+            trace.push_back(line.substr(8));
+        } else if (line.starts_with("[DEBUG] ")) {
+            debug.push_back(line.substr(8));
+        } else {
+            ++information;
+        }
+    }
+
+    ASSERT_EQ(information, 100);
+    ASSERT_EQ(trace.size(), 11);
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(trace[i], "trace " + std::to_string(i * 10));
+    }
+    ASSERT_EQ(trace.back(), "90 records suppressed");
+    ASSERT_EQ(debug.size(), 6);
+    ASSERT_EQ(debug.back(), "95 records suppressed");
+}
+
+TEST(ClientLoggerTest, CallSiteLimitReportsSuppressedCount) {
+    std::filesystem::remove("call_site.txt");
+
+    std::string format = "%m";
+    client_logger_builder builder;
+    builder.set_format(format);
+    builder.add_file_stream("call_site.txt", logger::severity::information);
+    logger *logger_tmp = builder.build();
+    for (int i = 0; i < 10; ++i) {
+        static call_site_limit site(rate_limit{ 0, 0, 4 });
+        logger_tmp->log(site, logger::severity::information, "tick {}", i);
+    }
+    delete logger_tmp;
+
+    std::ifstream file("call_site.txt");
+    std::string line;
+    std::getline(file, line);
+    ASSERT_EQ(line, "tick 0");
+    std::getline(file, line);
+    ASSERT_EQ(line, "tick 4 (3 suppressed at this call site)");
+    std::getline(file, line);
+    ASSERT_EQ(line, "tick 8 (3 suppressed at this call site)");
+    ASSERT_FALSE(std::getline(file, line));
+}
+
+TEST(ClientLoggerTest, BufferedSinkFlushPolicy) {
+    flush_policy policy;
+    policy.severity = logger::severity::critical;
+
+    client_logger_builder builder;
+    builder.set_flush_policy(policy);
+    builder.add_file_stream("buffered.txt", logger::severity::information);
+    builder.add_file_stream("buffered.txt", logger::severity::error);
+    logger *logger_tmp = builder.build();
+
+    logger_tmp->information("stays in the buffer");
+    ASSERT_EQ(std::filesystem::file_size("buffered.txt"), 0);
+
+    // error records are never held back
+    logger_tmp->error("flushed immediately");
+    ASSERT_EQ(count_lines("buffered.txt"), 4);
+
+    logger_tmp->information("flushed explicitly");
+    ASSERT_EQ(count_lines("buffered.txt"), 4);
+    dynamic_cast<client_logger *>(logger_tmp)->flush();
+    ASSERT_EQ(count_lines("buffered.txt"), 6);
+
+    delete logger_tmp;
+}
+
+TEST(ClientLoggerTest, AsyncExplicitFlush) {
+    flush_policy policy;
+    policy.severity = logger::severity::critical;
+
+    client_logger_builder builder;
+    builder.set_async(64);
+    builder.set_flush_policy(policy);
+    builder.add_file_stream("async_flush.txt", logger::severity::information);
+    logger *logger_tmp = builder.build();
+
+    for (int i = 0; i < 100; ++i) {
+        logger_tmp->information("buffered");
+    }
+    dynamic_cast<client_logger *>(logger_tmp)->flush();
+    ASSERT_EQ(count_lines("async_flush.txt"), 200);
+
+    delete logger_tmp;
+}
+TEST(ClientLoggerTest, AsyncFlushReturnsUnderContinuousLogging) {
+    // every record is flushed on its own, so the writer falls behind the producers
+    flush_policy policy;
+    policy.severity = logger::severity::information;
+
+    client_logger_builder builder;
+    builder.set_async(64);
+    builder.set_flush_policy(policy);
+    builder.add_file_stream("async_flush_busy.txt", logger::severity::information);
+    logger *logger_tmp = builder.build();
+
+    for (int i = 0; i < 100; ++i) {
+        logger_tmp->information("before flush");
+    }
+
+    // the queue never drains while these threads run, the flush waits only for the records above
+    std::atomic<bool> stop(false);
+    std::atomic<size_t> logged(0);
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; ++t) {
+        producers.emplace_back([&]() {
+            while (!stop.load()) {
+                logger_tmp->information("during flush");
+                logged.fetch_add(1);
+            }
+        });
+    }
+    while (logged.load() < 1000) {
+        std::this_thread::yield();
+    }
+    dynamic_cast<client_logger *>(logger_tmp)->flush();
+
+    auto count_before_flush = [](std::string const &file_name) {
+        std::ifstream file(file_name);
+        std::string line;
+        size_t count = 0;
+        while (std::getline(file, line)) {
+            count += line.find("before flush") != std::string::npos;
+        }
+        return count;
+    };
+    size_t flushed = count_before_flush("async_flush_busy.txt");
+
+    stop = true;
+    for (auto &producer : producers) {
+        producer.join();
+    }
+    delete logger_tmp;
+
+    ASSERT_NE(flushed, 0);
+    ASSERT_EQ(flushed, count_before_flush("async_flush_busy.txt"));
+}
+
+TEST(ClientLoggerTest, SeverityRoutesSurviveCopyAndMove) {
+    client_logger_builder builder;
+    builder.add_file_stream("routes_info.txt", logger::severity::information);
+    builder.add_file_stream("routes_error.txt", logger::severity::error);
+    logger *logger_tmp = builder.build();
+
+    client_logger copied(*dynamic_cast<client_logger *>(logger_tmp));
+    client_logger moved(std::move(*dynamic_cast<client_logger *>(logger_tmp)));
+    delete logger_tmp;
+
+    copied.trace("nobody listens");
+    copied.information("to info");
+    moved.error("to error");
+    moved.debug("nobody listens");
+    moved.flush();
+    copied.flush();
+
+    ASSERT_EQ(count_lines("routes_info.txt"), 2);
+    ASSERT_EQ(count_lines("routes_error.txt"), 2);
+}
+
+TEST(ClientLoggerTest, ConcurrentLoggersShareSink) {
+    client_logger_builder builder;
+    builder.add_file_stream("concurrent.txt", logger::severity::information);
+    logger *keeper = builder.build();
+
+    constexpr int threads_count = 8;
+    constexpr int records_count = 500;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threads_count; ++t) {
+        threads.emplace_back([t]() {
+            client_logger_builder local_builder;
+            local_builder.add_file_stream("concurrent.txt", logger::severity::information);
+            for (int i = 0; i < records_count; ++i) {
+                logger *built = local_builder.build();
+                client_logger copied(*dynamic_cast<client_logger *>(built));
+                delete built;
+                copied.information("thread " + std::to_string(t));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    delete keeper;
+    ASSERT_EQ(count_lines("concurrent.txt"), 2 * threads_count * records_count);
+}
+
+TEST(ClientLoggerTest, BinaryStreamRoundTrip) {
+    auto format = structured::register_format("block {} of {} bytes at {}, ok={}, ratio={}");
+    ASSERT_EQ(structured::register_format("block {} of {} bytes at {}, ok={}, ratio={}"), format);
+
+    for (size_t async_capacity : {0, 64}) {
+        std::filesystem::remove("binary.log");
+        client_logger_builder builder;
+        builder.add_binary_file_stream("binary.log", logger::severity::information);
+        builder.set_async(async_capacity);
+        logger *logger_tmp = builder.build();
+        auto *structured_logger = dynamic_cast<client_logger *>(logger_tmp);
+
+        structured_logger->log_structured(logger::severity::information, format, 7, size_t(4096), std::string("heap"), true, 0.5);
+        structured_logger->log_structured(logger::severity::debug, format, 1, 2, "nobody listens", false, 1.0);
+        logger_tmp->information("plain {} text");
+        delete logger_tmp;
+
+        binary_log::reader reader("binary.log");
+        binary_log::decoded_record record;
+        ASSERT_TRUE(reader.next(record));
+        ASSERT_EQ(record.severity, logger::severity::information);
+        ASSERT_EQ(record.message, "block 7 of 4096 bytes at heap, ok=true, ratio=0.5");
+        ASSERT_NE(record.seconds, 0);
+        ASSERT_TRUE(reader.next(record));
+        ASSERT_EQ(record.message, "plain {} text");
+        ASSERT_FALSE(reader.next(record));
+    }
+
+    client_logger_builder mixed;
+    mixed.add_file_stream("binary.log", logger::severity::information);
+    client_logger_builder binary;
+    binary.add_binary_file_stream("binary.log", logger::severity::information);
+    logger *text_logger = mixed.build();
+    ASSERT_THROW(delete binary.build(), std::runtime_error);
+    delete text_logger;
+}
+
+TEST(ClientLoggerTest, BinaryReaderRejectsUnknownSeverity) {
+    {
+        std::ofstream file("binary_damaged.log", std::ios::binary | std::ios::trunc);
+        file.write(binary_log::magic, sizeof(binary_log::magic));
+
+        auto write_entry = [&file](binary_log::entry_kind kind, std::string const &payload) {
+            char header[binary_log::entry_header_size];
+            header[0] = static_cast<char>(kind);
+            uint32_t size = static_cast<uint32_t>(payload.size());
+            memcpy(header + 1, &size, sizeof(size));
+            file.write(header, sizeof(header));
+            file.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+        };
+
+        structured::format_id id = 0;
+        std::string format(reinterpret_cast<char const *>(&id), sizeof(id));
+        write_entry(binary_log::entry_kind::format, format + "text");
+
+        // a severity byte past critical, as a damaged or foreign file may hold
+        std::string record(binary_log::record_header_size, '\0');
+        record[0] = static_cast<char>(200);
+        memcpy(record.data() + binary_log::record_header_size - sizeof(id), &id, sizeof(id));
+        write_entry(binary_log::entry_kind::record, record);
+    }
+
+    binary_log::reader reader("binary_damaged.log");
+    binary_log::decoded_record record;
+    ASSERT_THROW(reader.next(record), std::runtime_error);
+}
+
+TEST(ClientLoggerTest, TextStreamFormatsStructuredRecords) {
+    auto format = structured::register_format("{{id}} = {}, {} left in {}");
+
+    client_logger_builder builder;
+    std::string line_format = "[%s] %m";
+    builder.add_file_stream("structured.txt", logger::severity::information);
+    builder.set_format(line_format);
+    logger *logger_tmp = builder.build();
+    dynamic_cast<client_logger *>(logger_tmp)->log_structured(logger::severity::information, format, -3, 2u, 'x');
+    delete logger_tmp;
+
+    std::ifstream file("structured.txt");
+    std::string line;
+    std::getline(file, line);
+    ASSERT_EQ(line, "[INFORMATION] {id} = -3, 2 left in x");
+}
+
+TEST(ClientLoggerTest, SharedStreamRejectsOtherOptions) {
+    std::filesystem::remove("shared.txt");
+    client_logger_builder mapped;
+    mapped.set_map_window(4096);
+    mapped.add_mapped_file_stream("shared.txt", logger::severity::information);
+    logger *mapped_logger = mapped.build();
+
+    client_logger_builder same;
+    same.set_map_window(4096);
+    same.add_mapped_file_stream("shared.txt", logger::severity::error);
+    delete same.build();
+
+    client_logger_builder plain;
+    plain.add_file_stream("shared.txt", logger::severity::information);
+    ASSERT_THROW(delete plain.build(), std::runtime_error);
+    client_logger_builder other_window;
+    other_window.set_map_window(8192);
+    other_window.add_mapped_file_stream("shared.txt", logger::severity::information);
+    ASSERT_THROW(delete other_window.build(), std::runtime_error);
+    delete mapped_logger;
+
+    std::filesystem::remove("shared.txt");
+    rotation_policy rotation;
+    rotation.bytes = 1 << 20;
+    client_logger_builder rotated;
+    rotated.set_rotation(rotation);
+    rotated.add_file_stream("shared.txt", logger::severity::information);
+    logger *rotated_logger = rotated.build();
+    ASSERT_THROW(delete plain.build(), std::runtime_error);
+    delete rotated_logger;
+    std::filesystem::remove("shared.txt");
+    std::filesystem::remove("shared.txt.next");
+}
+
+TEST(ClientLoggerTest, MappedStreamKeepsEveryLineAcrossWindows) {
+    std::string format = "%m";
+    client_logger_builder builder;
+    builder.set_format(format);
+    builder.set_map_window(4096);
+    builder.add_mapped_file_stream("mapped.txt", logger::severity::information);
+    logger *logger_tmp = builder.build();
+
+    constexpr int threads_count = 8;
+    constexpr int records_count = 2000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threads_count; ++t) {
+        threads.emplace_back([logger_tmp, t]() {
+            for (int i = 0; i < records_count; ++i) {
+                logger_tmp->information("thread " + std::to_string(t) + " record " + std::to_string(i));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    delete logger_tmp;
+
+    // cut to what was written, no zeros of the last window are left
+    std::ifstream file("mapped.txt");
+    std::string line;
+    std::vector<int> next_record(threads_count, 0);
+    size_t bytes = 0;
+    while (std::getline(file, line)) {
+        int t;
+        int i;
+        ASSERT_EQ(std::sscanf(line.c_str(), "thread %d record %d", &t, &i), 2) << line;
+        ASSERT_EQ(i, next_record[t]++);
+        bytes += line.size() + 1;
+    }
+    for (int t = 0; t < threads_count; ++t) {
+        ASSERT_EQ(next_record[t], records_count);
+    }
+    ASSERT_EQ(std::filesystem::file_size("mapped.txt"), bytes);
+}
+
+TEST(ClientLoggerTest, MappedStreamFromConfiguration) {
+    {
+        std::ofstream configuration("mapped.json");
+        configuration << R"({"logger": {"streams": [["mapped_binary.log", ["information"], {"mapped": true}]],)"
+                      << R"( "map_window_bytes": 8192}})";
+    }
+
+    client_logger_builder builder;
+    builder.transform_with_configuration("mapped.json", "logger");
+    builder.add_binary_file_stream("mapped_binary.log", logger::severity::information);
+    logger *logger_tmp = builder.build();
+    for (int i = 0; i < 1000; ++i) {
+        logger_tmp->information("record " + std::to_string(i));
+    }
+    delete logger_tmp;
+
+    binary_log::reader reader("mapped_binary.log");
+    binary_log::decoded_record record;
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(reader.next(record));
+        ASSERT_EQ(record.message, "record " + std::to_string(i));
+    }
+    ASSERT_FALSE(reader.next(record));
+}
+
+TEST(ClientLoggerTest, LzBlockRoundTrip) {
+    std::string repeated;
+    for (int i = 0; i < 2000; ++i) {
+        repeated += "allocator_sorted_list [START] allocation\n";
+    }
+    std::string mixed;
+    uint32_t state = 12345;
+    for (int i = 0; i < 100000; ++i) {
+        state = state * 1103515245 + 12345;
+        mixed.push_back(static_cast<char>(i % 7 == 0 ? state >> 24 : 'a' + (state >> 28)));
+    }
+
+    for (std::string const &input : { std::string(), std::string("abc"), std::string(100, 'x'), repeated, mixed }) {
+        std::string compressed;
+        lz_block::compress(input, compressed);
+        ASSERT_LE(compressed.size(), lz_block::compress_bound(input.size()));
+
+        std::string decompressed;
+        lz_block::decompress(compressed, input.size(), decompressed);
+        ASSERT_EQ(decompressed, input);
+    }
+
+    std::string compressed;
+    lz_block::compress(repeated, compressed);
+    ASSERT_LT(compressed.size() * 50, repeated.size());
+    std::string decompressed;
+    ASSERT_THROW(lz_block::decompress(compressed, repeated.size() + 1, decompressed), std::runtime_error);
+    ASSERT_THROW(lz_block::decompress(std::string_view(compressed).substr(0, compressed.size() / 2), repeated.size(), decompressed), std::runtime_error);
+}
+
+TEST(ClientLoggerTest, CompressedStreamSeeksByBlock) {
+    std::string format = "%m";
+    client_logger_builder builder;
+    builder.set_format(format);
+    builder.set_compression_block(4096);
+    builder.add_compressed_file_stream("compressed.lz", logger::severity::trace);
+    logger *logger_tmp = builder.build();
+
+    std::string expected;
+    for (int i = 0; i < 5000; ++i) {
+        std::string line = "allocator_sorted_list [START] allocation " + std::to_string(i);
+        logger_tmp->trace(line);
+        expected += line + "\n";
+    }
+    dynamic_cast<client_logger *>(logger_tmp)->flush();
+
+    compressed_log::reader flushed("compressed.lz");
+    ASSERT_FALSE(flushed.blocks().empty());
+    ASSERT_EQ(flushed.blocks().back().raw_offset + flushed.blocks().back().raw_size, expected.size());
+    delete logger_tmp;
+
+    compressed_log::reader reader("compressed.lz");
+    auto const &blocks = reader.blocks();
+    ASSERT_GT(blocks.size(), 10);
+    std::string raw;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        ASSERT_EQ(blocks[i].raw_offset, raw.size());
+        reader.read_block(i, raw);
+    }
+    ASSERT_EQ(raw, expected);
+    ASSERT_LT(std::filesystem::file_size("compressed.lz") * 4, expected.size());
+
+    // a block found by a raw offset holds the bytes there
+    uint64_t offset = expected.size() / 2;
+    size_t index = reader.find_block(offset);
+    ASSERT_LT(index, blocks.size());
+    std::string block;
+    reader.read_block(index, block);
+    ASSERT_EQ(block[offset - blocks[index].raw_offset], expected[offset]);
+    ASSERT_EQ(reader.find_block(expected.size()), blocks.size());
+
+    // a damaged block doesn't decompress
+    {
+        std::fstream file("compressed.lz", std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(static_cast<std::streamoff>(blocks[index].file_offset + blocks[index].stored_size / 2));
+        file.put('\x7f');
+    }
+    compressed_log::reader damaged("compressed.lz");
+    block.clear();
+    ASSERT_THROW(damaged.read_block(index, block), std::runtime_error);
+}
+
+TEST(ClientLoggerTest, AsyncIoFilesKeepEveryBufferOnBothBackends) {
+    for (auto kind : {async_io_writer::backend::automatic, async_io_writer::backend::thread_pool}) {
+        async_io_writer writer(kind);
+        if (kind == async_io_writer::backend::thread_pool) {
+            ASSERT_EQ(writer.kind(), async_io_writer::backend::thread_pool);
+        }
+
+        // small buffers keep every file several writes in flight
+        std::vector<std::unique_ptr<async_io_file>> files;
+        std::vector<std::string> expected(8);
+        for (size_t i = 0; i < expected.size(); ++i) {
+            files.push_back(std::make_unique<async_io_file>("async_io_" + std::to_string(i) + ".txt", 512, 3, false, writer));
+        }
+        for (int line = 0; line < 2000; ++line) {
+            for (size_t i = 0; i < files.size(); ++i) {
+                std::string text = "file " + std::to_string(i) + " line " + std::to_string(line) + "\n";
+                files[i]->write(text.data(), text.size());
+                expected[i] += text;
+                if (line % 97 == 0) {
+                    files[i]->submit();
+                }
+            }
+        }
+        for (auto &file : files) {
+            file->submit();
+            file->wait();
+            ASSERT_EQ(file->error(), 0);
+        }
+
+        for (size_t i = 0; i < files.size(); ++i) {
+            std::ifstream written("async_io_" + std::to_string(i) + ".txt", std::ios::binary);
+            std::string content((std::istreambuf_iterator<char>(written)), std::istreambuf_iterator<char>());
+            ASSERT_EQ(content, expected[i]);
+        }
+
+        // appending writes on after what the file has
+        files[0].reset();
+        async_io_file appended("async_io_0.txt", 512, 3, true, writer);
+        ASSERT_EQ(appended.size(), expected[0].size());
+        appended.write("tail\n", 5);
+    }
+    ASSERT_EQ(count_lines("async_io_0.txt"), 2001);
+    ASSERT_THROW(async_io_file("/dev/null"), std::runtime_error);
+}
+
+TEST(ClientLoggerTest, AsyncIoStreamsFromAsyncLogger) {
+    std::string format = "%m";
+    client_logger_builder builder;
+    builder.set_format(format);
+    builder.set_async(1024);
+    builder.set_async_io_buffer(1024);
+    for (int i = 0; i < 16; ++i) {
+        builder.add_async_io_file_stream("async_io_stream_" + std::to_string(i) + ".txt", logger::severity::information);
+    }
+    logger *logger_tmp = builder.build();
+
+    for (int i = 0; i < 3000; ++i) {
+        logger_tmp->information("record " + std::to_string(i));
+    }
+    dynamic_cast<client_logger *>(logger_tmp)->flush();
+    for (int i = 0; i < 16; ++i) {
+        ASSERT_EQ(count_lines("async_io_stream_" + std::to_string(i) + ".txt"), 3000);
+    }
+
+    // what is left in the buffers is written when the logger goes
+    logger_tmp->information("last");
+    delete logger_tmp;
+    ASSERT_EQ(count_lines("async_io_stream_15.txt"), 3001);
+}
+
+void remove_segments(std::string const &file_name)
+{
+    std::filesystem::remove(file_name);
+    std::filesystem::remove(file_name + ".next");
+    for (size_t index = 1; index < 1000; ++index) {
+        std::filesystem::remove(file_name + "." + std::to_string(index));
+    }
+}
+
+TEST(ClientLoggerTest, RotationBySizeKeepsEveryLine) {
+    remove_segments("rotation.txt");
+    {
+        std::ofstream configuration("rotation.json");
+        configuration << R"({"rotating": [["rotation.txt", ["information"], {"rotate_bytes": 4096}]]})";
+    }
+
+    std::string format = "%m";
+    client_logger_builder builder;
+    builder.transform_with_configuration("rotation.json", "rotating");
+    builder.set_format(format);
+    logger *logger_tmp = builder.build();
+    for (int i = 0; i < 2000; ++i) {
+        logger_tmp->information("record " + std::to_string(i));
+        if (i % 100 == 0) {
+            // lets the preparer keep up on a single core
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    delete logger_tmp;
+
+    ASSERT_FALSE(std::filesystem::exists("rotation.txt.next"));
+
+    std::vector<std::string> segments;
+    for (size_t index = 1; std::filesystem::exists("rotation.txt." + std::to_string(index)); ++index) {
+        segments.push_back("rotation.txt." + std::to_string(index));
+        ASSERT_LT(std::filesystem::file_size(segments.back()), 4096 + 16);
+    }
+    ASSERT_GE(segments.size(), 3);
+    segments.push_back("rotation.txt");
+
+    int expected = 0;
+    for (auto &segment : segments) {
+        std::ifstream file(segment);
+        std::string line;
+        while (std::getline(file, line)) {
+            ASSERT_EQ(line, "record " + std::to_string(expected++));
+        }
+    }
+    ASSERT_EQ(expected, 2000);
+}
+
+TEST(ClientLoggerTest, RotationByTimeKeepsNewestSegments) {
+    remove_segments("rotation_time.txt");
+
+    rotation_policy rotation;
+    rotation.interval = std::chrono::milliseconds(5);
+    rotation.kept_segments = 2;
+
+    client_logger_builder builder;
+    builder.add_file_stream("rotation_time.txt", logger::severity::information);
+    builder.set_rotation(rotation);
+    logger *logger_tmp = builder.build();
+    for (int i = 0; i < 8; ++i) {
+        logger_tmp->information("record");
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    delete logger_tmp;
+
+    size_t archived = 0;
+    size_t newest = 0;
+    for (size_t index = 1; index < 10; ++index) {
+        if (std::filesystem::exists("rotation_time.txt." + std::to_string(index))) {
+            ++archived;
+            newest = index;
+        }
+    }
+    ASSERT_EQ(archived, 2);
+    ASSERT_TRUE(std::filesystem::exists("rotation_time.txt." + std::to_string(newest - 1)));
+    ASSERT_GE(newest, 3);
+}
+
+TEST(ClientLoggerTest, ReconfigureReroutesWithoutRebuilding) {
+    std::filesystem::remove("routes_first.txt");
+    std::filesystem::remove("routes_second.txt");
+
+    std::string format = "%m";
+    client_logger_builder builder;
+    builder.set_format(format);
+    builder.add_file_stream("routes_first.txt", logger::severity::information);
+    logger *logger_tmp = builder.build();
+    auto *reconfigurable = dynamic_cast<client_logger *>(logger_tmp);
+
+    logger_tmp->information("first");
+    logger_tmp->debug("nowhere");
+    reconfigurable->reconfigure({ { "routes_first.txt", { logger::severity::debug } }, { "routes_second.txt", { logger::severity::information } } });
+    ASSERT_TRUE(logger_tmp->is_enabled(logger::severity::debug));
+    logger_tmp->information("second");
+    logger_tmp->debug("debug in first");
+
+    // a stream that can't be opened leaves the routes as they were
+    ASSERT_THROW(reconfigurable->reconfigure({ { "no_such_directory/file.txt", { logger::severity::error } } }), std::runtime_error);
+    ASSERT_FALSE(logger_tmp->is_enabled(logger::severity::error));
+    logger_tmp->information("second again");
+    delete logger_tmp;
+
+    std::ifstream first("routes_first.txt");
+    std::string line;
+    std::getline(first, line);
+    ASSERT_EQ(line, "first");
+    std::getline(first, line);
+    ASSERT_EQ(line, "debug in first");
+    ASSERT_FALSE(std::getline(first, line));
+
+    std::ifstream second("routes_second.txt");
+    std::getline(second, line);
+    ASSERT_EQ(line, "second");
+    std::getline(second, line);
+    ASSERT_EQ(line, "second again");
+    ASSERT_FALSE(std::getline(second, line));
+}
+
+TEST(ClientLoggerTest, ReconfigureUnderConcurrentLogging) {
+    std::filesystem::remove("routes_a.txt");
+    std::filesystem::remove("routes_b.txt");
+
+    std::string format = "%m";
+    client_logger_builder builder;
+    builder.set_format(format);
+    builder.add_file_stream("routes_a.txt", logger::severity::information);
+    builder.set_async(1 << 10);
+    logger *logger_tmp = builder.build();
+    auto *reconfigurable = dynamic_cast<client_logger *>(logger_tmp);
+
+    size_t constexpr producers_count = 4;
+    size_t constexpr records_per_producer = 5000;
+    std::vector<std::thread> producers;
+    for (size_t i = 0; i < producers_count; ++i) {
+        producers.emplace_back([logger_tmp]() {
+            for (size_t j = 0; j < records_per_producer; ++j) {
+                logger_tmp->log(logger::severity::information, "record {}", j);
+            }
+        });
+    }
+    for (size_t i = 0; i < 50; ++i) {
+        reconfigurable->reconfigure({ { i % 2 == 0 ? "routes_b.txt" : "routes_a.txt", { logger::severity::information } } });
+    }
+    for (auto &producer : producers) {
+        producer.join();
+    }
+    delete logger_tmp;
+
+    // every record went to one of the two, never both
+    ASSERT_EQ(count_lines("routes_a.txt") + count_lines("routes_b.txt"), producers_count * records_per_producer);
+}
+
+TEST(ClientLoggerTest, WatchedConfigurationReloads) {
+    std::filesystem::remove("watched.txt");
+    std::filesystem::remove("watched_errors.txt");
+    {
+        std::ofstream configuration("watched.json");
+        configuration << R"({"watched": [["watched.txt", ["information"]]]})";
+    }
+
+    std::string format = "%m";
+    client_logger_builder builder;
+    builder.transform_with_configuration("watched.json", "watched");
+    builder.set_format(format);
+    logger *logger_tmp = builder.build();
+    dynamic_cast<client_logger *>(logger_tmp)->watch_configuration("watched.json", "watched");
+
+    logger_tmp->error("not routed yet");
+    {
+        // saved the way editors do: a new file renamed over the old one
+        std::ofstream configuration("watched.json.tmp");
+        configuration << R"({"watched": [["watched.txt", ["information"]], ["watched_errors.txt", ["error"]]]})";
+    }
+    std::filesystem::rename("watched.json.tmp", "watched.json");
+
+    for (size_t i = 0; i < 200 && !logger_tmp->is_enabled(logger::severity::error); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ASSERT_TRUE(logger_tmp->is_enabled(logger::severity::error));
+    logger_tmp->error("routed");
+
+    {
+        std::ofstream configuration("watched.json");
+        configuration << "{ broken";
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_TRUE(logger_tmp->is_enabled(logger::severity::error));
+    delete logger_tmp;
+
+    ASSERT_EQ(count_lines("watched.txt"), 0);
+    std::ifstream errors("watched_errors.txt");
+    std::string line;
+    std::getline(errors, line);
+    ASSERT_EQ(line, "routed");
+    ASSERT_FALSE(std::getline(errors, line));
+}
 
 int main(
     int argc,
@@ -0,0 +1,174 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_FLIGHT_RECORDER_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_FLIGHT_RECORDER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../../logger/include/logger.h"
+
+// keeps the latest records of every thread in memory and writes them out only when asked to:
+// on a record of a dump severity, on dump() or on a fatal signal; a dump is a binary log (see
+// binary_log.h) with the records of all threads merged by time, so the decoder reads it
+class flight_recorder final: public logger
+{
+
+    friend class flight_recorder_builder;
+
+public:
+
+    static constexpr size_t default_ring_bytes = 64 * 1024;
+
+    static constexpr size_t default_max_threads = 256;
+
+    static constexpr std::chrono::milliseconds default_min_dump_interval = std::chrono::seconds(1);
+
+private:
+
+    static constexpr size_t severities_count = static_cast<size_t>(logger::severity::critical) + 1;
+
+    // binary_log record entries of one thread back to back; only that thread writes, a dump
+    // copies the bytes out and, as a seqlock reader does, keeps what the writer didn't touch
+    // meanwhile
+    struct thread_ring
+    {
+        std::unique_ptr<char[]> bytes;
+        size_t capacity;
+
+        // bytes written in total and the start of the oldest whole record, positions in
+        // the ring are these modulo capacity
+        std::atomic<uint64_t> head;
+        std::atomic<uint64_t> tail;
+
+        // false once the thread is gone, a new thread may take the ring over
+        std::atomic<bool> owned;
+
+        // set when the recorder is destroyed, so threads drop the ring from their cache
+        std::atomic<bool> retired;
+
+        // linear copy made by a dump, and the next record the merge takes from it
+        std::unique_ptr<char[]> snapshot;
+        size_t snapshot_size;
+        size_t snapshot_position;
+
+        explicit thread_ring(size_t capacity);
+
+        void push(char const *header, size_t header_size, char const *text, size_t text_size) noexcept;
+
+        void take_snapshot() noexcept;
+
+        void copy_out(char *destination, uint64_t from, size_t size) const noexcept;
+    };
+
+private:
+
+    // threads find their rings by it, a moved recorder takes the id of the other one along
+    uint64_t _id;
+
+    // bit per severity, records of others are not kept
+    uint32_t _recorded;
+
+    // bit per severity whose records trigger a dump
+    uint32_t _dump_triggers;
+
+    std::string _dump_path;
+
+    size_t _ring_bytes;
+
+    size_t _max_threads;
+
+    std::chrono::milliseconds _min_dump_interval;
+
+    bool _dump_on_signal;
+
+    // rings in registration order, read by dumps without locking
+    std::unique_ptr<std::atomic<thread_ring *>[]> _rings;
+
+    std::atomic<size_t> mutable _rings_count;
+
+    // owners of the rings, only touched when a thread registers
+    std::vector<std::shared_ptr<thread_ring>> mutable _owned_rings;
+
+    std::mutex mutable _rings_mutex;
+
+    // one dump at a time, a signal handler gives up instead of waiting
+    std::atomic<bool> mutable _dumping;
+
+    std::atomic<int64_t> mutable _next_triggered_dump;
+
+    std::atomic<size_t> mutable _dumps_count;
+
+    // records of threads beyond _max_threads
+    std::atomic<size_t> mutable _lost_records;
+
+    // what a dump is written through and its file name, allocated up front so a signal
+    // handler can dump without allocating
+    std::unique_ptr<char[]> _dump_buffer;
+
+    std::unique_ptr<char[]> _dump_file_name;
+
+private:
+
+    flight_recorder(
+        std::string dump_path,
+        uint32_t recorded,
+        uint32_t dump_triggers,
+        size_t ring_bytes = default_ring_bytes,
+        size_t max_threads = default_max_threads,
+        std::chrono::milliseconds min_dump_interval = default_min_dump_interval,
+        bool dump_on_signal = true);
+
+    void allocate();
+
+    void release() noexcept;
+
+    thread_ring *ring_of_current_thread() const noexcept;
+
+    thread_ring *register_thread() const noexcept;
+
+    void trigger_dump() const noexcept;
+
+    // writes the rings out under _dumping, calling nothing a signal handler can't call;
+    // false if the file can't be written
+    bool write_dump() const noexcept;
+
+    static void install_signal_handlers();
+
+    static void on_fatal_signal(int signal_number) noexcept;
+
+public:
+
+    flight_recorder(flight_recorder const &other);
+
+    flight_recorder &operator=(flight_recorder const &other);
+
+    flight_recorder(flight_recorder &&other) noexcept;
+
+    flight_recorder &operator=(flight_recorder &&other) noexcept;
+
+    ~flight_recorder() noexcept final;
+
+public:
+
+    // a memcpy into the ring of the calling thread, nothing leaves the process
+    [[nodiscard]] logger const *log(const std::string &message, logger::severity severity) const noexcept override;
+
+    using logger::log;
+
+    [[nodiscard]] bool is_enabled(logger::severity severity) const noexcept override;
+
+    // writes what the rings hold to <dump path>.<n> and returns that name; throws if the
+    // file can't be written
+    std::string dump();
+
+    [[nodiscard]] size_t dumps_count() const noexcept;
+
+    [[nodiscard]] size_t lost_records() const noexcept;
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_FLIGHT_RECORDER_H
@@ -0,0 +1,79 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_FLIGHT_RECORDER_BUILDER_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_FLIGHT_RECORDER_BUILDER_H
+
+#include <nlohmann/json.hpp>
+#include <fstream>
+
+#include <logger_builder.h>
+#include "flight_recorder.h"
+
+class flight_recorder_builder final: public logger_builder
+{
+
+    // dumps go to <dump path>.1, <dump path>.2, ...
+    std::string _dump_path;
+
+    uint32_t _recorded;
+
+    logger::severity _dump_severity;
+
+    size_t _ring_bytes;
+
+    size_t _max_threads;
+
+    std::chrono::milliseconds _min_dump_interval;
+
+    bool _dump_on_signal;
+
+public:
+
+    // bytes of the ring every logging thread gets
+    logger_builder * set_ring_size(size_t ring_bytes);
+
+    // threads past this many are not recorded, their records are counted as lost
+    logger_builder * set_max_threads(size_t max_threads);
+
+    // records of the severity and above trigger a dump, error by default
+    logger_builder * set_dump_severity(logger::severity severity);
+
+    // dumps triggered by records are at least this far apart
+    logger_builder * set_min_dump_interval(std::chrono::milliseconds interval);
+
+    // dump on SIGSEGV, SIGBUS, SIGFPE, SIGILL and SIGABRT, on by default
+    logger_builder * set_dump_on_signal(bool dump_on_signal);
+
+public:
+
+    flight_recorder_builder();
+
+    flight_recorder_builder(flight_recorder_builder const &other) = default;
+
+    flight_recorder_builder &operator=(flight_recorder_builder const &other) = default;
+
+    flight_recorder_builder(flight_recorder_builder &&other) noexcept = default;
+
+    flight_recorder_builder &operator=(flight_recorder_builder &&other) noexcept = default;
+
+    ~flight_recorder_builder() noexcept override = default;
+
+public:
+
+    // the recorder has one dump file; the severity is recorded, another path throws
+    logger_builder *add_file_stream(std::string const &stream_file_path, logger::severity severity) override;
+
+    // throws, a flight recorder only writes dump files
+    logger_builder *add_console_stream(logger::severity severity) override;
+
+    // the configuration is either an array of streams [file, [severities]] or
+    // {"streams": [...], "ring_bytes": .., "max_threads": .., "dump_severity": "error",
+    //  "min_dump_interval_ms": .., "dump_on_signal": ..}
+    logger_builder* transform_with_configuration(std::string const &configuration_file_path, std::string const &configuration_path) override;
+
+    logger_builder *clear() override;
+
+    // throws if there is no dump file
+    [[nodiscard]] logger *build() const override;
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_FLIGHT_RECORDER_BUILDER_H
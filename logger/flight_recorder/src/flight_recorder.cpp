@@ -0,0 +1,608 @@
+#include "../include/flight_recorder.h"
+
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../../client_logger/include/binary_log.h"
+#include "../../logger/include/log_clock.h"
+
+namespace
+{
+
+    // record entry up to the text: entry header, record header, one string argument
+    constexpr size_t record_prefix_size = binary_log::entry_header_size + binary_log::record_header_size
+        + sizeof(uint8_t) + sizeof(uint8_t) + sizeof(uint32_t);
+
+    constexpr size_t dump_buffer_size = 64 * 1024;
+
+    constexpr size_t max_signal_recorders = 64;
+
+    constexpr int fatal_signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+
+    std::atomic<uint64_t> next_recorder_id(1);
+
+    // recorders dumping on a fatal signal, slots are taken and given back with a compare and swap
+    std::atomic<flight_recorder const *> signal_recorders[max_signal_recorders];
+
+    struct sigaction previous_actions[std::size(fatal_signals)];
+
+    std::once_flag signal_handlers_installed;
+
+    // rings of the current thread by recorder id; given up when the thread ends
+    struct thread_rings
+    {
+        struct entry
+        {
+            uint64_t recorder;
+            std::shared_ptr<void> ring;
+            void *raw;
+        };
+
+        std::vector<entry> entries;
+
+        ~thread_rings()
+        {
+            for (auto &item : entries) {
+                static_cast<std::atomic<bool> *>(item.raw)->store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    thread_local thread_rings current_thread_rings;
+
+    void register_for_signals(flight_recorder const *recorder) noexcept
+    {
+        for (auto &slot : signal_recorders) {
+            flight_recorder const *empty = nullptr;
+            if (slot.compare_exchange_strong(empty, recorder)) {
+                return;
+            }
+        }
+    }
+
+    void unregister_from_signals(flight_recorder const *recorder) noexcept
+    {
+        for (auto &slot : signal_recorders) {
+            flight_recorder const *expected = recorder;
+            if (slot.compare_exchange_strong(expected, nullptr)) {
+                return;
+            }
+        }
+    }
+
+    bool write_all(int descriptor, char const *data, size_t size) noexcept
+    {
+        while (size != 0) {
+            ssize_t written = ::write(descriptor, data, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    // buffered writer over a preallocated buffer, safe in a signal handler
+    struct dump_writer
+    {
+        int descriptor;
+        char *buffer;
+        size_t used;
+        bool failed;
+
+        void append(char const *data, size_t size) noexcept
+        {
+            while (size != 0 && !failed) {
+                size_t part = std::min(size, dump_buffer_size - used);
+                memcpy(buffer + used, data, part);
+                used += part;
+                data += part;
+                size -= part;
+                if (used == dump_buffer_size) {
+                    flush();
+                }
+            }
+        }
+
+        void flush() noexcept
+        {
+            failed = failed || !write_all(descriptor, buffer, used);
+            used = 0;
+        }
+    };
+
+    // seconds and nanoseconds of the record entry at position, for ordering
+    std::pair<int64_t, uint32_t> record_time(char const *entry) noexcept
+    {
+        int64_t seconds;
+        uint32_t nanoseconds;
+        memcpy(&seconds, entry + binary_log::entry_header_size + sizeof(uint8_t), sizeof(seconds));
+        memcpy(&nanoseconds, entry + binary_log::entry_header_size + sizeof(uint8_t) + sizeof(int64_t), sizeof(nanoseconds));
+        return { seconds, nanoseconds };
+    }
+
+    uint32_t entry_size(char const *entry) noexcept
+    {
+        uint32_t payload_size;
+        memcpy(&payload_size, entry + sizeof(uint8_t), sizeof(payload_size));
+        return static_cast<uint32_t>(binary_log::entry_header_size) + payload_size;
+    }
+
+}
+
+flight_recorder::thread_ring::thread_ring(size_t capacity) :
+    bytes(std::make_unique<char[]>(capacity)), capacity(capacity), head(0), tail(0), owned(true), retired(false),
+    snapshot(std::make_unique<char[]>(capacity)), snapshot_size(0), snapshot_position(0) {}
+
+void flight_recorder::thread_ring::copy_out(char *destination, uint64_t from, size_t size) const noexcept
+{
+    size_t offset = static_cast<size_t>(from % capacity);
+    size_t first = std::min(size, capacity - offset);
+    memcpy(destination, bytes.get() + offset, first);
+    memcpy(destination + first, bytes.get(), size - first);
+}
+
+void flight_recorder::thread_ring::push(char const *header, size_t header_size, char const *text, size_t text_size) noexcept
+{
+    uint64_t position = head.load(std::memory_order_relaxed);
+    uint64_t oldest = tail.load(std::memory_order_relaxed);
+    size_t size = header_size + text_size;
+
+    // the oldest records make room, the tail moves past them before their bytes are reused
+    if (position + size - oldest > capacity) {
+        while (position + size - oldest > capacity) {
+            char prefix[binary_log::entry_header_size];
+            copy_out(prefix, oldest, sizeof(prefix));
+            oldest += entry_size(prefix);
+        }
+        tail.store(oldest, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    size_t offset = static_cast<size_t>(position % capacity);
+    auto write = [&](char const *data, size_t data_size) {
+        size_t first = std::min(data_size, capacity - offset);
+        memcpy(bytes.get() + offset, data, first);
+        memcpy(bytes.get(), data + first, data_size - first);
+        offset = (offset + data_size) % capacity;
+    };
+    write(header, header_size);
+    write(text, text_size);
+
+    head.store(position + size, std::memory_order_release);
+}
+
+void flight_recorder::thread_ring::take_snapshot() noexcept
+{
+    // the tail first, so the head read after it is never behind it
+    uint64_t start = tail.load(std::memory_order_acquire);
+    uint64_t end = head.load(std::memory_order_acquire);
+
+    // the writer may have gone round the ring between the two loads, only the last capacity
+    // bytes can still be there; the tail check below finds the first whole record among them
+    if (end - start > capacity) {
+        start = end - capacity;
+    }
+    copy_out(snapshot.get(), start, static_cast<size_t>(end - start));
+
+    // whatever the writer overwrote while the bytes were copied is behind the tail now
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t valid = tail.load(std::memory_order_relaxed);
+
+    snapshot_size = static_cast<size_t>(end - start);
+    snapshot_position = valid >= end ? snapshot_size : static_cast<size_t>(std::max(valid, start) - start);
+}
+
+flight_recorder::flight_recorder(
+    std::string dump_path,
+    uint32_t recorded,
+    uint32_t dump_triggers,
+    size_t ring_bytes,
+    size_t max_threads,
+    std::chrono::milliseconds min_dump_interval,
+    bool dump_on_signal) :
+        _id(0),
+        _recorded(recorded | dump_triggers),
+        _dump_triggers(dump_triggers),
+        _dump_path(std::move(dump_path)),
+        _ring_bytes(ring_bytes),
+        _max_threads(max_threads),
+        _min_dump_interval(min_dump_interval),
+        _dump_on_signal(dump_on_signal),
+        _rings_count(0),
+        _dumping(false),
+        _next_triggered_dump(0),
+        _dumps_count(0),
+        _lost_records(0)
+{
+    if (_ring_bytes < 4 * record_prefix_size) {
+        throw std::runtime_error("Flight recorder ring is too small\n");
+    }
+    allocate();
+}
+
+flight_recorder::flight_recorder(flight_recorder const &other) :
+    flight_recorder(other._dump_path, other._recorded, other._dump_triggers, other._ring_bytes, other._max_threads,
+                    other._min_dump_interval, other._dump_on_signal) {}
+
+flight_recorder &flight_recorder::operator=(flight_recorder const &other)
+{
+    if (this == &other) {
+        return *this;
+    }
+    release();
+    _recorded = other._recorded;
+    _dump_triggers = other._dump_triggers;
+    _dump_path = other._dump_path;
+    _ring_bytes = other._ring_bytes;
+    _max_threads = other._max_threads;
+    _min_dump_interval = other._min_dump_interval;
+    _dump_on_signal = other._dump_on_signal;
+    allocate();
+    return *this;
+}
+
+flight_recorder::flight_recorder(flight_recorder &&other) noexcept :
+    _id(0), _recorded(0), _dump_triggers(0), _ring_bytes(0), _max_threads(0), _min_dump_interval(0), _dump_on_signal(false),
+    _rings_count(0), _dumping(false), _next_triggered_dump(0), _dumps_count(0), _lost_records(0)
+{
+    *this = std::move(other);
+}
+
+flight_recorder &flight_recorder::operator=(flight_recorder &&other) noexcept
+{
+    if (this == &other) {
+        return *this;
+    }
+    release();
+
+    std::scoped_lock lock(_rings_mutex, other._rings_mutex);
+    if (other._dump_on_signal) {
+        unregister_from_signals(&other);
+    }
+
+    // threads keep finding their rings by the id, so the rings move along with it
+    _id = other._id;
+    _recorded = other._recorded;
+    _dump_triggers = other._dump_triggers;
+    _dump_path = std::move(other._dump_path);
+    _ring_bytes = other._ring_bytes;
+    _max_threads = other._max_threads;
+    _min_dump_interval = other._min_dump_interval;
+    _dump_on_signal = other._dump_on_signal;
+    _rings = std::move(other._rings);
+    _rings_count.store(other._rings_count.load());
+    _owned_rings = std::move(other._owned_rings);
+    _dumps_count.store(other._dumps_count.load());
+    _lost_records.store(other._lost_records.load());
+    _dump_buffer = std::move(other._dump_buffer);
+    _dump_file_name = std::move(other._dump_file_name);
+
+    other._id = 0;
+    other._recorded = 0;
+    other._dump_triggers = 0;
+    other._max_threads = 0;
+    other._dump_on_signal = false;
+    other._rings_count.store(0);
+
+    if (_dump_on_signal) {
+        register_for_signals(this);
+    }
+    return *this;
+}
+
+flight_recorder::~flight_recorder() noexcept
+{
+    release();
+}
+
+void flight_recorder::allocate()
+{
+    _id = next_recorder_id.fetch_add(1, std::memory_order_relaxed);
+    _rings = std::make_unique<std::atomic<thread_ring *>[]>(_max_threads);
+    _rings_count.store(0, std::memory_order_relaxed);
+    _dump_buffer = std::make_unique<char[]>(dump_buffer_size);
+
+    // room for ".<n>" and the terminator
+    _dump_file_name = std::make_unique<char[]>(_dump_path.size() + 32);
+    memcpy(_dump_file_name.get(), _dump_path.data(), _dump_path.size());
+
+    if (_dump_on_signal) {
+        install_signal_handlers();
+        register_for_signals(this);
+    }
+}
+
+void flight_recorder::release() noexcept
+{
+    if (_dump_on_signal) {
+        unregister_from_signals(this);
+    }
+
+    // waits for a dump in progress, the rings it reads go away below
+    bool idle = false;
+    while (!_dumping.compare_exchange_weak(idle, true, std::memory_order_acquire)) {
+        idle = false;
+        std::this_thread::yield();
+    }
+
+    std::lock_guard<std::mutex> lock(_rings_mutex);
+    for (auto &ring : _owned_rings) {
+        ring->retired.store(true, std::memory_order_release);
+    }
+    _owned_rings.clear();
+    _rings_count.store(0, std::memory_order_release);
+    _dumping.store(false, std::memory_order_release);
+}
+
+flight_recorder::thread_ring *flight_recorder::ring_of_current_thread() const noexcept
+{
+    for (auto &item : current_thread_rings.entries) {
+        if (item.recorder == _id) {
+            return static_cast<thread_ring *>(item.ring.get());
+        }
+    }
+    return register_thread();
+}
+
+flight_recorder::thread_ring *flight_recorder::register_thread() const noexcept
+{
+    if (_id == 0) {
+        return nullptr;
+    }
+
+    try {
+        auto &entries = current_thread_rings.entries;
+
+        // rings of recorders gone since are dropped here rather than on every record
+        std::erase_if(entries, [](thread_rings::entry const &item) {
+            return static_cast<thread_ring *>(item.ring.get())->retired.load(std::memory_order_acquire);
+        });
+
+        std::lock_guard<std::mutex> lock(_rings_mutex);
+        std::shared_ptr<thread_ring> ring;
+
+        // a ring left by a finished thread is taken over with the records it has
+        for (auto &candidate : _owned_rings) {
+            bool owned = false;
+            if (candidate->owned.compare_exchange_strong(owned, true, std::memory_order_acquire)) {
+                ring = candidate;
+                break;
+            }
+        }
+
+        if (ring == nullptr) {
+            size_t count = _rings_count.load(std::memory_order_relaxed);
+            if (count == _max_threads) {
+                return nullptr;
+            }
+            ring = std::make_shared<thread_ring>(_ring_bytes);
+            _owned_rings.push_back(ring);
+            _rings[count].store(ring.get(), std::memory_order_relaxed);
+            _rings_count.store(count + 1, std::memory_order_release);
+        }
+
+        entries.push_back(thread_rings::entry{ _id, ring, &ring->owned });
+        return ring.get();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+logger const *flight_recorder::log(const std::string &text, logger::severity severity) const noexcept
+{
+    if (!is_enabled(severity)) {
+        return this;
+    }
+
+    thread_ring *ring = ring_of_current_thread();
+    if (ring == nullptr) {
+        _lost_records.fetch_add(1, std::memory_order_relaxed);
+        return this;
+    }
+
+    // a record may take up to a quarter of the ring, longer text is cut
+    size_t text_size = std::min(text.size(), _ring_bytes / 4 - record_prefix_size);
+    auto now = log_clock::now();
+
+    char header[record_prefix_size];
+    char *position = header;
+    *position++ = static_cast<char>(binary_log::entry_kind::record);
+    auto payload_size = static_cast<uint32_t>(record_prefix_size - binary_log::entry_header_size + text_size);
+    memcpy(position, &payload_size, sizeof(payload_size));
+    position += sizeof(payload_size);
+    *position++ = static_cast<char>(severity);
+    auto seconds = static_cast<int64_t>(now.seconds);
+    memcpy(position, &seconds, sizeof(seconds));
+    position += sizeof(seconds);
+    memcpy(position, &now.nanoseconds, sizeof(now.nanoseconds));
+    position += sizeof(now.nanoseconds);
+    structured::format_id format = structured::text_format;
+    memcpy(position, &format, sizeof(format));
+    position += sizeof(format);
+    *position++ = 1;
+    *position++ = static_cast<char>(structured::argument_type::string);
+    auto size = static_cast<uint32_t>(text_size);
+    memcpy(position, &size, sizeof(size));
+
+    ring->push(header, sizeof(header), text.data(), text_size);
+
+    if ((_dump_triggers >> static_cast<size_t>(severity) & 1) != 0) {
+        trigger_dump();
+    }
+    return this;
+}
+
+bool flight_recorder::is_enabled(logger::severity severity) const noexcept
+{
+    return (_recorded >> static_cast<size_t>(severity) & 1) != 0;
+}
+
+void flight_recorder::trigger_dump() const noexcept
+{
+    // a burst of errors dumps once per interval, the context of the rest is in that dump
+    int64_t now = token_bucket::now();
+    int64_t next = _next_triggered_dump.load(std::memory_order_relaxed);
+    if (now < next) {
+        return;
+    }
+    int64_t interval = std::chrono::duration_cast<std::chrono::nanoseconds>(_min_dump_interval).count();
+    if (!_next_triggered_dump.compare_exchange_strong(next, now + interval, std::memory_order_relaxed)) {
+        return;
+    }
+
+    bool idle = false;
+    if (_dumping.compare_exchange_strong(idle, true, std::memory_order_acquire)) {
+        write_dump();
+        _dumping.store(false, std::memory_order_release);
+    }
+}
+
+bool flight_recorder::write_dump() const noexcept
+{
+    if (_dump_buffer == nullptr) {
+        return false;
+    }
+
+    // <dump path>.<n>, digits written by hand as snprintf is not async signal safe
+    size_t number = _dumps_count.fetch_add(1, std::memory_order_relaxed) + 1;
+    char digits[24];
+    size_t digits_count = 0;
+    do {
+        digits[digits_count++] = static_cast<char>('0' + number % 10);
+        number /= 10;
+    } while (number != 0);
+    char *name_end = _dump_file_name.get() + _dump_path.size();
+    *name_end++ = '.';
+    while (digits_count != 0) {
+        *name_end++ = digits[--digits_count];
+    }
+    *name_end = '\0';
+
+    int descriptor = ::open(_dump_file_name.get(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (descriptor < 0) {
+        return false;
+    }
+
+    dump_writer writer{ descriptor, _dump_buffer.get(), 0, false };
+    writer.append(binary_log::magic, sizeof(binary_log::magic));
+
+    // the only format the records use
+    char format_entry[binary_log::entry_header_size + sizeof(structured::format_id) + 2];
+    format_entry[0] = static_cast<char>(binary_log::entry_kind::format);
+    auto payload_size = static_cast<uint32_t>(sizeof(structured::format_id) + 2);
+    memcpy(format_entry + 1, &payload_size, sizeof(payload_size));
+    structured::format_id format = structured::text_format;
+    memcpy(format_entry + binary_log::entry_header_size, &format, sizeof(format));
+    memcpy(format_entry + binary_log::entry_header_size + sizeof(format), "{}", 2);
+    writer.append(format_entry, sizeof(format_entry));
+
+    size_t count = _rings_count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        _rings[i].load(std::memory_order_relaxed)->take_snapshot();
+    }
+
+    // every thread's records are in time order already, so a k-way merge puts them together
+    while (true) {
+        thread_ring *earliest = nullptr;
+        std::pair<int64_t, uint32_t> earliest_time;
+        for (size_t i = 0; i < count; ++i) {
+            thread_ring *ring = _rings[i].load(std::memory_order_relaxed);
+            if (ring->snapshot_position == ring->snapshot_size) {
+                continue;
+            }
+            auto time = record_time(ring->snapshot.get() + ring->snapshot_position);
+            if (earliest == nullptr || time < earliest_time) {
+                earliest = ring;
+                earliest_time = time;
+            }
+        }
+        if (earliest == nullptr) {
+            break;
+        }
+
+        char const *entry = earliest->snapshot.get() + earliest->snapshot_position;
+        uint32_t size = entry_size(entry);
+        writer.append(entry, size);
+        earliest->snapshot_position += size;
+    }
+
+    writer.flush();
+    bool written = !writer.failed;
+    ::close(descriptor);
+    return written;
+}
+
+std::string flight_recorder::dump()
+{
+    bool idle = false;
+    while (!_dumping.compare_exchange_weak(idle, true, std::memory_order_acquire)) {
+        idle = false;
+        std::this_thread::yield();
+    }
+    bool written = write_dump();
+    std::string file_name = _dump_file_name != nullptr ? _dump_file_name.get() : "";
+    _dumping.store(false, std::memory_order_release);
+
+    if (!written) {
+        throw std::runtime_error("Can't write flight recorder dump\n");
+    }
+    return file_name;
+}
+
+size_t flight_recorder::dumps_count() const noexcept
+{
+    return _dumps_count.load(std::memory_order_relaxed);
+}
+
+size_t flight_recorder::lost_records() const noexcept
+{
+    return _lost_records.load(std::memory_order_relaxed);
+}
+
+void flight_recorder::install_signal_handlers()
+{
+    std::call_once(signal_handlers_installed, []() {
+        for (size_t i = 0; i < std::size(fatal_signals); ++i) {
+            struct sigaction action = {};
+            action.sa_handler = &flight_recorder::on_fatal_signal;
+            sigemptyset(&action.sa_mask);
+            action.sa_flags = SA_RESETHAND;
+            sigaction(fatal_signals[i], &action, &previous_actions[i]);
+        }
+    });
+}
+
+void flight_recorder::on_fatal_signal(int signal_number) noexcept
+{
+    for (auto &slot : signal_recorders) {
+        flight_recorder const *recorder = slot.load(std::memory_order_acquire);
+        if (recorder == nullptr) {
+            continue;
+        }
+
+        // a dump the signal interrupted can't be waited for
+        bool idle = false;
+        if (recorder->_dumping.compare_exchange_strong(idle, true, std::memory_order_acquire)) {
+            recorder->write_dump();
+        }
+    }
+
+    // whatever handled the signal before takes it from here
+    for (size_t i = 0; i < std::size(fatal_signals); ++i) {
+        if (fatal_signals[i] == signal_number) {
+            sigaction(signal_number, &previous_actions[i], nullptr);
+        }
+    }
+    raise(signal_number);
+}
@@ -0,0 +1,109 @@
+#include "../include/flight_recorder_builder.h"
+
+flight_recorder_builder::flight_recorder_builder() :
+    _recorded(0), _dump_severity(logger::severity::error), _ring_bytes(flight_recorder::default_ring_bytes),
+    _max_threads(flight_recorder::default_max_threads), _min_dump_interval(flight_recorder::default_min_dump_interval),
+    _dump_on_signal(true) {}
+
+logger_builder *flight_recorder_builder::set_ring_size(size_t ring_bytes)
+{
+    _ring_bytes = ring_bytes;
+    return this;
+}
+
+logger_builder *flight_recorder_builder::set_max_threads(size_t max_threads)
+{
+    _max_threads = max_threads;
+    return this;
+}
+
+logger_builder *flight_recorder_builder::set_dump_severity(logger::severity severity)
+{
+    _dump_severity = severity;
+    return this;
+}
+
+logger_builder *flight_recorder_builder::set_min_dump_interval(std::chrono::milliseconds interval)
+{
+    _min_dump_interval = interval;
+    return this;
+}
+
+logger_builder *flight_recorder_builder::set_dump_on_signal(bool dump_on_signal)
+{
+    _dump_on_signal = dump_on_signal;
+    return this;
+}
+
+logger_builder *flight_recorder_builder::add_file_stream(std::string const &stream_file_path, logger::severity severity)
+{
+    if (!_dump_path.empty() && _dump_path != stream_file_path) {
+        throw std::runtime_error("Flight recorder has a single dump file\n");
+    }
+    _dump_path = stream_file_path;
+    _recorded |= 1u << static_cast<size_t>(severity);
+    return this;
+}
+
+logger_builder *flight_recorder_builder::add_console_stream([[maybe_unused]] logger::severity severity)
+{
+    throw std::runtime_error("Flight recorder can't dump to console\n");
+}
+
+logger_builder* flight_recorder_builder::transform_with_configuration(std::string const &configuration_file_path, std::string const &configuration_path)
+{
+    std::runtime_error nonexistent_file("Configuration file doesn't exist\n");
+    std::runtime_error empty_file("Can't find configuration path\n");
+
+    nlohmann::json configuration;
+    std::ifstream configuration_file(configuration_file_path, std::ios::binary);
+    if (!(configuration_file.is_open())) {
+        throw nonexistent_file;
+    }
+
+    if (configuration_file.peek() == EOF) {
+        throw empty_file;
+    }
+    configuration_file >> configuration;
+    if (configuration.find(configuration_path) == configuration.end()) {
+        throw empty_file;
+    }
+
+    auto &node = configuration[configuration_path];
+    auto &files = node.is_object() ? node["streams"] : node;
+    if (node.is_object()) {
+        _ring_bytes = node.value("ring_bytes", _ring_bytes);
+        _max_threads = node.value("max_threads", _max_threads);
+        if (node.contains("dump_severity")) {
+            _dump_severity = string_to_severity(node["dump_severity"]);
+        }
+        _min_dump_interval = std::chrono::milliseconds(node.value("min_dump_interval_ms", static_cast<int64_t>(_min_dump_interval.count())));
+        _dump_on_signal = node.value("dump_on_signal", _dump_on_signal);
+    }
+
+    for (auto & file : files) {
+        for (auto & severity : file[1]) {
+            add_file_stream(file[0], string_to_severity(severity));
+        }
+    }
+    return this;
+}
+
+logger_builder *flight_recorder_builder::clear()
+{
+    *this = flight_recorder_builder();
+    return this;
+}
+
+logger *flight_recorder_builder::build() const
+{
+    if (_dump_path.empty()) {
+        throw std::runtime_error("Flight recorder needs a dump file\n");
+    }
+
+    uint32_t dump_triggers = 0;
+    for (size_t severity = static_cast<size_t>(_dump_severity); severity <= static_cast<size_t>(logger::severity::critical); ++severity) {
+        dump_triggers |= 1u << severity;
+    }
+    return new flight_recorder(_dump_path, _recorded, dump_triggers, _ring_bytes, _max_threads, _min_dump_interval, _dump_on_signal);
+}
@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+#include <binary_log.h>
+#include <flight_recorder.h>
+#include <flight_recorder_builder.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+std::vector<binary_log::decoded_record> read_dump(std::string const &file_name)
+{
+    binary_log::reader reader(file_name);
+    std::vector<binary_log::decoded_record> records;
+    binary_log::decoded_record record;
+    while (reader.next(record)) {
+        records.push_back(record);
+    }
+    return records;
+}
+
+TEST(FlightRecorderTest, ErrorDumpsEarlierRecords) {
+    std::filesystem::remove("recorder_error.1");
+
+    flight_recorder_builder builder;
+    builder.set_dump_on_signal(false);
+    builder.add_file_stream("recorder_error", logger::severity::trace);
+    builder.add_file_stream("recorder_error", logger::severity::information);
+    logger *recorder = builder.build();
+
+    recorder->log("first", logger::severity::trace);
+    recorder->log("skipped", logger::severity::debug);
+    recorder->log("second", logger::severity::information);
+    EXPECT_FALSE(std::filesystem::exists("recorder_error.1"));
+
+    recorder->log("failed", logger::severity::error);
+    ASSERT_TRUE(std::filesystem::exists("recorder_error.1"));
+
+    auto records = read_dump("recorder_error.1");
+    ASSERT_EQ(records.size(), 3);
+    EXPECT_EQ(records[0].message, "first");
+    EXPECT_EQ(records[0].severity, logger::severity::trace);
+    EXPECT_EQ(records[1].message, "second");
+    EXPECT_EQ(records[2].message, "failed");
+    EXPECT_EQ(records[2].severity, logger::severity::error);
+
+    // the next error is within the minimum interval
+    recorder->log("failed again", logger::severity::critical);
+    EXPECT_EQ(dynamic_cast<flight_recorder *>(recorder)->dumps_count(), 1);
+
+    delete recorder;
+}
+
+TEST(FlightRecorderTest, DumpMergesThreadsInTimeOrder) {
+    flight_recorder_builder builder;
+    builder.set_dump_on_signal(false);
+    builder.add_file_stream("recorder_threads", logger::severity::information);
+    auto *recorder = dynamic_cast<flight_recorder *>(builder.build());
+
+    constexpr size_t threads_count = 4;
+    constexpr size_t records_per_thread = 100;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < threads_count; ++i) {
+        threads.emplace_back([recorder, i]() {
+            for (size_t j = 0; j < records_per_thread; ++j) {
+                EXPECT_EQ(recorder->log("thread " + std::to_string(i) + " record " + std::to_string(j), logger::severity::information), recorder);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    auto records = read_dump(recorder->dump());
+    ASSERT_EQ(records.size(), threads_count * records_per_thread);
+    for (size_t i = 1; i < records.size(); ++i) {
+        EXPECT_LE(std::make_pair(records[i - 1].seconds, records[i - 1].nanoseconds),
+                  std::make_pair(records[i].seconds, records[i].nanoseconds));
+    }
+    EXPECT_EQ(recorder->lost_records(), 0);
+
+    delete recorder;
+}
+
+TEST(FlightRecorderTest, RingKeepsNewestRecords) {
+    std::filesystem::remove("recorder_wrap.json");
+    {
+        std::ofstream configuration("recorder_wrap.json");
+        configuration << R"({"recorder": {"streams": [["recorder_wrap", ["information"]]],)"
+                      << R"( "ring_bytes": 1024, "max_threads": 1, "dump_on_signal": false}})";
+    }
+
+    flight_recorder_builder builder;
+    builder.transform_with_configuration("recorder_wrap.json", "recorder");
+    auto *recorder = dynamic_cast<flight_recorder *>(builder.build());
+
+    for (size_t i = 0; i < 1000; ++i) {
+        EXPECT_EQ(recorder->log("record " + std::to_string(i), logger::severity::information), recorder);
+    }
+
+    // a second thread gets no ring
+    std::thread([recorder]() { EXPECT_EQ(recorder->log("lost", logger::severity::information), recorder); }).join();
+    EXPECT_EQ(recorder->lost_records(), 1);
+
+    auto records = read_dump(recorder->dump());
+    ASSERT_FALSE(records.empty());
+    EXPECT_LT(records.size(), 1000);
+    EXPECT_EQ(records.back().message, "record 999");
+    for (size_t i = 0; i < records.size(); ++i) {
+        EXPECT_EQ(records[i].message, "record " + std::to_string(1000 - records.size() + i));
+    }
+
+    delete recorder;
+}
+
+TEST(FlightRecorderTest, DumpWhileRingWraps) {
+    flight_recorder_builder builder;
+    builder.set_dump_on_signal(false);
+    builder.set_ring_size(256);
+    builder.add_file_stream("recorder_flood", logger::severity::information);
+    auto *recorder = dynamic_cast<flight_recorder *>(builder.build());
+
+    // the writer goes round the small ring many times while every dump copies it
+    std::atomic<bool> stop(false);
+    std::atomic<size_t> written(0);
+    std::thread writer([recorder, &stop, &written]() {
+        for (size_t i = 0; !stop.load(); ++i) {
+            static_cast<void>(recorder->log("flood " + std::to_string(i), logger::severity::information));
+            written.store(i + 1);
+        }
+    });
+
+    for (size_t i = 0; i < 200; ++i) {
+        // a few laps of the ring between dumps at least
+        size_t before = written.load();
+        while (written.load() < before + 50) {
+            std::this_thread::yield();
+        }
+        for (auto const &record : read_dump(recorder->dump())) {
+            ASSERT_EQ(record.message.rfind("flood ", 0), 0);
+            ASSERT_EQ(record.severity, logger::severity::information);
+        }
+    }
+    stop = true;
+    writer.join();
+
+    delete recorder;
+}
+
+TEST(FlightRecorderTest, FatalSignalDumps) {
+    std::filesystem::remove("recorder_signal.1");
+
+    EXPECT_DEATH({
+        flight_recorder_builder builder;
+        builder.add_file_stream("recorder_signal", logger::severity::information);
+        logger *recorder = builder.build();
+        recorder->log("before abort", logger::severity::information);
+        std::abort();
+    }, "");
+
+    auto records = read_dump("recorder_signal.1");
+    ASSERT_EQ(records.size(), 1);
+    EXPECT_EQ(records[0].message, "before abort");
+}
+
+TEST(FlightRecorderTest, ConsoleStreamIsRejected) {
+    flight_recorder_builder builder;
+    EXPECT_THROW(builder.add_console_stream(logger::severity::error), std::runtime_error);
+    EXPECT_THROW(static_cast<void>(builder.build()), std::runtime_error);
+    builder.add_file_stream("recorder_one", logger::severity::error);
+    EXPECT_THROW(builder.add_file_stream("recorder_other", logger::severity::error), std::runtime_error);
+}
+
+int main(
+    int argc,
+    char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,49 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_CONFIGURATION_WATCHER_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_CONFIGURATION_WATCHER_H
+
+#include <functional>
+#include <string>
+#include <thread>
+
+// calls on_change from a thread of its own whenever the file is rewritten or replaced (editors
+// save by renaming a new file over the old one, so the directory is what gets watched);
+// linux only, elsewhere the constructor throws
+class configuration_watcher final
+{
+
+private:
+
+    std::string _file_path;
+
+    std::string _file_name;
+
+    std::function<void()> _on_change;
+
+    int _events;
+
+    // written to by the destructor to wake the thread up
+    int _stop;
+
+    std::thread _thread;
+
+public:
+
+    configuration_watcher(std::string const &file_path, std::function<void()> on_change);
+
+    configuration_watcher(configuration_watcher const &other) = delete;
+
+    configuration_watcher &operator=(configuration_watcher const &other) = delete;
+
+    ~configuration_watcher() noexcept;
+
+public:
+
+    [[nodiscard]] std::string const &file_path() const noexcept;
+
+private:
+
+    void watch_loop() noexcept;
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_CONFIGURATION_WATCHER_H
@@ -0,0 +1,50 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_LOG_CLOCK_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_LOG_CLOCK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+// wall clock shared by loggers; the broken down time of the current second is cached per
+// thread, so localtime_r only runs when the second changes and formatting never allocates
+class log_clock final
+{
+
+public:
+
+    struct timestamp
+    {
+        time_t seconds;
+        uint32_t nanoseconds;
+    };
+
+    // one second rendered in the layouts loggers use, all null terminated
+    struct calendar
+    {
+        time_t seconds;
+        struct tm broken_down;
+        char date[11];      // 2024-01-31
+        char time[9];       // 23:59:59
+        char datetime[20];  // 31.01.2024 23:59:59
+    };
+
+    static constexpr size_t max_fraction_digits = 9;
+
+public:
+
+    log_clock() = delete;
+
+public:
+
+    static timestamp now() noexcept;
+
+    // valid until the calling thread asks for another second
+    static calendar const &calendar_of(time_t seconds) noexcept;
+
+    // writes '.' and the first digits (1 to 9) of the fraction of a second, no terminator;
+    // returns the number of characters written
+    static size_t format_fraction(char *out, uint32_t nanoseconds, size_t digits) noexcept;
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_LOG_CLOCK_H
@@ -0,0 +1,71 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_LOG_FORMAT_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_LOG_FORMAT_H
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// "{}" formatting straight into an existing string, a stand-in for std::format_to until
+// every supported toolchain ships <format>; numbers go through to_chars, nothing allocates
+// beyond growing the output
+namespace log_format
+{
+
+    template<typename T>
+    void append(std::string &out, T const &value)
+    {
+        if constexpr (std::is_same_v<T, bool>) {
+            out += value ? "true" : "false";
+        } else if constexpr (std::is_same_v<T, char>) {
+            out += value;
+        } else if constexpr (std::is_arithmetic_v<T>) {
+            char digits[32];
+            auto result = std::to_chars(digits, digits + sizeof(digits), value);
+            out.append(digits, result.ptr);
+        } else if constexpr (std::is_enum_v<T>) {
+            append(out, static_cast<std::underlying_type_t<T>>(value));
+        } else if constexpr (std::is_convertible_v<T const &, std::string_view>) {
+            out += std::string_view(value);
+        } else {
+            static_assert(std::is_pointer_v<T>, "unsupported log argument type");
+            char digits[2 + 2 * sizeof(uintptr_t)] = { '0', 'x' };
+            auto result = std::to_chars(digits + 2, digits + sizeof(digits), reinterpret_cast<uintptr_t>(value), 16);
+            out.append(digits, result.ptr);
+        }
+    }
+
+    // appends format with the arguments substituted for "{}" in order; "{{" and "}}" are
+    // braces, placeholders left without an argument are kept as they are
+    template<typename... Args>
+    void format_to(std::string &out, std::string_view format, Args const &... args)
+    {
+        using appender = void (*)(std::string &, void const *);
+
+        std::array<appender, sizeof...(Args)> const appenders{
+            [](std::string &target, void const *value) { append(target, *static_cast<Args const *>(value)); }... };
+        std::array<void const *, sizeof...(Args)> const values{ static_cast<void const *>(&args)... };
+
+        size_t next = 0;
+        for (size_t i = 0; i < format.size(); ++i) {
+            char symbol = format[i];
+            if ((symbol == '{' || symbol == '}') && i + 1 < format.size() && format[i + 1] == symbol) {
+                out += symbol;
+                ++i;
+                continue;
+            }
+            if (symbol == '{' && i + 1 < format.size() && format[i + 1] == '}' && next < sizeof...(Args)) {
+                appenders[next](out, values[next]);
+                ++next;
+                ++i;
+                continue;
+            }
+            out += symbol;
+        }
+    }
+
+}
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_LOG_FORMAT_H
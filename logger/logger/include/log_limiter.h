@@ -0,0 +1,97 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_LOG_LIMITER_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_LOG_LIMITER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "logger.h"
+#include "rate_limit.h"
+
+// rate limits and sampling of a logger, one rate_limit per severity; counts what it suppresses
+// and tells when a summary of that is due
+class log_limiter final
+{
+
+public:
+
+    static constexpr size_t severities_count = static_cast<size_t>(logger::severity::critical) + 1;
+
+    static constexpr std::chrono::milliseconds default_summary_interval = std::chrono::seconds(1);
+
+private:
+
+    struct severity_state
+    {
+        rate_limit limit;
+        token_bucket bucket;
+        std::atomic<size_t> seen;
+        std::atomic<size_t> suppressed;
+    };
+
+private:
+
+    std::array<severity_state, severities_count> _states;
+
+    bool _active;
+
+    std::chrono::milliseconds _summary_interval;
+
+    std::atomic<int64_t> _next_summary;
+
+public:
+
+    explicit log_limiter(std::array<rate_limit, severities_count> const &limits = {}, std::chrono::milliseconds summary_interval = default_summary_interval) noexcept;
+
+    // copies the limits, the copy starts with full buckets and nothing suppressed
+    log_limiter(log_limiter const &other) noexcept;
+
+    log_limiter &operator=(log_limiter const &other) noexcept;
+
+public:
+
+    // false when no severity is limited, admit() is then always true
+    bool active() const noexcept
+    {
+        return _active;
+    }
+
+    bool admit(logger::severity severity, int64_t now) noexcept;
+
+    // true for one caller once per summary interval
+    bool summary_due(int64_t now) noexcept;
+
+    // records of the severity suppressed since the last call
+    size_t take_suppressed(logger::severity severity) noexcept;
+
+    std::array<rate_limit, severities_count> limits() const noexcept;
+
+    std::chrono::milliseconds summary_interval() const noexcept;
+
+public:
+
+    // "N records suppressed"
+    static std::string summary(size_t suppressed);
+
+    // reads {"trace": {"rate": 1000, "burst": 100, "sample_every": 10}, ...} into limits;
+    // the json type is a parameter so the logger library does not depend on a json library
+    template<typename json>
+    static void read_limits(json const &node, std::array<rate_limit, severities_count> &limits,
+                            logger::severity (*to_severity)(std::string const &))
+    {
+        for (auto const &entry : node.items())
+        {
+            auto const &limit_node = entry.value();
+            rate_limit &limit = limits[static_cast<size_t>(to_severity(entry.key()))];
+            limit.rate = limit_node.value("rate", 0.0);
+            limit.burst = limit_node.value("burst", size_t{ 0 });
+            limit.sample_every = limit_node.value("sample_every", size_t{ 1 });
+        }
+    }
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_LOG_LIMITER_H
@@ -3,6 +3,11 @@
 
 #include <iostream>
 #include <sstream>
+#include <string>
+#include <string_view>
+
+#include "log_format.h"
+#include "rate_limit.h"
 
 class logger
 {
@@ -29,6 +34,70 @@ public:
         std::string const &message,
         logger::severity severity) const noexcept = 0;
 
+public:
+
+    // false when a record of this severity goes nowhere, so callers may skip building it
+    virtual bool is_enabled(
+        logger::severity severity) const noexcept;
+
+    // formats "{}" placeholders (see log_format.h) only once the severity is known to be
+    // enabled, and into a per thread buffer, so no temporary strings are left at the call site
+    template<typename... Args>
+    logger const *log(
+        logger::severity severity,
+        std::string_view format,
+        Args const &... args) const noexcept
+    {
+        if (!admit(severity))
+        {
+            return this;
+        }
+
+        std::string &buffer = message_buffer();
+        buffer.clear();
+        try
+        {
+            log_format::format_to(buffer, format, args...);
+        }
+        catch (...)
+        {
+            return this;
+        }
+        return log_admitted(buffer, severity);
+    }
+
+    // the same, limited by the call site as well (see rate_limit.h); the first record the site
+    // lets through after suppressing some says how many
+    template<typename... Args>
+    logger const *log(
+        call_site_limit &site,
+        logger::severity severity,
+        std::string_view format,
+        Args const &... args) const noexcept
+    {
+        if (!is_enabled(severity) || !site.admit() || !admit(severity))
+        {
+            return this;
+        }
+
+        std::string &buffer = message_buffer();
+        buffer.clear();
+        try
+        {
+            log_format::format_to(buffer, format, args...);
+            size_t suppressed = site.take_suppressed();
+            if (suppressed != 0)
+            {
+                log_format::format_to(buffer, " ({} suppressed at this call site)", suppressed);
+            }
+        }
+        catch (...)
+        {
+            return this;
+        }
+        return log_admitted(buffer, severity);
+    }
+
 public:
 
     logger const *trace(
@@ -51,11 +120,29 @@ public:
 
 protected:
 
+    // is_enabled plus the rate limits of the logger; the variadic log() asks it before
+    // formatting, so a suppressed record costs no formatting
+    virtual bool admit(
+        logger::severity severity) const noexcept;
+
+    // logs a record admit() has already let through
+    virtual logger const *log_admitted(
+        std::string const &message,
+        logger::severity severity) const noexcept;
+
+    static std::string &message_buffer() noexcept;
+
     static std::string severity_to_string(
         logger::severity severity);
 
     static std::string current_datetime_to_string() noexcept;
 
+    // same text plus a fraction of a second with fraction_digits digits (0 - none), written
+    // into buffer of at least 30 characters without allocating; returns the length
+    static size_t current_datetime_to_chars(
+        char *buffer,
+        size_t fraction_digits = 0) noexcept;
+
 };
 
 #endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_LOGGER_H
\ No newline at end of file
@@ -16,6 +16,41 @@ public:
         std::string const &message,
         logger::severity severity) const;
 
+    template<typename... Args>
+    logger_guardant const *log_with_guard(
+        logger::severity severity,
+        std::string_view format,
+        Args const &... args) const
+    {
+        logger *got_logger = get_logger();
+        if (got_logger != nullptr)
+        {
+            got_logger->log(severity, format, args...);
+        }
+
+        return this;
+    }
+
+    template<typename... Args>
+    logger_guardant const *log_with_guard(
+        call_site_limit &site,
+        logger::severity severity,
+        std::string_view format,
+        Args const &... args) const
+    {
+        logger *got_logger = get_logger();
+        if (got_logger != nullptr)
+        {
+            got_logger->log(site, severity, format, args...);
+        }
+
+        return this;
+    }
+
+    // for messages too expensive to build unconditionally
+    bool is_enabled_with_guard(
+        logger::severity severity) const;
+
     logger_guardant const *trace_with_guard(
         std::string const &message) const;
 
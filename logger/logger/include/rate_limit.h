@@ -0,0 +1,92 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_RATE_LIMIT_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_RATE_LIMIT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// how many records of one severity (or of one call site) get through
+struct rate_limit
+{
+    // records per second, 0 - no limit
+    double rate = 0;
+
+    // records let through back to back after a quiet spell, 0 - one
+    size_t burst = 0;
+
+    // keeps one record in this many, 1 - keeps all
+    size_t sample_every = 1;
+
+    bool enabled() const noexcept
+    {
+        return rate > 0 || sample_every > 1;
+    }
+};
+
+// token bucket kept as the moment it runs dry (GCRA), so taking a token is one compare and swap
+class token_bucket final
+{
+
+private:
+
+    std::atomic<int64_t> _empty_at;
+
+    // nanoseconds per token, 0 - no limit
+    int64_t _interval;
+
+    // how far ahead of now the bucket may run dry, the burst in nanoseconds
+    int64_t _tolerance;
+
+public:
+
+    explicit token_bucket(double rate = 0, size_t burst = 0) noexcept;
+
+    // the copy starts full
+    token_bucket(token_bucket const &other) noexcept;
+
+    token_bucket &operator=(token_bucket const &other) noexcept;
+
+public:
+
+    // steady clock in nanoseconds
+    static int64_t now() noexcept;
+
+    bool try_take(int64_t now) noexcept;
+
+};
+
+// rate_limit of one call site, kept in a static next to the call:
+//     static call_site_limit site(rate_limit{ 100 });
+//     logger->log(site, logger::severity::trace, "node {} rotated", key);
+// once the site lets a record through again, the message tells how many were suppressed before it
+class call_site_limit final
+{
+
+private:
+
+    token_bucket _bucket;
+
+    size_t _sample_every;
+
+    std::atomic<size_t> _seen;
+
+    std::atomic<size_t> _suppressed;
+
+public:
+
+    explicit call_site_limit(rate_limit limit) noexcept;
+
+    call_site_limit(call_site_limit const &other) = delete;
+
+    call_site_limit &operator=(call_site_limit const &other) = delete;
+
+public:
+
+    bool admit() noexcept;
+
+    // records suppressed since the last call
+    size_t take_suppressed() noexcept;
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_RATE_LIMIT_H
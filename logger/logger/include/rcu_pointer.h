@@ -0,0 +1,173 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_RCU_POINTER_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_RCU_POINTER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// immutable value replaced as a whole (read-copy-update): readers never wait, only bump a
+// counter of their epoch; a writer publishes the new value, flips the epoch and waits for
+// readers of the old epoch to leave before it frees the old value
+template<
+    typename T>
+class rcu_pointer final
+{
+
+private:
+
+    static constexpr size_t cache_line_size = 64;
+
+public:
+
+    // keeps the value it got alive while it exists, must not outlive the pointer
+    class reader final
+    {
+
+        friend class rcu_pointer;
+
+    private:
+
+        std::atomic<size_t> *_readers;
+
+        T const *_value;
+
+        reader(std::atomic<size_t> *readers, T const *value) noexcept;
+
+    public:
+
+        reader(reader const &other) = delete;
+
+        reader &operator=(reader const &other) = delete;
+
+        ~reader() noexcept;
+
+    public:
+
+        T const &operator*() const noexcept;
+
+        T const *operator->() const noexcept;
+
+    };
+
+private:
+
+    std::atomic<T *> _current;
+
+    alignas(cache_line_size) std::atomic<size_t> _epoch;
+
+    // readers inside each of the two epochs, on lines of their own
+    struct alignas(cache_line_size) readers_count
+    {
+        std::atomic<size_t> count{ 0 };
+    };
+
+    readers_count mutable _readers[2];
+
+    std::mutex _writer;
+
+public:
+
+    explicit rcu_pointer(std::unique_ptr<T> value);
+
+    rcu_pointer(rcu_pointer const &other) = delete;
+
+    rcu_pointer &operator=(rcu_pointer const &other) = delete;
+
+    ~rcu_pointer() noexcept;
+
+public:
+
+    [[nodiscard]] reader read() const noexcept;
+
+    // publishes value and hands the old one back once no reader can see it anymore;
+    // must not be called while the calling thread holds a reader of this pointer
+    std::unique_ptr<T> exchange(std::unique_ptr<T> value);
+
+    void replace(std::unique_ptr<T> value);
+
+};
+
+template<
+    typename T>
+rcu_pointer<T>::reader::reader(std::atomic<size_t> *readers, T const *value) noexcept :
+    _readers(readers), _value(value) {}
+
+template<
+    typename T>
+rcu_pointer<T>::reader::~reader() noexcept
+{
+    _readers->fetch_sub(1, std::memory_order_release);
+}
+
+template<
+    typename T>
+T const &rcu_pointer<T>::reader::operator*() const noexcept
+{
+    return *_value;
+}
+
+template<
+    typename T>
+T const *rcu_pointer<T>::reader::operator->() const noexcept
+{
+    return _value;
+}
+
+template<
+    typename T>
+rcu_pointer<T>::rcu_pointer(std::unique_ptr<T> value) :
+    _current(value.release()), _epoch(0) {}
+
+template<
+    typename T>
+rcu_pointer<T>::~rcu_pointer() noexcept
+{
+    delete _current.load(std::memory_order_relaxed);
+}
+
+template<
+    typename T>
+typename rcu_pointer<T>::reader rcu_pointer<T>::read() const noexcept
+{
+    auto *readers = &_readers[_epoch.load(std::memory_order_relaxed) & 1].count;
+
+    // seq_cst orders the count before the load of the value: a writer that saw the count
+    // still zero had already published the new value, so that is the one loaded here
+    readers->fetch_add(1, std::memory_order_seq_cst);
+    return reader(readers, _current.load(std::memory_order_seq_cst));
+}
+
+template<
+    typename T>
+std::unique_ptr<T> rcu_pointer<T>::exchange(std::unique_ptr<T> value)
+{
+    std::lock_guard<std::mutex> lock(_writer);
+
+    std::unique_ptr<T> old(_current.exchange(value.release(), std::memory_order_seq_cst));
+
+    // after a flip, new readers count in the other epoch and the one left only drains; it is
+    // flipped twice since a reader may have read the epoch before an earlier flip and count
+    // in either of the two
+    for (size_t flip = 0; flip < 2; ++flip) {
+        size_t epoch = _epoch.fetch_add(1, std::memory_order_seq_cst);
+        auto &readers = _readers[epoch & 1].count;
+        // seq_cst pairs with the reader's increment and load: the writer stores the value and
+        // loads the count, the reader does the opposite, and only seq_cst on both sides keeps
+        // them from both missing each other's store
+        while (readers.load(std::memory_order_seq_cst) != 0) {
+            std::this_thread::yield();
+        }
+    }
+    return old;
+}
+
+template<
+    typename T>
+void rcu_pointer<T>::replace(std::unique_ptr<T> value)
+{
+    exchange(std::move(value));
+}
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_RCU_POINTER_H
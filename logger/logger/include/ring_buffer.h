@@ -0,0 +1,204 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_RING_BUFFER_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+// what a producer does when the buffer is full
+enum class overflow_policy
+{
+    block,
+    drop_oldest,
+    drop
+};
+
+// bounded lock-free queue (sequence number per cell, D. Vyukov's scheme)
+// many producers push concurrently, pop is safe from several threads too,
+// that is what drop_oldest relies on when a producer evicts the oldest record
+template<
+    typename T>
+class ring_buffer final
+{
+
+private:
+
+    static constexpr size_t cache_line_size = 64;
+
+    struct cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+private:
+
+    std::unique_ptr<cell[]> _cells;
+
+    size_t _mask;
+
+    alignas(cache_line_size) std::atomic<size_t> _enqueue_position;
+
+    alignas(cache_line_size) std::atomic<size_t> _dequeue_position;
+
+public:
+
+    explicit ring_buffer(size_t capacity);
+
+    ring_buffer(ring_buffer const &other) = delete;
+
+    ring_buffer &operator=(ring_buffer const &other) = delete;
+
+    ring_buffer(ring_buffer &&other) noexcept = delete;
+
+    ring_buffer &operator=(ring_buffer &&other) noexcept = delete;
+
+    ~ring_buffer() noexcept = default;
+
+public:
+
+    bool try_push(T &&value) noexcept;
+
+    bool try_pop(T &value) noexcept;
+
+    [[nodiscard]] size_t capacity() const noexcept;
+
+    [[nodiscard]] bool empty() const noexcept;
+
+    // positions handed out to producers and consumers so far, both only grow
+    [[nodiscard]] size_t pushed() const noexcept;
+
+    [[nodiscard]] size_t popped() const noexcept;
+
+};
+
+template<
+    typename T>
+ring_buffer<T>::ring_buffer(size_t capacity)
+{
+    if (capacity < 2)
+    {
+        throw std::logic_error("ring buffer capacity must be at least 2");
+    }
+
+    // rounding up to power of two so position -> cell is a single mask
+    size_t rounded = 1;
+    while (rounded < capacity)
+    {
+        rounded <<= 1;
+    }
+
+    _cells = std::make_unique<cell[]>(rounded);
+    _mask = rounded - 1;
+    for (size_t i = 0; i < rounded; ++i)
+    {
+        _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    _enqueue_position.store(0, std::memory_order_relaxed);
+    _dequeue_position.store(0, std::memory_order_relaxed);
+}
+
+template<
+    typename T>
+bool ring_buffer<T>::try_push(T &&value) noexcept
+{
+    size_t position = _enqueue_position.load(std::memory_order_relaxed);
+    cell *target;
+
+    while (true)
+    {
+        target = &_cells[position & _mask];
+        size_t sequence = target->sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+        if (difference == 0)
+        {
+            if (_enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            // full
+            return false;
+        }
+        else
+        {
+            position = _enqueue_position.load(std::memory_order_relaxed);
+        }
+    }
+
+    target->value = std::move(value);
+    target->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+template<
+    typename T>
+bool ring_buffer<T>::try_pop(T &value) noexcept
+{
+    size_t position = _dequeue_position.load(std::memory_order_relaxed);
+    cell *target;
+
+    while (true)
+    {
+        target = &_cells[position & _mask];
+        size_t sequence = target->sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+
+        if (difference == 0)
+        {
+            if (_dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            // empty
+            return false;
+        }
+        else
+        {
+            position = _dequeue_position.load(std::memory_order_relaxed);
+        }
+    }
+
+    value = std::move(target->value);
+    target->sequence.store(position + _mask + 1, std::memory_order_release);
+    return true;
+}
+
+template<
+    typename T>
+size_t ring_buffer<T>::capacity() const noexcept
+{
+    return _mask + 1;
+}
+
+template<
+    typename T>
+bool ring_buffer<T>::empty() const noexcept
+{
+    return _enqueue_position.load(std::memory_order_acquire) == _dequeue_position.load(std::memory_order_acquire);
+}
+
+template<
+    typename T>
+size_t ring_buffer<T>::pushed() const noexcept
+{
+    return _enqueue_position.load(std::memory_order_acquire);
+}
+
+template<
+    typename T>
+size_t ring_buffer<T>::popped() const noexcept
+{
+    return _dequeue_position.load(std::memory_order_acquire);
+}
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_RING_BUFFER_H
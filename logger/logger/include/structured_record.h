@@ -0,0 +1,87 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_STRUCTURED_RECORD_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_STRUCTURED_RECORD_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// structured records: a registered format string with "{}" placeholders and typed arguments
+// packed into bytes; the text is only put together by a sink that needs it or by a decoder
+namespace structured
+{
+
+    using format_id = uint32_t;
+
+    // "{}" with one string argument, used for records logged as plain text
+    constexpr format_id text_format = 0;
+
+    enum class argument_type : uint8_t
+    {
+        signed_integer,
+        unsigned_integer,
+        floating,
+        boolean,
+        string
+    };
+
+    // process wide table; the same format always gets the same id
+    format_id register_format(std::string_view format);
+
+    // throws std::out_of_range for an unknown id
+    std::string_view format_of(format_id id);
+
+    // appends the text of format with arguments substituted for "{}", "{{" and "}}" are braces;
+    // throws std::runtime_error if the arguments are malformed
+    void format(std::string &out, std::string_view format, std::string_view arguments);
+
+    template<typename T>
+    void append_raw(std::string &out, T value)
+    {
+        char bytes[sizeof(T)];
+        memcpy(bytes, &value, sizeof(T));
+        out.append(bytes, sizeof(T));
+    }
+
+    template<typename T>
+    void encode_argument(std::string &out, T const &value)
+    {
+        if constexpr (std::is_same_v<T, bool>) {
+            out.push_back(static_cast<char>(argument_type::boolean));
+            out.push_back(value ? 1 : 0);
+        } else if constexpr (std::is_same_v<T, char>) {
+            // a symbol, as log_format prints it, not its code
+            out.push_back(static_cast<char>(argument_type::string));
+            append_raw<uint32_t>(out, 1);
+            out.push_back(value);
+        } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            out.push_back(static_cast<char>(argument_type::signed_integer));
+            append_raw<int64_t>(out, value);
+        } else if constexpr (std::is_integral_v<T>) {
+            out.push_back(static_cast<char>(argument_type::unsigned_integer));
+            append_raw<uint64_t>(out, value);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            out.push_back(static_cast<char>(argument_type::floating));
+            append_raw<double>(out, value);
+        } else {
+            static_assert(std::is_convertible_v<T const &, std::string_view>, "unsupported structured argument type");
+            std::string_view text = value;
+            out.push_back(static_cast<char>(argument_type::string));
+            append_raw<uint32_t>(out, static_cast<uint32_t>(text.size()));
+            out.append(text);
+        }
+    }
+
+    // arguments count followed by the arguments
+    template<typename... Args>
+    void encode_arguments(std::string &out, Args const &... args)
+    {
+        static_assert(sizeof...(Args) < 256, "too many structured arguments");
+        out.push_back(static_cast<char>(sizeof...(Args)));
+        (encode_argument(out, args), ...);
+    }
+
+}
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_STRUCTURED_RECORD_H
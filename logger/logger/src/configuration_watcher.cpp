@@ -0,0 +1,87 @@
+#include "../include/configuration_watcher.h"
+
+#include <filesystem>
+#include <stdexcept>
+
+#ifdef __linux__
+    #include <poll.h>
+    #include <sys/eventfd.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+configuration_watcher::configuration_watcher(std::string const &file_path, std::function<void()> on_change) :
+    _file_path(file_path), _on_change(std::move(on_change)), _events(-1), _stop(-1)
+{
+    #ifdef __linux__
+        std::filesystem::path path(file_path);
+        _file_name = path.filename().string();
+        std::string directory = path.has_parent_path() ? path.parent_path().string() : ".";
+
+        _events = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+        _stop = eventfd(0, EFD_CLOEXEC);
+        if (_events < 0 || _stop < 0 || inotify_add_watch(_events, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+            if (_events >= 0) close(_events);
+            if (_stop >= 0) close(_stop);
+            throw std::runtime_error("Can't watch configuration file\n");
+        }
+        _thread = std::thread(&configuration_watcher::watch_loop, this);
+    #else
+        throw std::runtime_error("Watching configuration files is not supported\n");
+    #endif
+}
+
+configuration_watcher::~configuration_watcher() noexcept
+{
+    #ifdef __linux__
+        uint64_t one = 1;
+        [[maybe_unused]] auto written = write(_stop, &one, sizeof(one));
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+        close(_events);
+        close(_stop);
+    #endif
+}
+
+std::string const &configuration_watcher::file_path() const noexcept
+{
+    return _file_path;
+}
+
+void configuration_watcher::watch_loop() noexcept
+{
+    #ifdef __linux__
+        alignas(inotify_event) char buffer[4096];
+        pollfd descriptors[2] = { { _events, POLLIN, 0 }, { _stop, POLLIN, 0 } };
+
+        while (true) {
+            if (poll(descriptors, 2, -1) < 0) {
+                continue;
+            }
+            if (descriptors[1].revents != 0) {
+                return;
+            }
+
+            bool changed = false;
+            ssize_t size;
+            while ((size = read(_events, buffer, sizeof(buffer))) > 0) {
+                for (char *position = buffer; position < buffer + size;) {
+                    auto *event = reinterpret_cast<inotify_event *>(position);
+                    if (event->len != 0 && _file_name == event->name) {
+                        changed = true;
+                    }
+                    position += sizeof(inotify_event) + event->len;
+                }
+            }
+
+            if (changed) {
+                try {
+                    _on_change();
+                } catch (...) {
+                    // a half written or broken file keeps what was configured before
+                }
+            }
+        }
+    #endif
+}
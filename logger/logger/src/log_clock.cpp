@@ -0,0 +1,47 @@
+#include "../include/log_clock.h"
+
+namespace
+{
+
+    // -1 matches no second a caller asks for, so the first call fills the cache
+    thread_local log_clock::calendar cached_calendar{ -1, {}, {}, {}, {} };
+
+}
+
+log_clock::timestamp log_clock::now() noexcept
+{
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return timestamp{ now.tv_sec, static_cast<uint32_t>(now.tv_nsec) };
+}
+
+log_clock::calendar const &log_clock::calendar_of(time_t seconds) noexcept
+{
+    auto &cached = cached_calendar;
+    if (cached.seconds == seconds) {
+        return cached;
+    }
+
+    localtime_r(&seconds, &cached.broken_down);
+    strftime(cached.date, sizeof(cached.date), "%F", &cached.broken_down);
+    strftime(cached.time, sizeof(cached.time), "%T", &cached.broken_down);
+    strftime(cached.datetime, sizeof(cached.datetime), "%d.%m.%Y %H:%M:%S", &cached.broken_down);
+    cached.seconds = seconds;
+    return cached;
+}
+
+size_t log_clock::format_fraction(char *out, uint32_t nanoseconds, size_t digits) noexcept
+{
+    if (digits == 0 || digits > max_fraction_digits) {
+        digits = max_fraction_digits;
+    }
+
+    out[0] = '.';
+    for (size_t i = max_fraction_digits; i > 0; --i) {
+        if (i <= digits) {
+            out[i] = static_cast<char>('0' + nanoseconds % 10);
+        }
+        nanoseconds /= 10;
+    }
+    return digits + 1;
+}
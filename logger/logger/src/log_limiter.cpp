@@ -0,0 +1,92 @@
+#include "../include/log_limiter.h"
+
+#include <algorithm>
+
+log_limiter::log_limiter(std::array<rate_limit, severities_count> const &limits, std::chrono::milliseconds summary_interval) noexcept :
+    _active(false), _summary_interval(summary_interval), _next_summary(0)
+{
+    for (size_t i = 0; i < severities_count; ++i) {
+        auto &state = _states[i];
+        state.limit = limits[i];
+        state.limit.sample_every = std::max<size_t>(state.limit.sample_every, 1);
+        state.bucket = token_bucket(state.limit.rate, state.limit.burst);
+        state.seen.store(0, std::memory_order_relaxed);
+        state.suppressed.store(0, std::memory_order_relaxed);
+        _active = _active || state.limit.enabled();
+    }
+}
+
+log_limiter::log_limiter(log_limiter const &other) noexcept :
+    log_limiter(other.limits(), other._summary_interval) {}
+
+log_limiter &log_limiter::operator=(log_limiter const &other) noexcept
+{
+    if (this == &other) {
+        return *this;
+    }
+    _active = false;
+    _summary_interval = other._summary_interval;
+    _next_summary.store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < severities_count; ++i) {
+        auto &state = _states[i];
+        state.limit = other._states[i].limit;
+        state.bucket = other._states[i].bucket;
+        state.seen.store(0, std::memory_order_relaxed);
+        state.suppressed.store(0, std::memory_order_relaxed);
+        _active = _active || state.limit.enabled();
+    }
+    return *this;
+}
+
+bool log_limiter::admit(logger::severity severity, int64_t now) noexcept
+{
+    auto &state = _states[static_cast<size_t>(severity)];
+
+    if (state.limit.sample_every > 1 && state.seen.fetch_add(1, std::memory_order_relaxed) % state.limit.sample_every != 0) {
+        state.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (!state.bucket.try_take(now)) {
+        state.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+bool log_limiter::summary_due(int64_t now) noexcept
+{
+    int64_t next_summary = _next_summary.load(std::memory_order_relaxed);
+    if (now < next_summary) {
+        return false;
+    }
+    int64_t interval = std::chrono::duration_cast<std::chrono::nanoseconds>(_summary_interval).count();
+    return _next_summary.compare_exchange_strong(next_summary, now + interval, std::memory_order_relaxed);
+}
+
+size_t log_limiter::take_suppressed(logger::severity severity) noexcept
+{
+    auto &suppressed = _states[static_cast<size_t>(severity)].suppressed;
+    if (suppressed.load(std::memory_order_relaxed) == 0) {
+        return 0;
+    }
+    return suppressed.exchange(0, std::memory_order_relaxed);
+}
+
+std::array<rate_limit, log_limiter::severities_count> log_limiter::limits() const noexcept
+{
+    std::array<rate_limit, severities_count> limits;
+    for (size_t i = 0; i < severities_count; ++i) {
+        limits[i] = _states[i].limit;
+    }
+    return limits;
+}
+
+std::chrono::milliseconds log_limiter::summary_interval() const noexcept
+{
+    return _summary_interval;
+}
+
+std::string log_limiter::summary(size_t suppressed)
+{
+    return std::to_string(suppressed) + (suppressed == 1 ? " record suppressed" : " records suppressed");
+}
@@ -1,5 +1,32 @@
 #include "../include/logger.h"
-#include <iomanip>
+#include "../include/log_clock.h"
+
+#include <cstring>
+
+bool logger::is_enabled(
+    [[maybe_unused]] logger::severity severity) const noexcept
+{
+    return true;
+}
+
+bool logger::admit(
+    logger::severity severity) const noexcept
+{
+    return is_enabled(severity);
+}
+
+logger const *logger::log_admitted(
+    std::string const &message,
+    logger::severity severity) const noexcept
+{
+    return log(message, severity);
+}
+
+std::string &logger::message_buffer() noexcept
+{
+    thread_local std::string buffer;
+    return buffer;
+}
 
 logger const *logger::trace(
     std::string const &message) const noexcept
@@ -61,10 +88,21 @@ std::string logger::severity_to_string(
 
 std::string logger::current_datetime_to_string() noexcept
 {
-    auto time = std::time(nullptr);
+    return log_clock::calendar_of(log_clock::now().seconds).datetime;
+}
 
-    std::ostringstream result_stream;
-    result_stream << std::put_time(std::localtime(&time), "%d.%m.%Y %H:%M:%S");
+size_t logger::current_datetime_to_chars(
+    char *buffer,
+    size_t fraction_digits) noexcept
+{
+    auto now = log_clock::now();
+    auto &calendar = log_clock::calendar_of(now.seconds);
 
-    return result_stream.str();
+    size_t length = sizeof(calendar.datetime) - 1;
+    memcpy(buffer, calendar.datetime, length);
+    if (fraction_digits != 0) {
+        length += log_clock::format_fraction(buffer + length, now.nanoseconds, fraction_digits);
+    }
+    buffer[length] = '\0';
+    return length;
 }
\ No newline at end of file
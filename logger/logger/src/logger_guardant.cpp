@@ -13,6 +13,13 @@ logger_guardant const *logger_guardant::log_with_guard(
     return this;
 }
 
+bool logger_guardant::is_enabled_with_guard(
+    logger::severity severity) const
+{
+    logger *got_logger = get_logger();
+    return got_logger != nullptr && got_logger->is_enabled(severity);
+}
+
 logger_guardant const *logger_guardant::trace_with_guard(
     std::string const &message) const
 {
@@ -0,0 +1,67 @@
+#include "../include/rate_limit.h"
+
+#include <algorithm>
+#include <chrono>
+
+token_bucket::token_bucket(double rate, size_t burst) noexcept :
+    _empty_at(0),
+    _interval(rate > 0 ? std::max<int64_t>(static_cast<int64_t>(1e9 / rate), 1) : 0),
+    _tolerance(_interval * static_cast<int64_t>(std::max<size_t>(burst, 1) - 1)) {}
+
+token_bucket::token_bucket(token_bucket const &other) noexcept :
+    _empty_at(0), _interval(other._interval), _tolerance(other._tolerance) {}
+
+token_bucket &token_bucket::operator=(token_bucket const &other) noexcept
+{
+    _empty_at.store(0, std::memory_order_relaxed);
+    _interval = other._interval;
+    _tolerance = other._tolerance;
+    return *this;
+}
+
+int64_t token_bucket::now() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool token_bucket::try_take(int64_t now) noexcept
+{
+    if (_interval == 0) {
+        return true;
+    }
+
+    int64_t empty_at = _empty_at.load(std::memory_order_relaxed);
+    while (true) {
+        if (empty_at - now > _tolerance) {
+            return false;
+        }
+        int64_t next = std::max(empty_at, now) + _interval;
+        if (_empty_at.compare_exchange_weak(empty_at, next, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+call_site_limit::call_site_limit(rate_limit limit) noexcept :
+    _bucket(limit.rate, limit.burst), _sample_every(std::max<size_t>(limit.sample_every, 1)), _seen(0), _suppressed(0) {}
+
+bool call_site_limit::admit() noexcept
+{
+    if (_sample_every > 1 && _seen.fetch_add(1, std::memory_order_relaxed) % _sample_every != 0) {
+        _suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (!_bucket.try_take(token_bucket::now())) {
+        _suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+size_t call_site_limit::take_suppressed() noexcept
+{
+    if (_suppressed.load(std::memory_order_relaxed) == 0) {
+        return 0;
+    }
+    return _suppressed.exchange(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,119 @@
+#include "../include/structured_record.h"
+
+#include <charconv>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+
+    struct format_table
+    {
+        std::mutex mutex;
+
+        // deque keeps the strings in place, the index points into them
+        std::deque<std::string> formats{ "{}" };
+
+        std::unordered_map<std::string_view, structured::format_id> ids{ { formats.front(), structured::text_format } };
+    };
+
+    format_table &table()
+    {
+        static format_table instance;
+        return instance;
+    }
+
+    template<typename T>
+    T read_raw(std::string_view arguments, size_t &position)
+    {
+        if (arguments.size() - position < sizeof(T)) {
+            throw std::runtime_error("Malformed structured arguments\n");
+        }
+        T value;
+        memcpy(&value, arguments.data() + position, sizeof(T));
+        position += sizeof(T);
+        return value;
+    }
+
+    void append_argument(std::string &out, std::string_view arguments, size_t &position)
+    {
+        char digits[32];
+        std::to_chars_result result{};
+
+        switch (static_cast<structured::argument_type>(read_raw<uint8_t>(arguments, position))) {
+            case structured::argument_type::signed_integer:
+                result = std::to_chars(digits, digits + sizeof(digits), read_raw<int64_t>(arguments, position));
+                break;
+            case structured::argument_type::unsigned_integer:
+                result = std::to_chars(digits, digits + sizeof(digits), read_raw<uint64_t>(arguments, position));
+                break;
+            case structured::argument_type::floating:
+                result = std::to_chars(digits, digits + sizeof(digits), read_raw<double>(arguments, position));
+                break;
+            case structured::argument_type::boolean:
+                out += read_raw<uint8_t>(arguments, position) != 0 ? "true" : "false";
+                return;
+            case structured::argument_type::string:
+            {
+                auto size = read_raw<uint32_t>(arguments, position);
+                if (arguments.size() - position < size) {
+                    throw std::runtime_error("Malformed structured arguments\n");
+                }
+                out.append(arguments.substr(position, size));
+                position += size;
+                return;
+            }
+            default:
+                throw std::runtime_error("Malformed structured arguments\n");
+        }
+        out.append(digits, result.ptr);
+    }
+
+}
+
+structured::format_id structured::register_format(std::string_view format)
+{
+    auto &formats = table();
+    std::lock_guard<std::mutex> lock(formats.mutex);
+
+    auto found = formats.ids.find(format);
+    if (found != formats.ids.end()) {
+        return found->second;
+    }
+
+    auto id = static_cast<format_id>(formats.formats.size());
+    formats.formats.emplace_back(format);
+    formats.ids.emplace(formats.formats.back(), id);
+    return id;
+}
+
+std::string_view structured::format_of(format_id id)
+{
+    auto &formats = table();
+    std::lock_guard<std::mutex> lock(formats.mutex);
+    return formats.formats.at(id);
+}
+
+void structured::format(std::string &out, std::string_view format, std::string_view arguments)
+{
+    size_t position = 0;
+    size_t left = read_raw<uint8_t>(arguments, position);
+
+    for (size_t i = 0; i < format.size(); ++i) {
+        char symbol = format[i];
+        if ((symbol == '{' || symbol == '}') && i + 1 < format.size() && format[i + 1] == symbol) {
+            out += symbol;
+            ++i;
+            continue;
+        }
+        if (symbol == '{' && i + 1 < format.size() && format[i + 1] == '}' && left != 0) {
+            append_argument(out, arguments, position);
+            --left;
+            ++i;
+            continue;
+        }
+        out += symbol;
+    }
+}
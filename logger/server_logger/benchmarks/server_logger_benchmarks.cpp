@@ -0,0 +1,173 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <mqueue.h>
+
+#include <server_logger.h>
+#include <server_logger_builder.h>
+#include <shm_ring.h>
+
+using benchmark_clock = std::chrono::steady_clock;
+
+constexpr char const *benchmark_queue = "/mp_os_server_logger_benchmark";
+
+// every received message is one send syscall on the logger side
+struct consumer
+{
+    mqd_t queue;
+    std::atomic<bool> done = false;
+    size_t messages = 0;
+    std::thread thread;
+
+    explicit consumer(mqd_t queue) :
+        queue(queue),
+        thread([this]() {
+            std::vector<char> buffer(8192);
+            while (true) {
+                timespec timeout;
+                clock_gettime(CLOCK_REALTIME, &timeout);
+                timeout.tv_nsec += 50'000'000;
+                if (timeout.tv_nsec >= 1'000'000'000) {
+                    timeout.tv_sec += 1;
+                    timeout.tv_nsec -= 1'000'000'000;
+                }
+                if (mq_timedreceive(this->queue, buffer.data(), buffer.size(), nullptr, &timeout) >= 0) {
+                    ++messages;
+                } else if (done.load()) {
+                    break;
+                }
+            }
+        }) {}
+};
+
+void transport_benchmark(
+    std::string const &name,
+    bool framing,
+    std::chrono::microseconds coalescing_window,
+    size_t producers_count,
+    size_t record_size,
+    size_t records_total)
+{
+    mq_unlink(benchmark_queue);
+    struct mq_attr attributes = {};
+    attributes.mq_maxmsg = 10;
+    attributes.mq_msgsize = 8192;
+    mqd_t receiver = mq_open(benchmark_queue, O_CREAT | O_RDONLY, 0644, &attributes);
+    if (receiver == (mqd_t)-1) {
+        std::perror("mq_open");
+        return;
+    }
+
+    consumer reader(receiver);
+
+    server_logger_builder builder;
+    builder.add_file_stream(benchmark_queue, logger::severity::information);
+    if (framing) {
+        builder.set_framing(coalescing_window);
+    }
+
+    std::string record(record_size, 'x');
+    size_t records_per_producer = records_total / producers_count;
+
+    auto start = benchmark_clock::now();
+    logger *logger_instance = builder.build();
+    std::vector<std::thread> producers;
+    for (size_t i = 0; i < producers_count; ++i) {
+        producers.emplace_back([&]() {
+            for (size_t j = 0; j < records_per_producer; ++j) {
+                logger_instance->information(record);
+            }
+        });
+    }
+    for (auto &producer : producers) {
+        producer.join();
+    }
+    delete logger_instance;
+    double seconds = std::chrono::duration<double>(benchmark_clock::now() - start).count();
+
+    reader.done = true;
+    reader.thread.join();
+    mq_close(receiver);
+    mq_unlink(benchmark_queue);
+
+    size_t records = producers_count * records_per_producer;
+    std::printf("%-24s record=%5zu B  threads=%zu  throughput=%10.0f rec/s  sends/record=%7.3f\n",
+        name.c_str(), record_size, producers_count, records / seconds, static_cast<double>(reader.messages) / records);
+}
+
+// every wakeup of the sleeping consumer is the only syscall on the logger side
+void shared_memory_benchmark(
+    size_t producers_count,
+    size_t record_size,
+    size_t records_total)
+{
+    shm_ring::consumer ring(benchmark_queue);
+
+    std::atomic<bool> done = false;
+    std::atomic<size_t> received = 0;
+    std::thread reader([&]() {
+        shm_ring::received_record record;
+        while (true) {
+            if (ring.receive(record, std::chrono::milliseconds(50))) {
+                ++received;
+            } else if (done.load()) {
+                break;
+            }
+        }
+    });
+
+    server_logger_builder builder;
+    builder.add_file_stream(benchmark_queue, logger::severity::information);
+    builder.set_shared_memory(false);
+
+    std::string record(record_size, 'x');
+    size_t records_per_producer = records_total / producers_count;
+    size_t records = producers_count * records_per_producer;
+
+    auto start = benchmark_clock::now();
+    logger *logger_instance = builder.build();
+    std::vector<std::thread> producers;
+    for (size_t i = 0; i < producers_count; ++i) {
+        producers.emplace_back([&]() {
+            for (size_t j = 0; j < records_per_producer; ++j) {
+                logger_instance->information(record);
+            }
+        });
+    }
+    for (auto &producer : producers) {
+        producer.join();
+    }
+    delete logger_instance;
+    while (received < records) {
+        std::this_thread::yield();
+    }
+    double seconds = std::chrono::duration<double>(benchmark_clock::now() - start).count();
+
+    done = true;
+    reader.join();
+
+    std::printf("%-24s record=%5zu B  threads=%zu  throughput=%10.0f rec/s  sends/record=%7.3f\n",
+        "shared memory ring", record_size, producers_count, records / seconds, static_cast<double>(ring.producer_wakeups()) / records);
+}
+
+int main()
+{
+    size_t constexpr records_total = 1 << 16;
+
+    for (size_t record_size : {64, 1024}) {
+        for (size_t producers_count : {1, 4}) {
+            transport_benchmark("packets", false, std::chrono::microseconds(0), producers_count, record_size, records_total);
+            transport_benchmark("frames, no window", true, std::chrono::microseconds(0), producers_count, record_size, records_total);
+            transport_benchmark("frames, 100 us window", true, std::chrono::microseconds(100), producers_count, record_size, records_total);
+            transport_benchmark("frames, 1 ms window", true, std::chrono::microseconds(1000), producers_count, record_size, records_total);
+            shared_memory_benchmark(producers_count, record_size, records_total);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include <log_collector.h>
+
+namespace
+{
+
+    volatile std::sig_atomic_t stop_requested = 0;
+
+    void request_stop(int)
+    {
+        stop_requested = 1;
+    }
+
+    void report(log_collector::statistics const &statistics)
+    {
+        std::fprintf(stderr, "received %llu messages, written %llu records (%llu bytes), dropped %llu, malformed %llu, "
+            "backlog %llu (max %llu), pending %llu\n",
+            static_cast<unsigned long long>(statistics.messages_received),
+            static_cast<unsigned long long>(statistics.records_written),
+            static_cast<unsigned long long>(statistics.bytes_written),
+            static_cast<unsigned long long>(statistics.records_dropped),
+            static_cast<unsigned long long>(statistics.malformed_messages),
+            static_cast<unsigned long long>(statistics.backlog),
+            static_cast<unsigned long long>(statistics.max_backlog),
+            static_cast<unsigned long long>(statistics.pending_records));
+    }
+
+}
+
+// creates the given queues and writes what server_logger sends into them to <output directory>/<queue>.log
+int main(
+    int argc,
+    char *argv[])
+{
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " <output directory> <queue name>..." << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, request_stop);
+    std::signal(SIGTERM, request_stop);
+
+    log_collector collector(argv[1]);
+    for (int i = 2; i < argc; ++i) {
+        collector.add_queue(argv[i]);
+    }
+
+    auto last_report = std::chrono::steady_clock::now();
+    while (stop_requested == 0) {
+        collector.poll(std::chrono::milliseconds(100));
+
+        if (std::chrono::steady_clock::now() - last_report >= std::chrono::seconds(1)) {
+            report(collector.get_statistics());
+            last_report = std::chrono::steady_clock::now();
+        }
+    }
+    report(collector.get_statistics());
+    return 0;
+}
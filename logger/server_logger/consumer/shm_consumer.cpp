@@ -0,0 +1,58 @@
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <logger.h>
+#include <shm_ring.h>
+
+namespace
+{
+
+    volatile std::sig_atomic_t stop_requested = 0;
+
+    char const *severity_names[] = { "TRACE", "DEBUG", "INFORMATION", "WARNING", "ERROR", "CRITICAL" };
+
+    void request_stop(int)
+    {
+        stop_requested = 1;
+    }
+
+}
+
+// prints every record sent by loggers built with set_shared_memory for the given stream
+int main(
+    int argc,
+    char *argv[])
+{
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <stream name, e.g. /my_log> [slots count]" << std::endl;
+        return 1;
+    }
+
+    std::string name = argv[1];
+    if (name[0] != '/') {
+        name = "/" + name;
+    }
+    size_t slots_count = argc > 2 ? std::stoul(argv[2]) : shm_ring::default_slots_count;
+
+    std::signal(SIGINT, request_stop);
+    std::signal(SIGTERM, request_stop);
+
+    shm_ring::consumer consumer(name, slots_count);
+    shm_ring::received_record record;
+    while (stop_requested == 0) {
+        try {
+            if (consumer.receive(record, std::chrono::milliseconds(100))) {
+                std::printf("[%s] pid %d request %llu: %s\n", severity_names[static_cast<int>(record.severity)],
+                    static_cast<int>(record.process_id), static_cast<unsigned long long>(record.request), record.text.c_str());
+            }
+        } catch (std::runtime_error const &error) {
+            // the damaged slot is skipped, the stream goes on
+            std::cerr << error.what();
+        }
+    }
+    std::fflush(stdout);
+    return 0;
+}
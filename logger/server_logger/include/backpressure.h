@@ -0,0 +1,33 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_BACKPRESSURE_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_BACKPRESSURE_H
+
+#include <chrono>
+#include <string>
+
+// block - wait for the consumer as long as it takes (the default);
+// the others never wait on a full queue: messages are kept in a local spool and sent
+// before anything newer, and a record that fits neither is dropped, spilled to a file
+// or, with block_until_deadline, waits for room until the deadline and is dropped after it
+enum class backpressure_policy
+{
+    block,
+    drop,
+    spill,
+    block_until_deadline
+};
+
+struct backpressure
+{
+    backpressure_policy policy = backpressure_policy::block;
+
+    // how long block_until_deadline waits for room
+    std::chrono::milliseconds deadline = std::chrono::milliseconds(0);
+
+    // spilled records are appended to <spill_directory>/<queue name>.spill
+    std::string spill_directory = ".";
+
+    // messages kept locally while the queue is full
+    size_t spool_capacity = 256;
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_BACKPRESSURE_H
@@ -0,0 +1,143 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_LOG_COLLECTOR_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_LOG_COLLECTOR_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <mqueue.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "message_frame.h"
+
+// receiving side of server_logger: owns the queues, drains them with epoll, puts records
+// split over packets or frame chunks back together and appends them to one file per queue;
+// record text is written straight from the received messages
+class log_collector final
+{
+
+public:
+
+    static constexpr size_t default_message_size = 8192;
+
+    struct statistics
+    {
+        uint64_t messages_received = 0;
+        uint64_t records_written = 0;
+        uint64_t bytes_written = 0;
+
+        // records lost half way: their packets stopped coming or arrived without an info packet
+        uint64_t records_dropped = 0;
+
+        // messages that are neither packets nor frames
+        uint64_t malformed_messages = 0;
+
+        // messages waiting in the queues at the last drain and the most ever seen
+        uint64_t backlog = 0;
+        uint64_t max_backlog = 0;
+
+        // records still waiting for their packets
+        uint64_t pending_records = 0;
+    };
+
+private:
+
+    // received message, alive while a pending or unwritten record points into it
+    struct message_buffer
+    {
+        std::unique_ptr<char[]> data;
+        size_t references;
+    };
+
+    struct text_piece
+    {
+        iovec text;
+        size_t buffer;
+    };
+
+    struct pending_record
+    {
+        std::string prefix;
+        size_t packets_left;
+        std::vector<text_piece> pieces;
+    };
+
+    struct source
+    {
+        std::string name;
+        mqd_t descriptor;
+        int file;
+
+        // (pid, request) -> record
+        std::map<std::pair<pid_t, uint64_t>, pending_record> pending;
+
+        // completed records waiting for writev
+        std::deque<std::string> prefixes;
+        std::vector<iovec> batch;
+        std::vector<size_t> batch_buffers;
+    };
+
+private:
+
+    std::string _output_directory;
+
+    size_t _message_size;
+
+    int _epoll;
+
+    std::vector<source> _sources;
+
+    std::vector<message_buffer> _buffers;
+
+    std::vector<size_t> _free_buffers;
+
+    statistics _statistics;
+
+private:
+
+    size_t acquire_buffer();
+
+    void release_buffer(size_t buffer) noexcept;
+
+    void drain(source &queue);
+
+    void parse(source &queue, size_t buffer, size_t size);
+
+    void complete(source &queue, pending_record &record);
+
+    void write_batch(source &queue);
+
+public:
+
+    explicit log_collector(std::string const &output_directory, size_t message_size = default_message_size);
+
+    log_collector(log_collector const &other) = delete;
+
+    log_collector &operator=(log_collector const &other) = delete;
+
+    log_collector(log_collector &&other) noexcept = delete;
+
+    log_collector &operator=(log_collector &&other) noexcept = delete;
+
+    // closes and removes the queues
+    ~log_collector() noexcept;
+
+public:
+
+    // creates the queue loggers send into; records go to <output directory>/<name>.log
+    log_collector *add_queue(std::string const &name);
+
+    // waits up to timeout for messages and writes every record they complete
+    size_t poll(std::chrono::milliseconds timeout);
+
+    [[nodiscard]] statistics const &get_statistics() const noexcept;
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_LOG_COLLECTOR_H
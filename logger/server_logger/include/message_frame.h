@@ -0,0 +1,71 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_MESSAGE_FRAME_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_MESSAGE_FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "../../logger/include/logger.h"
+
+// framed protocol: one message carries a frame header and as many records as fit;
+// the first byte tells frames apart from the per-packet protocol (0 - info, 1 - data)
+namespace message_frame
+{
+
+    constexpr uint8_t frame_kind = 2;
+
+    struct frame_header
+    {
+        uint8_t kind;
+        uint8_t reserved[3];
+        uint32_t records_count;
+    };
+
+    // a record longer than a frame is split into chunks, the last one has last set
+    struct record_header
+    {
+        uint64_t request;
+        int32_t process_id;
+        uint8_t severity;
+        uint8_t last;
+        uint16_t reserved;
+        uint32_t size;
+    };
+
+    // smallest frame that still carries one byte of text
+    constexpr size_t minimal_frame_size = sizeof(frame_header) + sizeof(record_header) + 1;
+
+    struct record_chunk
+    {
+        record_header header;
+        std::string_view text;
+    };
+
+    // walks the records of one received frame without copying them
+    class frame_reader final
+    {
+
+    private:
+
+        char const *_position;
+
+        char const *_end;
+
+        uint32_t _records_left;
+
+    public:
+
+        // throws if the message is not a well formed frame
+        frame_reader(char const *message, size_t size);
+
+    public:
+
+        bool next(record_chunk &chunk);
+
+    };
+
+    [[nodiscard]] bool is_frame(char const *message, size_t size) noexcept;
+
+}
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_MESSAGE_FRAME_H
@@ -1,44 +1,196 @@
 #ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_SERVER_LOGGER_H
 #define MATH_PRACTICE_AND_OPERATING_SYSTEMS_SERVER_LOGGER_H
 
+#include "../../logger/include/configuration_watcher.h"
+#include "../../logger/include/log_limiter.h"
 #include "../../logger/include/logger.h"
+#include "../../logger/include/rcu_pointer.h"
 #include "server_logger_builder.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
 #include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <thread>
+#include <vector>
+
+#include "backpressure.h"
+#include "message_frame.h"
+
+#ifdef __linux__
+    #include <mqueue.h>
+    #include "shm_ring.h"
+#elif __APPLE__
+    #include <mach/mach.h>
+#endif
 
 class server_logger final:
     public logger
 {
-    
+
     friend class server_logger_builder;
 
+private:
+
+    #ifdef _WIN32
+        using queue_descriptor = HANDLE;
+    #elif __linux__
+        using queue_descriptor = mqd_t;
+    #elif __APPLE__
+        using queue_descriptor = mach_port_t;
+    #endif
+
+    // opened queue, shared by every logger sending into it; closed with the last one
+    struct message_queue
+    {
+        std::string name;
+        queue_descriptor descriptor;
+        std::mutex mutex; // keeps packets of one record together
+
+        // largest message the queue accepts
+        size_t message_capacity;
+
+        // records waiting for one send, only used by framing loggers
+        std::vector<char> frame;
+        uint32_t frame_records;
+        std::chrono::steady_clock::time_point deadline;
+
+        // policy of the framing logger that appended last, applied when the frame is sent
+        std::shared_ptr<backpressure const> frame_backpressure;
+
+        // sends a frame once its coalescing window is over
+        std::condition_variable wakeup;
+        bool stopping;
+        std::thread flusher;
+
+        // messages that did not fit into the full queue, sent before anything newer
+        std::deque<std::vector<char>> spool;
+        std::ofstream spill;
+
+        std::atomic<size_t> dropped;
+        std::atomic<size_t> spilled;
+
+        message_queue(std::string const &name, queue_descriptor descriptor, size_t message_capacity);
+
+        ~message_queue() noexcept;
+
+        // the caller holds mutex for all of these
+        void send_locked(char const *message, size_t size) noexcept;
+
+        // false once the queue stays full past the deadline, nullptr waits as long as it takes
+        bool try_send_locked(char const *message, size_t size, timespec const *deadline) noexcept;
+
+        bool drain_spool_locked(timespec const *deadline) noexcept;
+
+        // sends count messages of size bytes laid out one after another, or spools what
+        // does not fit; false if the policy gives the record up
+        bool deliver_locked(char const *messages, size_t count, size_t size, backpressure const &settings) noexcept;
+
+        // spills or drops a record that could not be delivered
+        void reject_locked(std::string_view line, backpressure const &settings) noexcept;
+
+        void append_locked(size_t request, pid_t process_id, logger::severity severity, std::string const &text);
+
+        void flush_frame_locked() noexcept;
+
+        void flusher_loop() noexcept;
+    };
+
+    // where records go; never changed once published, reconfigure() publishes a new one
+    struct routing_table
+    {
+        std::map<std::string, std::pair<std::shared_ptr<message_queue>, std::set<logger::severity>>> queues; // name, (queue, severities)
+
+        #ifdef __linux__
+            // streams served by a shared memory consumer instead of a queue
+            std::map<std::string, std::pair<std::shared_ptr<shm_ring::producer>, std::set<logger::severity>>> rings;
+        #endif
+
+        // bit per severity that has a route
+        uint32_t enabled = 0;
+    };
+
 private:
 
     pid_t _process_id;
 
-    size_t mutable _request;
+    // shared by every instance: queues and rings are shared process-wide, so records from two
+    // loggers of one process must not reuse a (pid, request) reassembly key
+    static std::atomic<size_t> _requests;
 
-    #ifdef _WIN32
-        std::map<std::string, std::pair<HANDLE, std::set<logger::severity>>> _queues; // name, (queue id, severities)
+    // records go out packed into frames instead of fixed size packets
+    bool _framing;
 
-        static std::map<std::string, std::pair<HANDLE, int>> _queues_users; // name, (queue id, number of users)
-    #elif __linux__
+    // how long a frame may wait for more records, 0 - sent at the end of every log call
+    std::chrono::microseconds _coalescing_window;
 
-        std::map<std::string, std::pair<mqd_t, std::set<logger::severity>>> _queues; // name, (queue id, severities)
+    std::shared_ptr<backpressure const> _backpressure;
 
-        static std::map<std::string, std::pair<mqd_t, int>> _queues_users; // name, (queue id, number of users)
-    #elif __APPLE__
+    mutable log_limiter _limiter;
+
+    // streams go through shared memory rings where consumers have set them up
+    bool _shared_memory;
+
+    bool _fallback_to_queue;
+
+    rcu_pointer<routing_table> _routing;
+
+    // copy of enabled of the published table, lets is_enabled() skip entering _routing
+    std::atomic<uint32_t> _enabled;
 
-        std::map<std::string, std::pair<mach_port_t, std::set<logger::severity>>> _queues; // name, (queue id, severities)
+    // serializes reconfigurations, so _enabled always matches the last published table
+    std::mutex _reconfiguration_mutex;
 
-        static std::map<std::string, std::pair<mach_port_t, int>> _queues_users; // name, (queue id, number of users)
+    std::unique_ptr<configuration_watcher> _watcher;
 
+    // configuration path inside the watched file
+    std::string _watched_path;
+
+    // name -> queue, only touched while loggers are built or reconfigured, never by log()
+    static std::map<std::string, std::weak_ptr<message_queue>> _queues_registry;
+
+    static std::mutex _queues_registry_mutex;
+
+    #ifdef __linux__
+        // guarded by _queues_registry_mutex as well
+        static std::map<std::string, std::weak_ptr<shm_ring::producer>> _rings_registry;
+
+        static std::shared_ptr<shm_ring::producer> acquire_ring(std::string const &name);
     #endif
 
-    server_logger(std::map<std::string, std::set<logger::severity>> const logs);
+    server_logger(
+        std::map<std::string, std::set<logger::severity>> const logs,
+        bool framing = false,
+        std::chrono::microseconds coalescing_window = std::chrono::microseconds(0),
+        bool shared_memory = false,
+        bool fallback_to_queue = true,
+        backpressure settings = backpressure(),
+        log_limiter limiter = log_limiter());
+
+    void log_packets(message_queue &queue, std::string const &text, logger::severity severity, size_t request) const noexcept;
+
+    void log_framed(message_queue &queue, std::string const &text, logger::severity severity, size_t request) const noexcept;
+
+    static std::shared_ptr<message_queue> acquire_queue(std::string const &name);
 
-    void close_streams();
+    std::unique_ptr<routing_table> make_routing(std::map<std::string, std::set<logger::severity>> const &logs) const;
+
+    void publish(std::unique_ptr<routing_table> routing);
+
+    // sends a "N records suppressed" line for every severity the limiter suppressed records of
+    void report_suppressed() const noexcept;
+
+protected:
+
+    [[nodiscard]] bool admit(logger::severity severity) const noexcept override;
+
+    logger const *log_admitted(const std::string &message, logger::severity severity) const noexcept override;
 
 public:
 
@@ -56,6 +208,34 @@ public:
 
     [[nodiscard]] logger const *log(const std::string &message, logger::severity severity) const noexcept override;
 
+    using logger::log;
+
+    [[nodiscard]] bool is_enabled(logger::severity severity) const noexcept override;
+
+    // sends frames still waiting for their coalescing window and, waiting up to a second,
+    // the spooled messages
+    void flush() const noexcept;
+
+    // records given up on by the queues and rings of this logger, counted for every logger sharing them
+    [[nodiscard]] size_t dropped_records() const noexcept;
+
+    [[nodiscard]] size_t spilled_records() const noexcept;
+
+    // routes severities anew without rebuilding the logger, loggers holding it need no rewiring;
+    // names are taken as server_logger_builder::add_file_stream takes them, queues both
+    // routings have stay open; throws and keeps the old routes if a queue can't be opened
+    void reconfigure(std::map<std::string, std::set<logger::severity>> const &logs);
+
+    // the same with streams read like server_logger_builder::transform_with_configuration does
+    void reconfigure(std::string const &configuration_file_path, std::string const &configuration_path);
+
+    // reconfigures from the file every time it is saved, until unwatch_configuration(); a file
+    // that can't be read or a queue that can't be opened keeps the routes as they are; copies
+    // of the logger don't watch
+    void watch_configuration(std::string const &configuration_file_path, std::string const &configuration_path);
+
+    void unwatch_configuration() noexcept;
+
 };
 
-#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_SERVER_LOGGER_H
\ No newline at end of file
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_SERVER_LOGGER_H
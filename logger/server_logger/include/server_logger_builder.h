@@ -7,6 +7,7 @@
 #include <unistd.h>
 
 #include "../../logger/include/logger_builder.h"
+#include "backpressure.h"
 #include "server_logger.h"
 
 #ifdef _WIN32
@@ -20,15 +21,32 @@
     #define CONSOLE "/dev/tty"
 #endif
 
+#include <chrono>
 #include <map>
 #include <set>
 #include <utility>
 
 class server_logger_builder final: public logger_builder
 {
-    
+
+    friend class server_logger;
+
     std::map<std::string, std::set<logger::severity>> _logs;
 
+    bool _framing = false;
+
+    std::chrono::microseconds _coalescing_window = std::chrono::microseconds(0);
+
+    bool _shared_memory = false;
+
+    bool _fallback_to_queue = true;
+
+    backpressure _backpressure;
+
+    std::array<rate_limit, log_limiter::severities_count> _rate_limits = {};
+
+    std::chrono::milliseconds _summary_interval = log_limiter::default_summary_interval;
+
 public:
 
     server_logger_builder() = default;
@@ -49,10 +67,30 @@ public:
 
     logger_builder *add_console_stream(logger::severity severity) override;
 
+    // the configuration is either an array of streams [name, [severities]] or
+    // {"streams": [...], "rate_limits": {"trace": {"rate": .., "burst": .., "sample_every": ..}},
+    //  "summary_interval_ms": ..}
     logger_builder* transform_with_configuration(std::string const &configuration_file_path, std::string const &configuration_path) override;
 
     logger_builder *clear() override;
 
+    // packs records into frames as large as the queue allows; a frame waits up to
+    // coalescing_window for more records before it is sent
+    logger_builder *set_framing(std::chrono::microseconds coalescing_window = std::chrono::microseconds(0));
+
+    // sends through the shared memory ring of a consumer listening under the stream name;
+    // a stream without such a consumer uses its queue or, without fallback, fails the build
+    logger_builder *set_shared_memory(bool fallback_to_queue = true);
+
+    // what log does when a queue is full, see backpressure_policy
+    logger_builder *set_backpressure(backpressure settings);
+
+    // token bucket and 1-in-n sampling for records of the severity
+    logger_builder *set_rate_limit(logger::severity severity, rate_limit limit);
+
+    // how often "N records suppressed" lines are sent for rate limited severities
+    logger_builder *set_suppression_summary(std::chrono::milliseconds interval);
+
     [[nodiscard]] logger *build() const override;
 
 };
@@ -0,0 +1,175 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_SHM_RING_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_SHM_RING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+
+#include <sys/types.h>
+
+#include "message_frame.h"
+
+// shared memory transport: a bounded MPSC ring of fixed size slots in a shm_open region;
+// the consumer creates the region, loggers of any process map it and push without syscalls
+// while the consumer keeps up, futex wakeups are only issued to a sleeping side
+namespace shm_ring
+{
+
+    constexpr uint32_t magic = 0x6c6f6773;
+
+    constexpr uint32_t version = 2;
+
+    constexpr size_t slot_size = 256;
+
+    constexpr size_t default_slots_count = 1 << 12;
+
+    // a consumer that has not come for records this long is taken for stopped, producers stop
+    // waiting for room and drop records
+    constexpr std::chrono::milliseconds consumer_stall_timeout = std::chrono::seconds(1);
+
+    // how long a producer waits for room by default: while the consumer is alive
+    constexpr std::chrono::milliseconds wait_forever = std::chrono::milliseconds::max();
+
+    struct slot
+    {
+        std::atomic<uint64_t> sequence;
+        uint32_t size;
+        uint32_t reserved;
+        char data[slot_size - 16]; // record header and a chunk of text, as in a frame
+    };
+
+    struct header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t slots_count;
+
+        alignas(64) std::atomic<uint64_t> enqueue_position;
+
+        alignas(64) std::atomic<uint64_t> dequeue_position;
+
+        // consumer liveness: its process, 0 once it is gone, and when it last came for records
+        // (steady clock milliseconds, the clock is shared by the processes of a host)
+        std::atomic<int32_t> consumer_pid;
+        std::atomic<uint64_t> consumer_heartbeat;
+
+        // futex words: bumped by the side that makes progress, waited on by the other one
+        alignas(64) std::atomic<uint32_t> items_signal;
+        std::atomic<uint32_t> consumer_sleeping;
+        std::atomic<uint32_t> space_signal;
+        std::atomic<uint32_t> producers_waiting;
+
+        // wake syscalls issued by producers
+        std::atomic<uint64_t> producer_wakeups;
+    };
+
+    static_assert(sizeof(slot) == slot_size);
+    static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free);
+
+    // text bytes one slot carries
+    constexpr size_t chunk_capacity = sizeof(slot::data) - sizeof(message_frame::record_header);
+
+    class producer final
+    {
+
+    private:
+
+        header *_header;
+
+        slot *_slots;
+
+        size_t _region_size;
+
+        std::atomic<size_t> _dropped;
+
+    private:
+
+        [[nodiscard]] bool consumer_gone(std::chrono::steady_clock::time_point now) const noexcept;
+
+    public:
+
+        // maps a region created by a consumer, throws if there is none
+        explicit producer(std::string const &name);
+
+        producer(producer const &other) = delete;
+
+        producer &operator=(producer const &other) = delete;
+
+        producer(producer &&other) noexcept = delete;
+
+        producer &operator=(producer &&other) noexcept = delete;
+
+        ~producer() noexcept;
+
+    public:
+
+        // waits up to patience while the ring is full and gives the rest of the record up after it,
+        // or at once when the consumer has exited or stalled; false if the record was dropped
+        bool push(uint64_t request, pid_t process_id, logger::severity severity, std::string const &text,
+                  std::chrono::milliseconds patience = wait_forever) noexcept;
+
+        [[nodiscard]] size_t dropped() const noexcept;
+
+    };
+
+    struct received_record
+    {
+        pid_t process_id;
+        uint64_t request;
+        logger::severity severity;
+        std::string text;
+    };
+
+    class consumer final
+    {
+
+    private:
+
+        std::string _name;
+
+        header *_header;
+
+        slot *_slots;
+
+        size_t _region_size;
+
+        // records whose chunks are still arriving, (process, request) -> text
+        std::map<std::pair<pid_t, uint64_t>, std::string> _partial;
+
+    private:
+
+        bool pop(message_frame::record_chunk &chunk, std::string &storage, std::chrono::milliseconds timeout);
+
+        void wake_producers() noexcept;
+
+    public:
+
+        // creates the region, replacing a stale one left under the same name
+        consumer(std::string const &name, size_t slots_count = default_slots_count);
+
+        consumer(consumer const &other) = delete;
+
+        consumer &operator=(consumer const &other) = delete;
+
+        consumer(consumer &&other) noexcept = delete;
+
+        consumer &operator=(consumer &&other) noexcept = delete;
+
+        ~consumer() noexcept;
+
+    public:
+
+        // waits up to timeout for the next complete record; throws on a slot whose sizes or
+        // severity are out of range, the slot is skipped and the next call goes on after it
+        bool receive(received_record &record, std::chrono::milliseconds timeout);
+
+        [[nodiscard]] uint64_t producer_wakeups() const noexcept;
+
+    };
+
+}
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_SHM_RING_H
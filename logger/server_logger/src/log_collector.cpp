@@ -0,0 +1,321 @@
+#ifdef __linux__
+
+#include "../include/log_collector.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace
+{
+
+    // layout of the per-packet protocol sent by server_logger::log_packets
+    constexpr size_t packet_size = 100;
+    constexpr size_t info_packets_count_offset = sizeof(bool);
+    constexpr size_t info_request_offset = info_packets_count_offset + sizeof(size_t);
+    constexpr size_t info_process_offset = info_request_offset + sizeof(size_t);
+    constexpr size_t info_severity_offset = info_process_offset + sizeof(pid_t);
+    constexpr size_t data_request_offset = sizeof(bool);
+    constexpr size_t data_process_offset = data_request_offset + sizeof(size_t);
+    constexpr size_t data_text_offset = data_process_offset + sizeof(pid_t);
+
+    constexpr size_t drain_budget = 256;
+
+    char const *severity_names[] = { "TRACE", "DEBUG", "INFORMATION", "WARNING", "ERROR", "CRITICAL" };
+
+    template<typename T>
+    T read_at(char const *message, size_t offset)
+    {
+        T value;
+        memcpy(&value, message + offset, sizeof(T));
+        return value;
+    }
+
+    std::string make_prefix(char const *severity, pid_t process_id, uint64_t request)
+    {
+        std::string prefix = "[";
+        prefix += severity;
+        prefix += "] pid ";
+        prefix += std::to_string(process_id);
+        prefix += " request ";
+        prefix += std::to_string(request);
+        prefix += ": ";
+        return prefix;
+    }
+
+    char newline = '\n';
+
+}
+
+log_collector::log_collector(std::string const &output_directory, size_t message_size) :
+    _output_directory(output_directory),
+    _message_size(message_size)
+{
+    if (_message_size < packet_size) {
+        throw std::logic_error("Messages have to fit a packet");
+    }
+
+    _epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (_epoll < 0) {
+        throw std::runtime_error("Error creating epoll");
+    }
+}
+
+log_collector::~log_collector() noexcept
+{
+    for (auto &queue : _sources) {
+        mq_close(queue.descriptor);
+        mq_unlink(queue.name.c_str());
+        close(queue.file);
+    }
+    close(_epoll);
+}
+
+log_collector *log_collector::add_queue(std::string const &name)
+{
+    std::runtime_error opening_queue_error("Error opening queue");
+
+    std::string queue_name = name[0] == '/' ? name : "/" + name;
+
+    struct mq_attr queue_attributes = {};
+    queue_attributes.mq_maxmsg = 10;
+    queue_attributes.mq_msgsize = static_cast<long>(_message_size);
+
+    mq_unlink(queue_name.c_str());
+    mqd_t descriptor = mq_open(queue_name.c_str(), O_CREAT | O_RDONLY | O_NONBLOCK, 0644, &queue_attributes);
+    if (descriptor < 0) throw opening_queue_error;
+
+    std::string file_name = _output_directory + "/" + queue_name.substr(1) + ".log";
+    int file = open(file_name.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (file < 0) {
+        mq_close(descriptor);
+        mq_unlink(queue_name.c_str());
+        throw std::runtime_error("Can't open file\n");
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = _sources.size();
+    if (epoll_ctl(_epoll, EPOLL_CTL_ADD, descriptor, &event) != 0) {
+        mq_close(descriptor);
+        mq_unlink(queue_name.c_str());
+        close(file);
+        throw opening_queue_error;
+    }
+
+    source queue;
+    queue.name = queue_name;
+    queue.descriptor = descriptor;
+    queue.file = file;
+    _sources.push_back(std::move(queue));
+    return this;
+}
+
+size_t log_collector::poll(std::chrono::milliseconds timeout)
+{
+    epoll_event events[64];
+    int ready = epoll_wait(_epoll, events, 64, static_cast<int>(timeout.count()));
+    if (ready < 0) {
+        if (errno == EINTR) {
+            return 0;
+        }
+        throw std::runtime_error("Error waiting for queues");
+    }
+
+    uint64_t written_before = _statistics.records_written;
+    uint64_t backlog = 0;
+    for (int i = 0; i < ready; ++i) {
+        source &queue = _sources[events[i].data.u64];
+
+        struct mq_attr state;
+        if (mq_getattr(queue.descriptor, &state) == 0) {
+            backlog += static_cast<uint64_t>(state.mq_curmsgs);
+        }
+
+        drain(queue);
+        write_batch(queue);
+    }
+
+    _statistics.backlog = backlog;
+    _statistics.max_backlog = std::max(_statistics.max_backlog, backlog);
+
+    uint64_t pending = 0;
+    for (auto &queue : _sources) {
+        pending += queue.pending.size();
+    }
+    _statistics.pending_records = pending;
+
+    return _statistics.records_written - written_before;
+}
+
+log_collector::statistics const &log_collector::get_statistics() const noexcept
+{
+    return _statistics;
+}
+
+size_t log_collector::acquire_buffer()
+{
+    if (!_free_buffers.empty()) {
+        size_t buffer = _free_buffers.back();
+        _free_buffers.pop_back();
+        return buffer;
+    }
+    _buffers.push_back(message_buffer{ std::make_unique<char[]>(_message_size), 0 });
+    return _buffers.size() - 1;
+}
+
+void log_collector::release_buffer(size_t buffer) noexcept
+{
+    if (--_buffers[buffer].references == 0) {
+        _free_buffers.push_back(buffer);
+    }
+}
+
+void log_collector::drain(source &queue)
+{
+    for (size_t i = 0; i < drain_budget; ++i) {
+        size_t buffer = acquire_buffer();
+        _buffers[buffer].references = 1;
+
+        ssize_t size = mq_receive(queue.descriptor, _buffers[buffer].data.get(), _message_size, nullptr);
+        if (size < 0) {
+            release_buffer(buffer);
+            return;
+        }
+
+        ++_statistics.messages_received;
+        parse(queue, buffer, static_cast<size_t>(size));
+
+        // pieces of the message hold their own references
+        release_buffer(buffer);
+    }
+}
+
+void log_collector::parse(source &queue, size_t buffer, size_t size)
+{
+    char *message = _buffers[buffer].data.get();
+
+    if (message_frame::is_frame(message, size)) {
+        try {
+            message_frame::frame_reader reader(message, size);
+            message_frame::record_chunk chunk;
+            while (reader.next(chunk)) {
+                auto key = std::make_pair(static_cast<pid_t>(chunk.header.process_id), chunk.header.request);
+                auto found = queue.pending.find(key);
+                if (found == queue.pending.end()) {
+                    char const *severity = chunk.header.severity < 6 ? severity_names[chunk.header.severity] : "UNKNOWN";
+                    found = queue.pending.emplace(key, pending_record{ make_prefix(severity, key.first, key.second), 0, {} }).first;
+                }
+
+                ++_buffers[buffer].references;
+                found->second.pieces.push_back({ { const_cast<char *>(chunk.text.data()), chunk.text.size() }, buffer });
+
+                if (chunk.header.last) {
+                    complete(queue, found->second);
+                    queue.pending.erase(found);
+                }
+            }
+        } catch (std::runtime_error const &) {
+            ++_statistics.malformed_messages;
+        }
+        return;
+    }
+
+    if (size != packet_size || static_cast<uint8_t>(message[0]) > 1) {
+        ++_statistics.malformed_messages;
+        return;
+    }
+
+    if (message[0] == 0) {
+        // info packet opens a record
+        auto request = static_cast<uint64_t>(read_at<size_t>(message, info_request_offset));
+        auto key = std::make_pair(read_at<pid_t>(message, info_process_offset), request);
+        std::string severity(message + info_severity_offset, strnlen(message + info_severity_offset, packet_size - info_severity_offset));
+
+        auto found = queue.pending.find(key);
+        if (found != queue.pending.end()) {
+            for (auto &piece : found->second.pieces) {
+                release_buffer(piece.buffer);
+            }
+            queue.pending.erase(found);
+            ++_statistics.records_dropped;
+        }
+
+        queue.pending.emplace(key, pending_record{ make_prefix(severity.c_str(), key.first, key.second), read_at<size_t>(message, info_packets_count_offset), {} });
+        return;
+    }
+
+    auto key = std::make_pair(read_at<pid_t>(message, data_process_offset), static_cast<uint64_t>(read_at<size_t>(message, data_request_offset)));
+    auto found = queue.pending.find(key);
+    if (found == queue.pending.end()) {
+        // the info packet is gone, the record can't be put together
+        ++_statistics.records_dropped;
+        return;
+    }
+
+    char *text = message + data_text_offset;
+    ++_buffers[buffer].references;
+    found->second.pieces.push_back({ { text, strnlen(text, packet_size - data_text_offset) }, buffer });
+
+    if (--found->second.packets_left == 0) {
+        complete(queue, found->second);
+        queue.pending.erase(found);
+    }
+}
+
+void log_collector::complete(source &queue, pending_record &record)
+{
+    queue.prefixes.push_back(std::move(record.prefix));
+    queue.batch.push_back({ queue.prefixes.back().data(), queue.prefixes.back().size() });
+    for (auto &piece : record.pieces) {
+        queue.batch.push_back(piece.text);
+        queue.batch_buffers.push_back(piece.buffer);
+    }
+    queue.batch.push_back({ &newline, 1 });
+    ++_statistics.records_written;
+}
+
+void log_collector::write_batch(source &queue)
+{
+    iovec *pieces = queue.batch.data();
+    size_t left = queue.batch.size();
+
+    while (left != 0) {
+        int count = static_cast<int>(std::min<size_t>(left, IOV_MAX));
+        ssize_t written = writev(queue.file, pieces, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        _statistics.bytes_written += static_cast<uint64_t>(written);
+
+        // skipping what is written, a partially written piece is cut
+        size_t bytes = static_cast<size_t>(written);
+        while (count > 0 && bytes >= pieces->iov_len) {
+            bytes -= pieces->iov_len;
+            ++pieces;
+            --count;
+            --left;
+        }
+        if (bytes != 0) {
+            pieces->iov_base = static_cast<char *>(pieces->iov_base) + bytes;
+            pieces->iov_len -= bytes;
+        }
+    }
+
+    for (size_t buffer : queue.batch_buffers) {
+        release_buffer(buffer);
+    }
+    queue.batch.clear();
+    queue.batch_buffers.clear();
+    queue.prefixes.clear();
+}
+
+#endif
@@ -0,0 +1,44 @@
+#include "../include/message_frame.h"
+
+#include <cstring>
+#include <stdexcept>
+
+bool message_frame::is_frame(char const *message, size_t size) noexcept
+{
+    return size >= sizeof(frame_header) && static_cast<uint8_t>(message[0]) == frame_kind;
+}
+
+message_frame::frame_reader::frame_reader(char const *message, size_t size) :
+    _position(message + sizeof(frame_header)),
+    _end(message + size)
+{
+    if (!is_frame(message, size)) {
+        throw std::runtime_error("Not a frame\n");
+    }
+
+    frame_header header;
+    memcpy(&header, message, sizeof(frame_header));
+    _records_left = header.records_count;
+}
+
+bool message_frame::frame_reader::next(record_chunk &chunk)
+{
+    if (_records_left == 0) {
+        return false;
+    }
+
+    if (static_cast<size_t>(_end - _position) < sizeof(record_header)) {
+        throw std::runtime_error("Truncated frame\n");
+    }
+    memcpy(&chunk.header, _position, sizeof(record_header));
+    _position += sizeof(record_header);
+
+    if (static_cast<size_t>(_end - _position) < chunk.header.size) {
+        throw std::runtime_error("Truncated frame\n");
+    }
+    chunk.text = std::string_view(_position, chunk.header.size);
+    _position += chunk.header.size;
+
+    --_records_left;
+    return true;
+}
@@ -2,42 +2,315 @@
 
 #define MESSAGE_SIZE 100
 
-#ifdef __APPLE__
-#include <mach/mach.h>
-#endif
+namespace
+{
+
+    // how long flush and the last logger of a queue wait for spooled messages to go out
+    constexpr auto spool_drain_timeout = std::chrono::seconds(1);
+
+    // absolute CLOCK_REALTIME time for mq_timedsend
+    timespec deadline_after(std::chrono::nanoseconds timeout) noexcept
+    {
+        timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        auto nanoseconds = static_cast<long long>(deadline.tv_nsec) + timeout.count();
+        deadline.tv_sec += static_cast<time_t>(nanoseconds / 1'000'000'000);
+        deadline.tv_nsec = static_cast<long>(nanoseconds % 1'000'000'000);
+        return deadline;
+    }
 
-#ifdef _WIN32
+    // already expired, turns a timed send into a non-blocking one
+    timespec const expired_deadline = { 0, 0 };
 
-std::map<std::string, std::pair<HANDLE, int>> server_logger::_queues_users = std::map<std::string, std::pair<HANDLE, int>>();
+    std::string spill_line(char const *severity, pid_t process_id, size_t request, std::string_view text)
+    {
+        std::string line = "[";
+        line += severity;
+        line += "] pid ";
+        line += std::to_string(process_id);
+        line += " request ";
+        line += std::to_string(request);
+        line += ": ";
+        line += text;
+        line += '\n';
+        return line;
+    }
+
+    char const *severity_names[] = { "TRACE", "DEBUG", "INFORMATION", "WARNING", "ERROR", "CRITICAL" };
+
+    backpressure const default_backpressure;
+
+    #ifdef __linux__
+        // rings have neither a spool nor a spill file: block waits as long as the consumer is
+        // alive, block_until_deadline up to its deadline, drop and spill give a record up at once
+        std::chrono::milliseconds ring_patience(backpressure const &settings) noexcept
+        {
+            switch (settings.policy) {
+                case backpressure_policy::block:
+                    return shm_ring::wait_forever;
+                case backpressure_policy::block_until_deadline:
+                    return settings.deadline;
+                default:
+                    return std::chrono::milliseconds(0);
+            }
+        }
+    #endif
 
-#elif __linux__
+}
 
-std::map<std::string, std::pair<mqd_t, int>> server_logger::_queues_users = std::map<std::string, std::pair<mqd_t, int>>();
+std::map<std::string, std::weak_ptr<server_logger::message_queue>> server_logger::_queues_registry = std::map<std::string, std::weak_ptr<server_logger::message_queue>>();
 
-#elif __APPLE__
+std::mutex server_logger::_queues_registry_mutex;
 
-std::map<std::string, std::pair<mach_port_t, int>> server_logger::_queues_users = std::map<std::string, std::pair<mach_port_t, int>>();
+std::atomic<size_t> server_logger::_requests = 0;
 
+#ifdef __linux__
+    std::map<std::string, std::weak_ptr<shm_ring::producer>> server_logger::_rings_registry = std::map<std::string, std::weak_ptr<shm_ring::producer>>();
 #endif
 
-server_logger::server_logger(std::map<std::string, std::set<logger::severity>> const logs)
+server_logger::message_queue::message_queue(std::string const &name, queue_descriptor descriptor, size_t message_capacity) :
+    name(name),
+    descriptor(descriptor),
+    message_capacity(message_capacity),
+    frame_records(0),
+    deadline(std::chrono::steady_clock::time_point::max()),
+    stopping(false),
+    dropped(0),
+    spilled(0) {}
+
+server_logger::message_queue::~message_queue() noexcept
 {
-    std::runtime_error opening_queue_error("Error opening queue");
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        flush_frame_locked();
+        timespec spool_deadline = deadline_after(spool_drain_timeout);
+        drain_spool_locked(&spool_deadline);
+    }
+    wakeup.notify_one();
+    if (flusher.joinable()) {
+        flusher.join();
+    }
 
     #ifdef _WIN32
-        
-        for (auto &[file, severities] : logs)
-        {
-            if (_queues_users.find(file) == _queues_users.end())
-            {
-                HANDLE pipe = CreateFileA(file.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
-                if (pipe == INVALID_HANDLE_VALUE) throw opening_queue_error;
-                _queues_users[file].first = pipe;
+        CloseHandle(descriptor);
+    #elif __linux__
+        mq_close(descriptor);
+    #elif __APPLE__
+        mach_port_destroy(mach_task_self(), descriptor);
+    #endif
+}
+
+void server_logger::message_queue::send_locked(char const *message, size_t size) noexcept
+{
+    #ifdef _WIN32
+        DWORD bytes_written;
+        WriteFile(descriptor, message, static_cast<DWORD>(size), &bytes_written, nullptr);
+    #elif __linux__
+        mq_send(descriptor, message, size, 0);
+    #elif __APPLE__
+        mach_msg_header_t msg_header;
+        msg_header.msgh_bits = MACH_MSGH_BITS_SET(MACH_MSG_TYPE_COPY_SEND, 0, 0, 0);
+        msg_header.msgh_size = size;
+        msg_header.msgh_remote_port = descriptor;
+        msg_header.msgh_local_port = MACH_PORT_NULL;
+        msg_header.msgh_id = 0;
+
+        mach_msg(&msg_header, MACH_SEND_MSG, size, 0, MACH_PORT_NULL, MACH_MSG_TIMEOUT_NONE, MACH_PORT_NULL);
+    #endif
+}
+
+bool server_logger::message_queue::try_send_locked(char const *message, size_t size, timespec const *deadline) noexcept
+{
+    if (deadline == nullptr) {
+        send_locked(message, size);
+        return true;
+    }
+
+    #ifdef __linux__
+        return mq_timedsend(descriptor, message, size, 0, deadline) == 0;
+    #else
+        // no timed sends here, waiting as long as it takes
+        send_locked(message, size);
+        return true;
+    #endif
+}
+
+bool server_logger::message_queue::drain_spool_locked(timespec const *deadline) noexcept
+{
+    while (!spool.empty()) {
+        if (!try_send_locked(spool.front().data(), spool.front().size(), deadline)) {
+            return false;
+        }
+        spool.pop_front();
+    }
+    return true;
+}
+
+bool server_logger::message_queue::deliver_locked(char const *messages, size_t count, size_t size, backpressure const &settings) noexcept
+{
+    if (settings.policy == backpressure_policy::block) {
+        drain_spool_locked(nullptr);
+        for (size_t i = 0; i < count; ++i) {
+            send_locked(messages + i * size, size);
+        }
+        return true;
+    }
+
+    size_t sent = 0;
+    if (drain_spool_locked(&expired_deadline)) {
+        while (sent < count && try_send_locked(messages + sent * size, size, &expired_deadline)) {
+            ++sent;
+        }
+        if (sent == count) {
+            return true;
+        }
+    }
+
+    if (settings.policy == backpressure_policy::block_until_deadline && spool.size() + count - sent > settings.spool_capacity) {
+        timespec record_deadline = deadline_after(settings.deadline);
+        if (drain_spool_locked(&record_deadline)) {
+            while (sent < count && try_send_locked(messages + sent * size, size, &record_deadline)) {
+                ++sent;
+            }
+            if (sent == count) {
+                return true;
             }
-            _queues_users[file].second++;
-            _queues[file].first = _queues_users[file].first;
-            _queues[file].second = severities;
         }
+    }
+
+    // the rest of the record is spooled whole or not at all
+    if (spool.size() + count - sent > settings.spool_capacity) {
+        return false;
+    }
+    try {
+        for (; sent < count; ++sent) {
+            spool.emplace_back(messages + sent * size, messages + (sent + 1) * size);
+        }
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+void server_logger::message_queue::reject_locked(std::string_view line, backpressure const &settings) noexcept
+{
+    if (settings.policy == backpressure_policy::spill) {
+        if (!spill.is_open()) {
+            std::string path = settings.spill_directory + "/" + (name[0] == '/' ? name.substr(1) : name) + ".spill";
+            spill.open(path, std::ios::app);
+        }
+        if (spill.is_open()) {
+            spill.write(line.data(), static_cast<std::streamsize>(line.size()));
+            spill.flush();
+            ++spilled;
+            return;
+        }
+    }
+    ++dropped;
+}
+
+void server_logger::message_queue::append_locked(size_t request, pid_t process_id, logger::severity severity, std::string const &text)
+{
+    message_frame::record_header header = {};
+    header.request = request;
+    header.process_id = process_id;
+    header.severity = static_cast<uint8_t>(severity);
+
+    size_t written = 0;
+    do {
+        if (frame.empty()) {
+            frame.reserve(message_capacity);
+            frame.resize(sizeof(message_frame::frame_header));
+        }
+
+        // a header without text is useless unless the text is empty, the frame is sent first
+        size_t room = message_capacity - frame.size();
+        if (room < sizeof(message_frame::record_header) + (text.empty() ? 0 : 1)) {
+            flush_frame_locked();
+            continue;
+        }
+
+        size_t chunk = std::min(text.size() - written, room - sizeof(message_frame::record_header));
+        header.size = static_cast<uint32_t>(chunk);
+        header.last = written + chunk == text.size();
+
+        size_t offset = frame.size();
+        frame.resize(offset + sizeof(message_frame::record_header) + chunk);
+        memcpy(frame.data() + offset, &header, sizeof(message_frame::record_header));
+        memcpy(frame.data() + offset + sizeof(message_frame::record_header), text.data() + written, chunk);
+        ++frame_records;
+        written += chunk;
+
+        if (frame.size() + message_frame::minimal_frame_size - sizeof(message_frame::frame_header) > message_capacity) {
+            flush_frame_locked();
+        }
+    } while (written < text.size());
+}
+
+void server_logger::message_queue::flush_frame_locked() noexcept
+{
+    if (frame_records == 0) {
+        return;
+    }
+
+    message_frame::frame_header header = {};
+    header.kind = message_frame::frame_kind;
+    header.records_count = frame_records;
+    memcpy(frame.data(), &header, sizeof(message_frame::frame_header));
+
+    backpressure const &settings = frame_backpressure != nullptr ? *frame_backpressure : default_backpressure;
+    if (!deliver_locked(frame.data(), 1, frame.size(), settings)) {
+        // every chunk is given up as a line of its own
+        try {
+            message_frame::frame_reader reader(frame.data(), frame.size());
+            message_frame::record_chunk chunk;
+            while (reader.next(chunk)) {
+                char const *severity = chunk.header.severity < 6 ? severity_names[chunk.header.severity] : "UNKNOWN";
+                reject_locked(spill_line(severity, chunk.header.process_id, chunk.header.request, chunk.text), settings);
+            }
+        } catch (...) {
+            dropped += frame_records;
+        }
+    }
+    frame.clear();
+    frame_records = 0;
+    deadline = std::chrono::steady_clock::time_point::max();
+}
+
+void server_logger::message_queue::flusher_loop() noexcept
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        if (frame_records == 0) {
+            wakeup.wait(lock);
+        } else if (std::chrono::steady_clock::now() >= deadline) {
+            flush_frame_locked();
+        } else {
+            wakeup.wait_until(lock, deadline);
+        }
+    }
+}
+
+std::shared_ptr<server_logger::message_queue> server_logger::acquire_queue(std::string const &name)
+{
+    std::runtime_error opening_queue_error("Error opening queue");
+
+    std::lock_guard<std::mutex> lock(_queues_registry_mutex);
+
+    auto found = _queues_registry.find(name);
+    if (found != _queues_registry.end()) {
+        if (auto queue = found->second.lock()) {
+            return queue;
+        }
+    }
+
+    size_t message_capacity = MESSAGE_SIZE;
+
+    #ifdef _WIN32
+
+        HANDLE descriptor = CreateFileA(name.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+        if (descriptor == INVALID_HANDLE_VALUE) throw opening_queue_error;
 
     #elif __linux__
 
@@ -45,97 +318,323 @@ server_logger::server_logger(std::map<std::string, std::set<logger::severity>> c
         queue_attributes.mq_maxmsg = 10; // максимальное количество сообщений в очереди
         queue_attributes.mq_msgsize = MESSAGE_SIZE; // максимальная размер сообщения
 
-        for (auto &[file, severities] : logs)
-        {
-            if (_queues_users.find(file) == _queues_users.end())
-            {
-                mqd_t descriptor = mq_open(file.c_str(), O_WRONLY, 0644, &queue_attributes);
-                if (descriptor < 0) throw opening_queue_error;
-                _queues_users[file].first = descriptor;
-            }
-            _queues_users[file].second++;
-            _queues[file].first = _queues_users[file].first;
-            _queues[file].second = severities;
+        mqd_t descriptor = mq_open(name.c_str(), O_WRONLY, 0644, &queue_attributes);
+        if (descriptor < 0) throw opening_queue_error;
+
+        // an existing queue keeps the attributes it was created with
+        if (mq_getattr(descriptor, &queue_attributes) == 0) {
+            message_capacity = static_cast<size_t>(queue_attributes.mq_msgsize);
         }
-        
+
     #elif __APPLE__
 
-        for (auto &[file, severities] : logs)
-        {
-            if (_queues_users.find(file) == _queues_users.end())
-            {
-                mach_port_t port;
-                kern_return_t result = mach_port_allocate(mach_task_self(), MACH_PORT_RIGHT_RECEIVE, &port);
-                if (result != KERN_SUCCESS) throw opening_queue_error;
-                _queues_users[file].first = port;
-            }
-            _queues_users[file].second++;
-            _queues[file].first = _queues_users[file].first;
-            _queues[file].second = severities;
-        }
+        mach_port_t descriptor;
+        kern_return_t result = mach_port_allocate(mach_task_self(), MACH_PORT_RIGHT_RECEIVE, &descriptor);
+        if (result != KERN_SUCCESS) throw opening_queue_error;
 
     #endif
 
-    _request = 0;
+    auto queue = std::make_shared<message_queue>(name, descriptor, message_capacity);
+    _queues_registry[name] = queue;
+
+    // dropping entries whose last logger is gone
+    std::erase_if(_queues_registry, [](auto const &entry) { return entry.second.expired(); });
+    return queue;
+}
+
+#ifdef __linux__
+std::shared_ptr<shm_ring::producer> server_logger::acquire_ring(std::string const &name)
+{
+    std::lock_guard<std::mutex> lock(_queues_registry_mutex);
+
+    auto found = _rings_registry.find(name);
+    if (found != _rings_registry.end()) {
+        if (auto ring = found->second.lock()) {
+            return ring;
+        }
+    }
+
+    auto ring = std::make_shared<shm_ring::producer>(name);
+    _rings_registry[name] = ring;
+
+    std::erase_if(_rings_registry, [](auto const &entry) { return entry.second.expired(); });
+    return ring;
 }
+#endif
 
+server_logger::server_logger(
+    std::map<std::string, std::set<logger::severity>> const logs,
+    bool framing,
+    std::chrono::microseconds coalescing_window,
+    bool shared_memory,
+    bool fallback_to_queue,
+    backpressure settings,
+    log_limiter limiter) :
+        _process_id(getpid()),
+        _framing(framing),
+        _coalescing_window(coalescing_window),
+        _backpressure(std::make_shared<backpressure const>(std::move(settings))),
+        _limiter(limiter),
+        _shared_memory(shared_memory),
+        _fallback_to_queue(fallback_to_queue),
+        _routing(std::make_unique<routing_table>()),
+        _enabled(0)
+{
+    publish(make_routing(logs));
+}
 
 server_logger::server_logger(server_logger const &other) :
-    _queues(other._queues)
+    _process_id(other._process_id),
+    _framing(other._framing),
+    _coalescing_window(other._coalescing_window),
+    _backpressure(other._backpressure),
+    _limiter(other._limiter),
+    _shared_memory(other._shared_memory),
+    _fallback_to_queue(other._fallback_to_queue),
+    _routing(std::make_unique<routing_table>(*other._routing.read())),
+    _enabled(other._enabled.load())
 {
-    for (auto &[key, pair] : _queues_users) pair.second++;
+
 }
 
 server_logger &server_logger::operator=(server_logger const &other)
 {
     if (this == &other) return *this;
-    close_streams();
-    _queues = other._queues;
-    for (auto &[key, pair] : _queues) _queues_users[key].second++;
+    unwatch_configuration();
+    std::lock_guard<std::mutex> lock(_reconfiguration_mutex);
+    _process_id = other._process_id;
+    _framing = other._framing;
+    _coalescing_window = other._coalescing_window;
+    _backpressure = other._backpressure;
+    _limiter = other._limiter;
+    _shared_memory = other._shared_memory;
+    _fallback_to_queue = other._fallback_to_queue;
+    publish(std::make_unique<routing_table>(*other._routing.read()));
     return *this;
 }
 
 server_logger::server_logger(server_logger &&other) noexcept :
-    _queues(std::move(other._queues)) {}
+    _routing(std::make_unique<routing_table>()),
+    _enabled(0)
+{
+    *this = std::move(other);
+}
 
 server_logger &server_logger::operator=(server_logger &&other) noexcept
 {
     if (this == &other) return *this;
-    close_streams();
-    _queues = std::move(other._queues);
+    unwatch_configuration();
+
+    // the watcher thread is bound to the object, so it moves by being restarted here
+    std::string watched_file;
+    std::string watched_path;
+    if (other._watcher != nullptr) {
+        watched_file = other._watcher->file_path();
+        watched_path = other._watched_path;
+        other.unwatch_configuration();
+    }
+
+    std::unique_lock<std::mutex> lock(_reconfiguration_mutex);
+    _process_id = other._process_id;
+    _framing = other._framing;
+    _coalescing_window = other._coalescing_window;
+    _backpressure = other._backpressure;
+    _limiter = other._limiter;
+    _shared_memory = other._shared_memory;
+    _fallback_to_queue = other._fallback_to_queue;
+    try {
+        publish(other._routing.exchange(std::make_unique<routing_table>()));
+    } catch (...) {
+    }
+    other._enabled.store(0, std::memory_order_relaxed);
+    lock.unlock();
+
+    if (!watched_file.empty()) {
+        try {
+            watch_configuration(watched_file, watched_path);
+        } catch (...) {
+        }
+    }
     return *this;
 }
 
-void server_logger::close_streams()
+server_logger::~server_logger() noexcept
 {
-    for (auto & [file, pair] : _queues)
+    unwatch_configuration();
+    report_suppressed();
+}
+
+std::unique_ptr<server_logger::routing_table> server_logger::make_routing(std::map<std::string, std::set<logger::severity>> const &logs) const
+{
+    auto routing = std::make_unique<routing_table>();
+
+    for (auto &[file, severities] : logs)
     {
-        if (--_queues_users[file].second != 0) continue;
-        #ifdef _WIN32
-            ClodeHandle(_queues_users[file].first);
-        #elif __linux__
-            mq_close(_queues_users[file].first);
-        #elif __APPLE__
-            mach_port_destroy(mach_task_self(), _queues_users[file].first);
-        #endif
-        _queues_users.erase(file);
+        for (auto severity : severities) {
+            routing->enabled |= 1u << static_cast<size_t>(severity);
+        }
+
+        // a stream goes through shared memory only if a consumer has set it up
+        if (_shared_memory) {
+            #ifdef __linux__
+                try {
+                    routing->rings[file] = std::make_pair(acquire_ring(file), severities);
+                    continue;
+                } catch (std::runtime_error const &) {
+                    if (!_fallback_to_queue) throw;
+                }
+            #else
+                if (!_fallback_to_queue) throw std::runtime_error("Shared memory transport is not supported");
+            #endif
+        }
 
+        auto queue = acquire_queue(file);
+        if (_framing && queue->message_capacity < message_frame::minimal_frame_size) {
+            throw std::runtime_error("Queue messages are too small for frames");
+        }
+        routing->queues[file].first = queue;
+        routing->queues[file].second = severities;
     }
+    return routing;
 }
 
-server_logger::~server_logger() noexcept
+void server_logger::publish(std::unique_ptr<routing_table> routing)
 {
-    close_streams();
+    uint32_t enabled = routing->enabled;
+
+    // a severity turned off stops first and one turned on starts once its routes are there,
+    // anything in between only finds a severity without routes
+    _enabled.fetch_and(enabled, std::memory_order_release);
+    auto retired = _routing.exchange(std::move(routing));
+    _enabled.store(enabled, std::memory_order_release);
+
+    // frames appended through the old routes don't wait for their window on a queue this
+    // logger may not send to anymore
+    if (_framing) {
+        for (auto &[file, pair] : retired->queues) {
+            std::lock_guard<std::mutex> lock(pair.first->mutex);
+            pair.first->flush_frame_locked();
+        }
+    }
 }
 
+void server_logger::reconfigure(std::map<std::string, std::set<logger::severity>> const &logs)
+{
+    server_logger_builder builder;
+    for (auto &[file, severities] : logs) {
+        for (auto severity : severities) {
+            builder.add_file_stream(file, severity);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_reconfiguration_mutex);
+    publish(make_routing(builder._logs));
+}
+
+void server_logger::reconfigure(std::string const &configuration_file_path, std::string const &configuration_path)
+{
+    server_logger_builder builder;
+    builder.transform_with_configuration(configuration_file_path, configuration_path);
+
+    std::lock_guard<std::mutex> lock(_reconfiguration_mutex);
+    publish(make_routing(builder._logs));
+}
+
+void server_logger::watch_configuration(std::string const &configuration_file_path, std::string const &configuration_path)
+{
+    unwatch_configuration();
+    _watched_path = configuration_path;
+    _watcher = std::make_unique<configuration_watcher>(configuration_file_path, [this, configuration_file_path, configuration_path]() {
+        reconfigure(configuration_file_path, configuration_path);
+    });
+}
+
+void server_logger::unwatch_configuration() noexcept
+{
+    _watcher.reset();
+}
+
+void server_logger::report_suppressed() const noexcept
+{
+    if (!_limiter.active()) {
+        return;
+    }
+    for (size_t i = 0; i < log_limiter::severities_count; ++i) {
+        auto severity = static_cast<logger::severity>(i);
+        size_t suppressed = _limiter.take_suppressed(severity);
+        if (suppressed == 0) {
+            continue;
+        }
+        try {
+            log_admitted(log_limiter::summary(suppressed), severity);
+        } catch (...) {
+        }
+    }
+}
+
+bool server_logger::admit(logger::severity severity) const noexcept
+{
+    if (!is_enabled(severity)) {
+        return false;
+    }
+    if (!_limiter.active()) {
+        return true;
+    }
+
+    int64_t now = token_bucket::now();
+    if (_limiter.summary_due(now)) {
+        report_suppressed();
+    }
+    return _limiter.admit(severity, now);
+}
 
 logger const *server_logger::log(const std::string &text, logger::severity severity) const noexcept
+{
+    if (!admit(severity)) {
+        return this;
+    }
+    return log_admitted(text, severity);
+}
+
+logger const *server_logger::log_admitted(const std::string &text, logger::severity severity) const noexcept
+{
+    // номер запроса уникален для всех логгеров процесса и при логировании из нескольких потоков
+    size_t request = _requests.fetch_add(1, std::memory_order_relaxed);
+    auto routing = _routing.read();
+
+    for (auto & [file, pair] : routing->queues)
+    {
+        if (pair.second.find(severity) == pair.second.end()) continue;
+
+        if (_framing) {
+            log_framed(*pair.first, text, severity, request);
+        } else {
+            log_packets(*pair.first, text, severity, request);
+        }
+    }
+
+    #ifdef __linux__
+        for (auto & [file, pair] : routing->rings)
+        {
+            if (pair.second.find(severity) == pair.second.end()) continue;
+            pair.first->push(request, _process_id, severity, text, ring_patience(*_backpressure));
+        }
+    #endif
+    return this;
+}
+
+bool server_logger::is_enabled(logger::severity severity) const noexcept
+{
+    return (_enabled.load(std::memory_order_relaxed) >> static_cast<size_t>(severity) & 1) != 0;
+}
+
+void server_logger::log_packets(message_queue &queue, std::string const &text, logger::severity severity, size_t request) const noexcept
 {
     size_t meta_size = sizeof(size_t) + sizeof(size_t) + sizeof(pid_t) + sizeof(const char *) + sizeof(bool);
     size_t message_size = MESSAGE_SIZE - meta_size;
     size_t packets_count = text.size() / message_size + 1;
 
-    char info_message[meta_size];
+    char info_message[MESSAGE_SIZE] = {};
     char *ptr;
 
     ptr = info_message;
@@ -143,60 +642,134 @@ logger const *server_logger::log(const std::string &text, logger::severity sever
     ptr += sizeof(bool);
     *reinterpret_cast<size_t*>(ptr) = packets_count;
     ptr += sizeof(size_t);
-    *reinterpret_cast<size_t*>(ptr) = _request;
+    *reinterpret_cast<size_t*>(ptr) = request;
     ptr += sizeof(size_t);
     *reinterpret_cast<pid_t*>(ptr) = _process_id;
     ptr += sizeof(pid_t);
-    char const * severity_string = severity_to_string(severity).c_str();
-    strcpy(ptr, severity_string);
-
-    char message[MESSAGE_SIZE];
+    std::string severity_string = severity_to_string(severity);
+    strncpy(ptr, severity_string.c_str(), info_message + MESSAGE_SIZE - ptr - 1);
+
+    // the whole record is laid out first, so that it is spooled or given up as one piece
+    thread_local std::vector<char> packets;
+    try {
+        packets.resize((packets_count + 1) * MESSAGE_SIZE);
+    } catch (...) {
+        ++queue.dropped;
+        return;
+    }
+    memcpy(packets.data(), info_message, MESSAGE_SIZE);
 
-    for (auto & [file, pair] : _queues)
+    for (size_t i = 0; i < packets_count; ++i)
     {
-        if (pair.second.find(severity) == pair.second.end()) continue;
-
-        // Отправка информационного сообщения
-        #ifdef _WIN32
-            DWORD bytes_written;
-            WriteFile(pair.first, info_message, MESSAGE_SIZE, &bytes_written, nullptr);
-        #elif __linux__
-            mq_send(pair.first, info_message, MESSAGE_SIZE, 0); // отправка инфо сообщения
-        #elif __APPLE__
-            mach_msg_header_t msg_header;
-            msg_header.msgh_bits = MACH_MSGH_BITS_SET(MACH_MSG_TYPE_COPY_SEND, 0, 0, 0);
-            msg_header.msgh_size = sizeof(info_message);
-            msg_header.msgh_remote_port = pair.first;
-            msg_header.msgh_local_port = MACH_PORT_NULL;
-            msg_header.msgh_id = 0;
-
-            mach_msg(&msg_header, MACH_SEND_MSG, sizeof(info_message), 0, MACH_PORT_NULL, MACH_MSG_TIMEOUT_NONE, MACH_PORT_NULL);
-        #endif
-
-        ptr = message;
+        ptr = packets.data() + (i + 1) * MESSAGE_SIZE;
         *reinterpret_cast<bool*>(ptr) = true;
         ptr += sizeof(bool);
-        *reinterpret_cast<size_t*>(ptr) = _request;
+        *reinterpret_cast<size_t*>(ptr) = request;
         ptr += sizeof(size_t);
         *reinterpret_cast<pid_t*>(ptr) = _process_id;
         ptr += sizeof(pid_t);
-        for (size_t i = 0; i < packets_count; ++i)
+
+        size_t pos = i * message_size;
+        size_t rest = text.size() - pos;
+        size_t substr_size = (rest < message_size) ? rest : message_size;
+        memcpy(ptr, text.data() + pos, substr_size);
+        *(ptr + substr_size) = 0;
+    }
+
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    // framed records of other loggers go first to keep the order
+    queue.flush_frame_locked();
+
+    // Отправка инфо сообщения и сообщений с данными
+    if (!queue.deliver_locked(packets.data(), packets_count + 1, MESSAGE_SIZE, *_backpressure)) {
+        try {
+            queue.reject_locked(spill_line(severity_string.c_str(), _process_id, request, text), *_backpressure);
+        } catch (...) {
+            ++queue.dropped;
+        }
+    }
+}
+
+void server_logger::log_framed(message_queue &queue, std::string const &text, logger::severity severity, size_t request) const noexcept
+{
+    std::unique_lock<std::mutex> lock(queue.mutex);
+
+    if (queue.frame_backpressure != _backpressure) {
+        queue.frame_backpressure = _backpressure;
+    }
+
+    try {
+        queue.append_locked(request, _process_id, severity, text);
+    } catch (...) {
+        // no memory for the frame, the record is lost
+        return;
+    }
+
+    if (_coalescing_window.count() == 0) {
+        queue.flush_frame_locked();
+        return;
+    }
+
+    if (queue.frame_records == 0) {
+        return;
+    }
+
+    // the earliest window among the records in the frame wins
+    auto deadline = std::chrono::steady_clock::now() + _coalescing_window;
+    if (deadline < queue.deadline) {
+        queue.deadline = deadline;
+        if (!queue.flusher.joinable()) {
+            try {
+                queue.flusher = std::thread(&message_queue::flusher_loop, &queue);
+            } catch (...) {
+                queue.flush_frame_locked();
+                return;
+            }
+        }
+        lock.unlock();
+        queue.wakeup.notify_one();
+    }
+}
+
+void server_logger::flush() const noexcept
+{
+    report_suppressed();
+
+    auto routing = _routing.read();
+    for (auto & [file, pair] : routing->queues)
+    {
+        std::lock_guard<std::mutex> lock(pair.first->mutex);
+        pair.first->flush_frame_locked();
+        timespec spool_deadline = deadline_after(spool_drain_timeout);
+        pair.first->drain_spool_locked(&spool_deadline);
+    }
+}
+
+size_t server_logger::dropped_records() const noexcept
+{
+    size_t dropped = 0;
+    auto routing = _routing.read();
+    for (auto & [file, pair] : routing->queues)
+    {
+        dropped += pair.first->dropped.load(std::memory_order_relaxed);
+    }
+    #ifdef __linux__
+        for (auto & [file, pair] : routing->rings)
         {
-            size_t pos = i * message_size;
-            size_t rest = text.size() - pos;
-            size_t substr_size = (rest < message_size) ? rest : message_size;
-            memcpy(ptr, text.substr(pos, substr_size).c_str(), substr_size);
-            *(ptr + substr_size) = 0;
-            // Отправка сообщения с данными
-            #ifdef _WIN32
-                WriteFile(pair.first, message, MESSAGE_SIZE, &bytes_written, nullptr);
-            #elif __linux__
-                mq_send(pair.first, message, MESSAGE_SIZE, 0);
-            #elif __APPLE__
-                mach_msg(&msg_header, MACH_SEND_MSG, sizeof(message), 0, MACH_PORT_NULL, MACH_MSG_TIMEOUT_NONE, MACH_PORT_NULL);
-            #endif
+            dropped += pair.first->dropped();
         }
+    #endif
+    return dropped;
+}
+
+size_t server_logger::spilled_records() const noexcept
+{
+    size_t spilled = 0;
+    auto routing = _routing.read();
+    for (auto & [file, pair] : routing->queues)
+    {
+        spilled += pair.first->spilled.load(std::memory_order_relaxed);
     }
-    _request++;
-    return this;
+    return spilled;
 }
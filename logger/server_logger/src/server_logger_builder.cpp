@@ -49,7 +49,16 @@ logger_builder * server_logger_builder::transform_with_configuration(std::string
     std::string string_severity;
     logger::severity logger_severity;
 
-    for (auto & file : configuration[configuration_path]) {
+    auto &node = configuration[configuration_path];
+    auto &files = node.is_object() ? node["streams"] : node;
+    if (node.is_object()) {
+        if (node.contains("rate_limits")) {
+            log_limiter::read_limits(node["rate_limits"], _rate_limits, &string_to_severity);
+        }
+        _summary_interval = std::chrono::milliseconds(node.value("summary_interval_ms", static_cast<int64_t>(_summary_interval.count())));
+    }
+
+    for (auto & file : files) {
         file_name = file[0];
         for (auto & severity : file[1]) {
             string_severity = severity;
@@ -57,6 +66,7 @@ logger_builder * server_logger_builder::transform_with_configuration(std::string
             _logs[file_name].insert(logger_severity);
         }
     }
+    return this;
 }
 
 logger_builder * server_logger_builder::clear()
@@ -66,7 +76,40 @@ logger_builder * server_logger_builder::clear()
     return this;
 }
 
+logger_builder * server_logger_builder::set_framing(std::chrono::microseconds coalescing_window)
+{
+    _framing = true;
+    _coalescing_window = coalescing_window;
+    return this;
+}
+
+logger_builder * server_logger_builder::set_shared_memory(bool fallback_to_queue)
+{
+    _shared_memory = true;
+    _fallback_to_queue = fallback_to_queue;
+    return this;
+}
+
+logger_builder * server_logger_builder::set_backpressure(backpressure settings)
+{
+    _backpressure = std::move(settings);
+    return this;
+}
+
+logger_builder * server_logger_builder::set_rate_limit(logger::severity severity, rate_limit limit)
+{
+    _rate_limits[static_cast<size_t>(severity)] = limit;
+    return this;
+}
+
+logger_builder * server_logger_builder::set_suppression_summary(std::chrono::milliseconds interval)
+{
+    _summary_interval = interval;
+    return this;
+}
+
 logger * server_logger_builder::build() const
 {
-    return new server_logger(_logs);
+    return new server_logger(_logs, _framing, _coalescing_window, _shared_memory, _fallback_to_queue, _backpressure,
+        log_limiter(_rate_limits, _summary_interval));
 }
\ No newline at end of file
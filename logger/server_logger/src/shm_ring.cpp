@@ -0,0 +1,336 @@
+#ifdef __linux__
+
+#include "../include/shm_ring.h"
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#include <csignal>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+
+    void futex_wait(std::atomic<uint32_t> &word, uint32_t expected, std::chrono::nanoseconds timeout) noexcept
+    {
+        timespec relative;
+        relative.tv_sec = static_cast<time_t>(timeout.count() / 1'000'000'000);
+        relative.tv_nsec = static_cast<long>(timeout.count() % 1'000'000'000);
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, expected, &relative, nullptr, 0);
+    }
+
+    void futex_wake(std::atomic<uint32_t> &word, int count) noexcept
+    {
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, count, nullptr, nullptr, 0);
+    }
+
+    constexpr size_t spin_iterations = 1 << 7;
+
+    constexpr size_t yield_iterations = 1 << 4;
+
+    size_t region_size(size_t slots_count)
+    {
+        return sizeof(shm_ring::header) + slots_count * sizeof(shm_ring::slot);
+    }
+
+    uint64_t heartbeat_of(std::chrono::steady_clock::time_point time) noexcept
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count());
+    }
+
+}
+
+shm_ring::producer::producer(std::string const &name) :
+    _dropped(0)
+{
+    std::runtime_error opening_region_error("Error opening shared memory");
+
+    int descriptor = shm_open(name.c_str(), O_RDWR, 0);
+    if (descriptor < 0) throw opening_region_error;
+
+    struct stat status;
+    if (fstat(descriptor, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(header)) {
+        close(descriptor);
+        throw opening_region_error;
+    }
+
+    _region_size = static_cast<size_t>(status.st_size);
+    void *region = mmap(nullptr, _region_size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+    if (region == MAP_FAILED) throw opening_region_error;
+
+    _header = static_cast<header *>(region);
+    _slots = reinterpret_cast<slot *>(static_cast<char *>(region) + sizeof(header));
+
+    if (_header->magic != magic || _header->version != version || region_size(_header->slots_count) != _region_size) {
+        munmap(region, _region_size);
+        throw std::runtime_error("Incompatible shared memory layout");
+    }
+}
+
+shm_ring::producer::~producer() noexcept
+{
+    munmap(_header, _region_size);
+}
+
+bool shm_ring::producer::consumer_gone(std::chrono::steady_clock::time_point now) const noexcept
+{
+    pid_t consumer_pid = _header->consumer_pid.load(std::memory_order_acquire);
+    if (consumer_pid == 0 || (kill(consumer_pid, 0) == -1 && errno == ESRCH)) {
+        return true;
+    }
+    return heartbeat_of(now) > _header->consumer_heartbeat.load(std::memory_order_relaxed) + consumer_stall_timeout.count();
+}
+
+bool shm_ring::producer::push(uint64_t request, pid_t process_id, logger::severity severity, std::string const &text, std::chrono::milliseconds patience) noexcept
+{
+    uint64_t mask = _header->slots_count - 1;
+
+    // the wait for room is bounded per record, the clock is only read once the ring is full
+    bool waited = false;
+    std::chrono::steady_clock::time_point give_up;
+
+    message_frame::record_header record = {};
+    record.request = request;
+    record.process_id = process_id;
+    record.severity = static_cast<uint8_t>(severity);
+
+    size_t written = 0;
+    do {
+        uint64_t position = _header->enqueue_position.load(std::memory_order_relaxed);
+        size_t full_checks = 0;
+        slot *target;
+        while (true) {
+            target = &_slots[position & mask];
+            uint64_t sequence = target->sequence.load(std::memory_order_acquire);
+            int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+
+            if (difference == 0) {
+                if (_header->enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                // full: let the consumer run, then sleep until it frees a batch of slots,
+                // rechecking now and then in case it is gone
+                if (++full_checks < yield_iterations) {
+                    std::this_thread::yield();
+                    position = _header->enqueue_position.load(std::memory_order_relaxed);
+                    continue;
+                }
+                auto now = std::chrono::steady_clock::now();
+                if (!waited) {
+                    waited = true;
+                    give_up = patience == wait_forever ? std::chrono::steady_clock::time_point::max() : now + patience;
+                }
+                if (now >= give_up || consumer_gone(now)) {
+                    // chunks already in the ring stay an unfinished record the consumer never completes
+                    _dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                uint32_t signal = _header->space_signal.load(std::memory_order_relaxed);
+                _header->producers_waiting.fetch_add(1, std::memory_order_seq_cst);
+                if (target->sequence.load(std::memory_order_seq_cst) == sequence) {
+                    futex_wait(_header->space_signal, signal, std::chrono::milliseconds(10));
+                }
+                _header->producers_waiting.fetch_sub(1, std::memory_order_relaxed);
+                position = _header->enqueue_position.load(std::memory_order_relaxed);
+            } else {
+                position = _header->enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+
+        size_t chunk = std::min(text.size() - written, chunk_capacity);
+        record.size = static_cast<uint32_t>(chunk);
+        record.last = written + chunk == text.size();
+        memcpy(target->data, &record, sizeof(record));
+        memcpy(target->data + sizeof(record), text.data() + written, chunk);
+        target->size = static_cast<uint32_t>(sizeof(record) + chunk);
+        written += chunk;
+
+        target->sequence.store(position + 1, std::memory_order_release);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_header->consumer_sleeping.load(std::memory_order_relaxed) != 0) {
+            _header->items_signal.fetch_add(1, std::memory_order_relaxed);
+            _header->producer_wakeups.fetch_add(1, std::memory_order_relaxed);
+            futex_wake(_header->items_signal, 1);
+        }
+    } while (written < text.size());
+    return true;
+}
+
+size_t shm_ring::producer::dropped() const noexcept
+{
+    return _dropped.load(std::memory_order_relaxed);
+}
+
+shm_ring::consumer::consumer(std::string const &name, size_t slots_count) :
+    _name(name)
+{
+    if (slots_count < 4 || (slots_count & (slots_count - 1)) != 0) {
+        throw std::logic_error("Slots count must be a power of 2, at least 4");
+    }
+
+    std::runtime_error creating_region_error("Error creating shared memory");
+
+    shm_unlink(name.c_str());
+    int descriptor = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (descriptor < 0) throw creating_region_error;
+
+    _region_size = region_size(slots_count);
+    if (ftruncate(descriptor, static_cast<off_t>(_region_size)) != 0) {
+        close(descriptor);
+        shm_unlink(name.c_str());
+        throw creating_region_error;
+    }
+
+    void *region = mmap(nullptr, _region_size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+    if (region == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        throw creating_region_error;
+    }
+
+    // the region is zero filled, the layout is built in place before anyone can see a valid magic
+    _header = new (region) header();
+    _header->slots_count = slots_count;
+    _header->version = version;
+    _header->consumer_pid.store(getpid(), std::memory_order_relaxed);
+    _header->consumer_heartbeat.store(heartbeat_of(std::chrono::steady_clock::now()), std::memory_order_relaxed);
+    _slots = reinterpret_cast<slot *>(static_cast<char *>(region) + sizeof(header));
+    for (size_t i = 0; i < slots_count; ++i) {
+        new (&_slots[i]) slot();
+        _slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    _header->magic = magic;
+}
+
+shm_ring::consumer::~consumer() noexcept
+{
+    // producers still mapping the region stop waiting for room
+    _header->consumer_pid.store(0, std::memory_order_release);
+    wake_producers();
+    shm_unlink(_name.c_str());
+    munmap(_header, _region_size);
+}
+
+bool shm_ring::consumer::pop(message_frame::record_chunk &chunk, std::string &storage, std::chrono::milliseconds timeout)
+{
+    _header->consumer_heartbeat.store(heartbeat_of(std::chrono::steady_clock::now()), std::memory_order_relaxed);
+
+    uint64_t position = _header->dequeue_position.load(std::memory_order_relaxed);
+    slot &source = _slots[position & (_header->slots_count - 1)];
+
+    // a busy consumer spins and then yields a little before it sleeps, so producers rarely
+    // have to wake it; yielding also lets producers sharing its core fill the ring
+    for (size_t i = 0; i < spin_iterations + yield_iterations && source.sequence.load(std::memory_order_acquire) != position + 1; ++i) {
+        if (i < spin_iterations) {
+            #if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+            #endif
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    if (source.sequence.load(std::memory_order_acquire) != position + 1) {
+        wake_producers();
+        uint32_t signal = _header->items_signal.load(std::memory_order_relaxed);
+        _header->consumer_sleeping.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (source.sequence.load(std::memory_order_acquire) != position + 1) {
+            futex_wait(_header->items_signal, signal, timeout);
+        }
+        _header->consumer_sleeping.store(0, std::memory_order_relaxed);
+        if (source.sequence.load(std::memory_order_acquire) != position + 1) {
+            return false;
+        }
+    }
+
+    // any process mapping the region can write the sizes, they are checked the way frames are
+    uint32_t size = source.size;
+    bool intact = size >= sizeof(message_frame::record_header) && size <= sizeof(slot::data);
+    if (intact) {
+        storage.assign(source.data, size);
+        memcpy(&chunk.header, storage.data(), sizeof(message_frame::record_header));
+        intact = chunk.header.size <= size - sizeof(message_frame::record_header)
+            && chunk.header.severity <= static_cast<uint8_t>(logger::severity::critical);
+    }
+
+    // a damaged slot is released all the same, so the ring keeps moving past it
+    source.sequence.store(position + _header->slots_count, std::memory_order_release);
+    _header->dequeue_position.store(position + 1, std::memory_order_relaxed);
+
+    // waiting producers are woken once a quarter of the ring is free, not for every slot
+    if (((position + 1) & ((_header->slots_count >> 2) - 1)) == 0) {
+        wake_producers();
+    }
+
+    if (!intact) {
+        throw std::runtime_error("Damaged shared memory slot\n");
+    }
+    chunk.text = std::string_view(storage.data() + sizeof(message_frame::record_header), chunk.header.size);
+    return true;
+}
+
+void shm_ring::consumer::wake_producers() noexcept
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_header->producers_waiting.load(std::memory_order_relaxed) != 0) {
+        _header->space_signal.fetch_add(1, std::memory_order_relaxed);
+        futex_wake(_header->space_signal, INT32_MAX);
+    }
+}
+
+bool shm_ring::consumer::receive(received_record &record, std::chrono::milliseconds timeout)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    message_frame::record_chunk chunk;
+    std::string storage;
+
+    while (true) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (!pop(chunk, storage, std::max(left, std::chrono::milliseconds(0)))) {
+            // a wakeup may come before the chunk is published
+            if (left.count() <= 0) {
+                return false;
+            }
+            continue;
+        }
+
+        auto key = std::make_pair(static_cast<pid_t>(chunk.header.process_id), chunk.header.request);
+        if (!chunk.header.last) {
+            _partial[key].append(chunk.text);
+            continue;
+        }
+
+        auto found = _partial.find(key);
+        if (found != _partial.end()) {
+            record.text = std::move(found->second);
+            record.text.append(chunk.text);
+            _partial.erase(found);
+        } else {
+            record.text.assign(chunk.text);
+        }
+        record.process_id = key.first;
+        record.request = key.second;
+        record.severity = static_cast<logger::severity>(chunk.header.severity);
+        return true;
+    }
+}
+
+uint64_t shm_ring::consumer::producer_wakeups() const noexcept
+{
+    return _header->producer_wakeups.load(std::memory_order_relaxed);
+}
+
+#endif
@@ -4,6 +4,15 @@
 #include <unistd.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <mqueue.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <shm_ring.h>
+#include <log_collector.h>
+#include <atomic>
+#include <filesystem>
+#include <thread>
+#include <vector>
 
 #define MESSAGE_SIZE 100
 
@@ -54,6 +63,544 @@ TEST(ServerLoggerTest, Log) {
     std::remove(socket_path.c_str());
 }
 
+TEST(ServerLoggerTest, ConcurrentLoggersShareQueue) {
+    std::string queue_name = "/mp_os_server_logger_stress";
+    mq_unlink(queue_name.c_str());
+
+    struct mq_attr attributes = {};
+    attributes.mq_maxmsg = 10;
+    attributes.mq_msgsize = MESSAGE_SIZE;
+    mqd_t receiver = mq_open(queue_name.c_str(), O_CREAT | O_RDONLY, 0644, &attributes);
+    ASSERT_NE(receiver, (mqd_t)-1) << "Failed to create queue";
+
+    constexpr int threads_count = 4;
+    constexpr int records_count = 200;
+
+    // every short record is one info packet followed by one data packet
+    size_t received = 0;
+    size_t info_packets = 0;
+    std::thread reader([&]() {
+        char buffer[MESSAGE_SIZE];
+        while (received < 2 * threads_count * records_count) {
+            if (mq_receive(receiver, buffer, MESSAGE_SIZE, nullptr) == MESSAGE_SIZE) {
+                if (!*reinterpret_cast<bool *>(buffer)) {
+                    info_packets++;
+                }
+                received++;
+            }
+        }
+    });
+
+    server_logger_builder builder;
+    builder.add_file_stream(queue_name, logger::severity::information);
+    logger *keeper = builder.build();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threads_count; ++t) {
+        threads.emplace_back([&builder, keeper]() {
+            for (int i = 0; i < records_count; ++i) {
+                if (i % 2 == 0) {
+                    keeper->information("shared");
+                    continue;
+                }
+                logger *built = builder.build();
+                built->information("own");
+                delete built;
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    reader.join();
+    delete keeper;
+
+    ASSERT_EQ(info_packets, threads_count * records_count);
+
+    mq_close(receiver);
+    mq_unlink(queue_name.c_str());
+}
+
+TEST(ServerLoggerTest, FramesPackAndSplitRecords) {
+    std::string queue_name = "/mp_os_server_logger_frames";
+    mq_unlink(queue_name.c_str());
+
+    struct mq_attr attributes = {};
+    attributes.mq_maxmsg = 10;
+    attributes.mq_msgsize = 256;
+    mqd_t receiver = mq_open(queue_name.c_str(), O_CREAT | O_RDONLY, 0644, &attributes);
+    ASSERT_NE(receiver, (mqd_t)-1) << "Failed to create queue";
+
+    server_logger_builder builder;
+    builder.add_file_stream(queue_name, logger::severity::information);
+    builder.set_framing(std::chrono::seconds(10));
+    logger *logger_instance = builder.build();
+
+    std::string long_text(600, 'x');
+    logger_instance->information("first");
+    logger_instance->information("second");
+    logger_instance->information(long_text);
+    logger_instance->information("third");
+    dynamic_cast<server_logger *>(logger_instance)->flush();
+
+    std::vector<std::string> texts;
+    std::string pending;
+    size_t messages = 0;
+    char buffer[256];
+    struct mq_attr state;
+    while (mq_getattr(receiver, &state) == 0 && state.mq_curmsgs > 0) {
+        ssize_t size = mq_receive(receiver, buffer, sizeof(buffer), nullptr);
+        ASSERT_GT(size, 0);
+        ASSERT_TRUE(message_frame::is_frame(buffer, size));
+        ++messages;
+
+        message_frame::frame_reader reader(buffer, size);
+        message_frame::record_chunk chunk;
+        while (reader.next(chunk)) {
+            ASSERT_EQ(chunk.header.severity, static_cast<uint8_t>(logger::severity::information));
+            pending.append(chunk.text);
+            if (chunk.header.last) {
+                texts.push_back(pending);
+                pending.clear();
+            }
+        }
+    }
+    delete logger_instance;
+
+    // the short records ride along with the 600 bytes spread over three frames,
+    // the third one has no room left for the last record
+    ASSERT_EQ(messages, 4);
+    ASSERT_EQ(texts, (std::vector<std::string>{"first", "second", long_text, "third"}));
+
+    mq_close(receiver);
+    mq_unlink(queue_name.c_str());
+}
+
+TEST(ServerLoggerTest, SharedMemoryRingDeliversRecords) {
+    std::string ring_name = "/mp_os_server_logger_ring";
+    shm_ring::consumer consumer(ring_name, 64);
+
+    server_logger_builder builder;
+    builder.add_file_stream(ring_name, logger::severity::information);
+    builder.set_shared_memory(false);
+    logger *logger_instance = builder.build();
+
+    constexpr int threads_count = 4;
+    constexpr int records_count = 500;
+    std::string long_text(1000, 'y');
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threads_count; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < records_count; ++i) {
+                logger_instance->information(i % 50 == 0 ? long_text : "thread " + std::to_string(t));
+                logger_instance->debug("filtered out");
+            }
+        });
+    }
+
+    // the ring holds 64 slots, producers have to wait for the consumer
+    size_t received = 0;
+    size_t long_records = 0;
+    shm_ring::received_record record;
+    while (received < threads_count * records_count && consumer.receive(record, std::chrono::seconds(5))) {
+        ASSERT_EQ(record.severity, logger::severity::information);
+        ASSERT_EQ(record.process_id, getpid());
+        if (record.text == long_text) {
+            ++long_records;
+        }
+        ++received;
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    delete logger_instance;
+
+    ASSERT_EQ(received, threads_count * records_count);
+    ASSERT_EQ(long_records, threads_count * records_count / 50);
+}
+
+TEST(ServerLoggerTest, SharedMemoryRingKeepsRecordsOfTwoLoggersApart) {
+    std::string ring_name = "/mp_os_server_logger_two_loggers_ring";
+    shm_ring::consumer consumer(ring_name, 64);
+
+    server_logger_builder builder;
+    builder.add_file_stream(ring_name, logger::severity::information);
+    builder.set_shared_memory(false);
+    logger *first = builder.build();
+    logger *second = builder.build();
+
+    // records span several slots, so both loggers' chunks interleave in the shared ring
+    constexpr int records_count = 300;
+    std::string first_text(1000, 'a');
+    std::string second_text(1000, 'b');
+
+    std::thread first_thread([&]() {
+        for (int i = 0; i < records_count; ++i) {
+            first->information(first_text);
+        }
+    });
+    std::thread second_thread([&]() {
+        for (int i = 0; i < records_count; ++i) {
+            second->information(second_text);
+        }
+    });
+
+    // the ring is drained to the end either way, producers would wait for free slots forever otherwise
+    size_t first_records = 0;
+    size_t second_records = 0;
+    size_t mixed_records = 0;
+    shm_ring::received_record record;
+    while (first_records + second_records + mixed_records < 2 * records_count && consumer.receive(record, std::chrono::seconds(5))) {
+        if (record.text == first_text) {
+            ++first_records;
+        } else if (record.text == second_text) {
+            ++second_records;
+        } else {
+            ++mixed_records;
+        }
+    }
+    first_thread.join();
+    second_thread.join();
+    delete first;
+    delete second;
+
+    ASSERT_EQ(mixed_records, 0);
+    ASSERT_EQ(first_records, records_count);
+    ASSERT_EQ(second_records, records_count);
+}
+
+TEST(ServerLoggerTest, SharedMemoryRingDropsForStalledConsumer) {
+    std::string ring_name = "/mp_os_server_logger_stalled_ring";
+    std::string long_text(1000, 'z');
+
+    // the consumer never comes for records, blocking producers give up once it counts as stalled
+    {
+        shm_ring::consumer consumer(ring_name, 16);
+
+        server_logger_builder builder;
+        builder.add_file_stream(ring_name, logger::severity::information);
+        builder.set_shared_memory(false);
+        auto *logger_instance = dynamic_cast<server_logger *>(builder.build());
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 20; ++i) {
+            logger_instance->information(long_text);
+        }
+        EXPECT_LT(std::chrono::steady_clock::now() - start, shm_ring::consumer_stall_timeout * 3);
+        EXPECT_GT(logger_instance->dropped_records(), 0);
+
+        delete logger_instance;
+    }
+
+    // a drop policy does not wait for a live consumer either
+    {
+        shm_ring::consumer consumer(ring_name, 16);
+
+        backpressure settings;
+        settings.policy = backpressure_policy::drop;
+
+        server_logger_builder builder;
+        builder.add_file_stream(ring_name, logger::severity::information);
+        builder.set_shared_memory(false);
+        builder.set_backpressure(settings);
+        auto *logger_instance = dynamic_cast<server_logger *>(builder.build());
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 20; ++i) {
+            logger_instance->information(long_text);
+        }
+        EXPECT_LT(std::chrono::steady_clock::now() - start, shm_ring::consumer_stall_timeout);
+        EXPECT_GT(logger_instance->dropped_records(), 0);
+
+        delete logger_instance;
+    }
+}
+
+TEST(ServerLoggerTest, SharedMemoryRingSkipsDamagedSlots) {
+    std::string ring_name = "/mp_os_server_logger_damaged_ring";
+    constexpr size_t slots_count = 16;
+    shm_ring::consumer consumer(ring_name, slots_count);
+
+    // a foreign writer publishes two slots whose sizes point past their data
+    int descriptor = shm_open(ring_name.c_str(), O_RDWR, 0);
+    ASSERT_GE(descriptor, 0);
+    size_t region_size = sizeof(shm_ring::header) + slots_count * sizeof(shm_ring::slot);
+    void *region = mmap(nullptr, region_size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+    ASSERT_NE(region, MAP_FAILED);
+    auto *header = static_cast<shm_ring::header *>(region);
+    auto *slots = reinterpret_cast<shm_ring::slot *>(static_cast<char *>(region) + sizeof(shm_ring::header));
+
+    slots[0].size = 1 << 20;
+    message_frame::record_header record_header = {};
+    record_header.size = 1000;
+    record_header.last = 1;
+    memcpy(slots[1].data, &record_header, sizeof(record_header));
+    slots[1].size = sizeof(record_header) + 10;
+    header->enqueue_position.store(2);
+    slots[0].sequence.store(1, std::memory_order_release);
+    slots[1].sequence.store(2, std::memory_order_release);
+    munmap(region, region_size);
+
+    shm_ring::received_record record;
+    EXPECT_THROW(consumer.receive(record, std::chrono::milliseconds(100)), std::runtime_error);
+    EXPECT_THROW(consumer.receive(record, std::chrono::milliseconds(100)), std::runtime_error);
+
+    // the ring goes on past them
+    server_logger_builder builder;
+    builder.add_file_stream(ring_name, logger::severity::information);
+    builder.set_shared_memory(false);
+    logger *logger_instance = builder.build();
+    logger_instance->information("after damage");
+
+    ASSERT_TRUE(consumer.receive(record, std::chrono::seconds(5)));
+    EXPECT_EQ(record.text, "after damage");
+
+    delete logger_instance;
+}
+
+TEST(ServerLoggerTest, SharedMemoryWithoutConsumer) {
+    server_logger_builder builder;
+    builder.add_file_stream("/mp_os_server_logger_no_consumer", logger::severity::information);
+    builder.set_shared_memory(false);
+    ASSERT_THROW(delete builder.build(), std::runtime_error);
+}
+
+TEST(ServerLoggerTest, CollectorReassemblesPacketsAndFrames) {
+    std::string directory = std::filesystem::temp_directory_path() / "mp_os_collector_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    log_collector collector(directory);
+    collector.add_queue("mp_os_collector_packets")->add_queue("mp_os_collector_frames");
+
+    std::atomic<bool> stop = false;
+    std::thread collecting([&]() {
+        while (!stop) {
+            collector.poll(std::chrono::milliseconds(10));
+        }
+    });
+
+    constexpr int threads_count = 3;
+    constexpr int records_count = 200;
+    std::string long_text(300, 'z');
+
+    server_logger_builder packets_builder;
+    packets_builder.add_file_stream("mp_os_collector_packets", logger::severity::information);
+    server_logger_builder frames_builder;
+    frames_builder.add_file_stream("mp_os_collector_frames", logger::severity::information);
+    frames_builder.set_framing(std::chrono::microseconds(200));
+
+    {
+        logger *packets_logger = packets_builder.build();
+        logger *frames_logger = frames_builder.build();
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threads_count; ++t) {
+            threads.emplace_back([&]() {
+                for (int i = 0; i < records_count; ++i) {
+                    packets_logger->information(i % 10 == 0 ? long_text : "short");
+                    frames_logger->information(i % 10 == 0 ? long_text : "short");
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        delete packets_logger;
+        delete frames_logger;
+    }
+
+    while (collector.get_statistics().records_written < 2 * threads_count * records_count) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    stop = true;
+    collecting.join();
+
+    for (auto const &file : {"mp_os_collector_packets.log", "mp_os_collector_frames.log"}) {
+        std::ifstream log(directory + "/" + file);
+        std::string line;
+        size_t lines = 0;
+        size_t long_lines = 0;
+        while (std::getline(log, line)) {
+            ASSERT_EQ(line.rfind("[INFORMATION] pid " + std::to_string(getpid()), 0), 0);
+            if (line.ends_with(": " + long_text)) {
+                ++long_lines;
+            } else {
+                ASSERT_TRUE(line.ends_with(": short"));
+            }
+            ++lines;
+        }
+        ASSERT_EQ(lines, threads_count * records_count);
+        ASSERT_EQ(long_lines, threads_count * records_count / 10);
+    }
+
+    ASSERT_EQ(collector.get_statistics().records_dropped, 0);
+    ASSERT_EQ(collector.get_statistics().malformed_messages, 0);
+    std::filesystem::remove_all(directory);
+}
+
+namespace
+{
+
+    mqd_t create_unread_queue(std::string const &name)
+    {
+        mq_unlink(name.c_str());
+        struct mq_attr attributes = {};
+        attributes.mq_maxmsg = 10;
+        attributes.mq_msgsize = MESSAGE_SIZE;
+        return mq_open(name.c_str(), O_CREAT | O_RDONLY | O_NONBLOCK, 0644, &attributes);
+    }
+
+    size_t drain_queue(mqd_t queue)
+    {
+        char buffer[MESSAGE_SIZE];
+        size_t messages = 0;
+        while (mq_receive(queue, buffer, MESSAGE_SIZE, nullptr) >= 0) {
+            ++messages;
+        }
+        return messages;
+    }
+
+}
+
+TEST(ServerLoggerTest, BackpressureDropKeepsSpoolOrder) {
+    std::string queue_name = "/mp_os_server_logger_drop";
+    mqd_t receiver = create_unread_queue(queue_name);
+    ASSERT_NE(receiver, (mqd_t)-1);
+
+    backpressure settings;
+    settings.policy = backpressure_policy::drop;
+    settings.spool_capacity = 4;
+
+    server_logger_builder builder;
+    builder.add_file_stream(queue_name, logger::severity::information);
+    builder.set_backpressure(settings);
+    logger *logger_instance = builder.build();
+
+    // every short record is two packets: 5 fit into the queue, 2 into the spool
+    for (int i = 0; i < 100; ++i) {
+        logger_instance->information("record");
+    }
+    ASSERT_EQ(dynamic_cast<server_logger *>(logger_instance)->dropped_records(), 93);
+    ASSERT_EQ(drain_queue(receiver), 10);
+
+    // the spool goes out once there is room
+    delete logger_instance;
+    ASSERT_EQ(drain_queue(receiver), 4);
+
+    mq_close(receiver);
+    mq_unlink(queue_name.c_str());
+}
+
+TEST(ServerLoggerTest, BackpressureSpillsToFile) {
+    std::string queue_name = "/mp_os_server_logger_spill";
+    mqd_t receiver = create_unread_queue(queue_name);
+    ASSERT_NE(receiver, (mqd_t)-1);
+
+    std::string directory = std::filesystem::temp_directory_path() / "mp_os_spill_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    backpressure settings;
+    settings.policy = backpressure_policy::spill;
+    settings.spill_directory = directory;
+    settings.spool_capacity = 0;
+
+    server_logger_builder builder;
+    builder.add_file_stream(queue_name, logger::severity::information);
+    builder.set_backpressure(settings);
+    logger *logger_instance = builder.build();
+
+    for (int i = 0; i < 50; ++i) {
+        logger_instance->information("spilled " + std::to_string(i));
+    }
+    ASSERT_EQ(dynamic_cast<server_logger *>(logger_instance)->spilled_records(), 45);
+    ASSERT_EQ(dynamic_cast<server_logger *>(logger_instance)->dropped_records(), 0);
+    delete logger_instance;
+
+    std::ifstream spill(directory + "/mp_os_server_logger_spill.spill");
+    std::string line;
+    size_t lines = 0;
+    while (std::getline(spill, line)) {
+        ASSERT_TRUE(line.starts_with("[INFORMATION] pid "));
+        ASSERT_TRUE(line.ends_with(": spilled " + std::to_string(lines + 5)));
+        ++lines;
+    }
+    ASSERT_EQ(lines, 45);
+
+    mq_close(receiver);
+    mq_unlink(queue_name.c_str());
+    std::filesystem::remove_all(directory);
+}
+
+TEST(ServerLoggerTest, BackpressureBlocksUntilDeadline) {
+    std::string queue_name = "/mp_os_server_logger_deadline";
+    mqd_t receiver = create_unread_queue(queue_name);
+    ASSERT_NE(receiver, (mqd_t)-1);
+
+    backpressure settings;
+    settings.policy = backpressure_policy::block_until_deadline;
+    settings.deadline = std::chrono::milliseconds(20);
+    settings.spool_capacity = 0;
+
+    server_logger_builder builder;
+    builder.add_file_stream(queue_name, logger::severity::information);
+    builder.set_backpressure(settings);
+    logger *logger_instance = builder.build();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; ++i) {
+        logger_instance->information("record");
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ASSERT_EQ(dynamic_cast<server_logger *>(logger_instance)->dropped_records(), 5);
+    ASSERT_GE(elapsed, std::chrono::milliseconds(100));
+    ASSERT_LT(elapsed, std::chrono::seconds(2));
+    delete logger_instance;
+
+    mq_close(receiver);
+    mq_unlink(queue_name.c_str());
+}
+
+TEST(ServerLoggerTest, ReconfigureMovesSeveritiesBetweenQueues) {
+    std::string first_name = "/mp_os_server_logger_routes_first";
+    std::string second_name = "/mp_os_server_logger_routes_second";
+    mqd_t first = create_unread_queue(first_name);
+    mqd_t second = create_unread_queue(second_name);
+    ASSERT_NE(first, (mqd_t)-1);
+    ASSERT_NE(second, (mqd_t)-1);
+
+    server_logger_builder builder;
+    builder.add_file_stream(first_name, logger::severity::information);
+    logger *logger_instance = builder.build();
+    auto *reconfigurable = dynamic_cast<server_logger *>(logger_instance);
+
+    // every short record is two packets
+    logger_instance->information("record");
+    logger_instance->error("nowhere");
+    ASSERT_EQ(drain_queue(first), 2);
+
+    reconfigurable->reconfigure({ { second_name, { logger::severity::information, logger::severity::error } } });
+    ASSERT_TRUE(logger_instance->is_enabled(logger::severity::error));
+    logger_instance->information("record");
+    logger_instance->error("record");
+    ASSERT_EQ(drain_queue(first), 0);
+    ASSERT_EQ(drain_queue(second), 4);
+
+    // a queue nobody has created can't be opened, the routes stay
+    ASSERT_THROW(reconfigurable->reconfigure({ { "/mp_os_server_logger_missing", { logger::severity::information } } }), std::runtime_error);
+    logger_instance->information("record");
+    ASSERT_EQ(drain_queue(second), 2);
+    delete logger_instance;
+
+    mq_close(first);
+    mq_close(second);
+    mq_unlink(first_name.c_str());
+    mq_unlink(second_name.c_str());
+}
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();